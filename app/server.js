@@ -20,7 +20,8 @@ app.use((req, res, next) => {
   // Set CORS headers for local network access
   res.header('Access-Control-Allow-Origin', '*');
   res.header('Access-Control-Allow-Methods', 'GET, POST, PUT, DELETE, OPTIONS');
-  res.header('Access-Control-Allow-Headers', 'Content-Type');
+  res.header('Access-Control-Allow-Headers', 'Content-Type, If-None-Match');
+  res.header('Access-Control-Expose-Headers', 'ETag');
   
   // Service worker caching headers
   if (req.path === '/sw.js' || req.path === '/manifest.json') {
@@ -42,6 +43,13 @@ app.get('/sw.js', (req, res) => {
   res.type('application/javascript').sendFile(join(DIST_DIR, 'sw.js'));
 });
 
+// Last GET /api/config response per ESP32. Polls that carry no
+// If-None-Match of their own are revalidated with its ETag, and answered
+// from here when the ESP32 says 304, so an unchanged config is never
+// serialized or sent again by the device.
+const configCache = new Map();
+const CACHED_HEADERS = ['content-type', 'etag', 'cache-control'];
+
 // API proxy to ESP32
 app.use('/api', (req, res, next) => {
   const targetIp = req.headers['x-esp32-ip'];
@@ -56,6 +64,10 @@ app.use('/api', (req, res, next) => {
   const headers = { ...req.headers };
   delete headers.host;
 
+  const cacheable = req.method === 'GET' && req.path === '/config';
+  const cached = cacheable && !headers['if-none-match'] ? configCache.get(targetIp) : undefined;
+  if (cached) headers['if-none-match'] = cached.headers.etag;
+
   const proxyReq = http.request(
     {
       hostname: targetUrl.hostname,
@@ -65,6 +77,23 @@ app.use('/api', (req, res, next) => {
       headers
     },
     (proxyRes) => {
+      if (cached && proxyRes.statusCode === 304) {
+        proxyRes.resume();
+        res.status(200).set(cached.headers).send(cached.body);
+        return;
+      }
+      if (cacheable && proxyRes.statusCode === 200 && proxyRes.headers.etag) {
+        const chunks = [];
+        proxyRes.on('data', (chunk) => chunks.push(chunk));
+        proxyRes.on('end', () => {
+          const kept = {};
+          CACHED_HEADERS.forEach((key) => {
+            if (proxyRes.headers[key] !== undefined) kept[key] = proxyRes.headers[key];
+          });
+          configCache.set(targetIp, { headers: kept, body: Buffer.concat(chunks) });
+        });
+      }
+
       res.status(proxyRes.statusCode || 500);
       Object.entries(proxyRes.headers).forEach(([key, value]) => {
         if (value !== undefined) res.setHeader(key, value);
@@ -116,13 +145,14 @@ server.on('upgrade', async (request, socket, head) => {
       const WebSocket = (await import('ws')).default;
       const esp32Ws = new WebSocket(`ws://${esp32Ip}/ws`);
       
-      // Forward messages both ways
-      ws.on('message', (data) => {
-        if (esp32Ws.readyState === WebSocket.OPEN) esp32Ws.send(data);
+      // Forward messages both ways, keeping text and binary frames apart
+      // (binary telemetry frames must not arrive as text, nor JSON as binary)
+      ws.on('message', (data, isBinary) => {
+        if (esp32Ws.readyState === WebSocket.OPEN) esp32Ws.send(data, { binary: isBinary });
       });
       
-      esp32Ws.on('message', (data) => {
-        if (ws.readyState === WebSocket.OPEN) ws.send(data);
+      esp32Ws.on('message', (data, isBinary) => {
+        if (ws.readyState === WebSocket.OPEN) ws.send(data, { binary: isBinary });
       });
       
       // Handle disconnections
@@ -0,0 +1,199 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+// Minimal timing harness for the host benchmarks.
+//
+// A stage is timed in batches of consecutive calls; each batch yields one
+// ns/call sample, and p50/p99 are taken over those samples. Instruction
+// counts come from the Linux perf counter when it is available (it usually
+// is not inside containers), otherwise they are reported as null.
+//
+// Besides timings, a bench can record scalar metrics (accuracy, error,
+// lag...) per trace; they are reported alongside the stage results.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class InstructionCounter {
+private:
+  int fd = -1;
+
+public:
+  InstructionCounter() {
+#if defined(__linux__)
+    perf_event_attr attr = {};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~InstructionCounter() {
+#if defined(__linux__)
+    if (fd >= 0) close(fd);
+#endif
+  }
+
+  bool available() const { return fd >= 0; }
+
+  void start() {
+#if defined(__linux__)
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  uint64_t stop() {
+#if defined(__linux__)
+    if (fd < 0) return 0;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t count = 0;
+    if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) return 0;
+    return count;
+#else
+    return 0;
+#endif
+  }
+};
+
+struct BenchResult {
+  std::string stage;
+  std::string trace;
+  uint64_t calls = 0;
+  double nsPerCall = 0.0;
+  double p50Ns = 0.0;
+  double p99Ns = 0.0;
+  double instructionsPerCall = -1.0;  // < 0 when the counter is unavailable
+};
+
+struct BenchMetric {
+  std::string metric;
+  std::string trace;
+  double value = 0.0;
+};
+
+class BenchHarness {
+private:
+  static constexpr size_t BATCH = 64;
+  InstructionCounter instructions;
+  std::vector<BenchResult> results;
+  std::vector<BenchMetric> metrics;
+  double budgetNs;
+
+  static double percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+  }
+
+public:
+  explicit BenchHarness(double tickBudgetNs) : budgetNs(tickBudgetNs) {}
+
+  // Runs `reset()` before each repetition and `step(i)` for i in [0, count)
+  // `repetitions` times. Only step() is timed.
+  template<typename Reset, typename Step>
+  const BenchResult& run(const char* stage, const std::string& trace, size_t count, unsigned repetitions,
+                         Reset reset, Step step) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> samples;
+    samples.reserve(repetitions * (count / BATCH + 1));
+
+    double totalNs = 0.0;
+    uint64_t totalInstructions = 0;
+    uint64_t calls = 0;
+
+    for (unsigned rep = 0; rep < repetitions; rep++) {
+      reset();
+      for (size_t begin = 0; begin < count; begin += BATCH) {
+        size_t end = std::min(begin + BATCH, count);
+        instructions.start();
+        auto t0 = Clock::now();
+        for (size_t i = begin; i < end; i++) step(i);
+        auto t1 = Clock::now();
+        totalInstructions += instructions.stop();
+
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        samples.push_back(ns / (end - begin));
+        totalNs += ns;
+        calls += end - begin;
+      }
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.stage = stage;
+    result.trace = trace;
+    result.calls = calls;
+    result.nsPerCall = calls ? totalNs / calls : 0.0;
+    result.p50Ns = percentile(samples, 0.50);
+    result.p99Ns = percentile(samples, 0.99);
+    if (instructions.available() && calls) result.instructionsPerCall = (double)totalInstructions / calls;
+    results.push_back(result);
+    return results.back();
+  }
+
+  void record(const std::string& metric, const std::string& trace, double value) {
+    metrics.push_back({metric, trace, value});
+  }
+
+  void printSummary(FILE* out) const {
+    fprintf(out, "%-16s %-12s %10s %10s %10s %10s %9s\n", "stage", "trace", "ns/call", "p50", "p99", "instr", "budget%");
+    for (const BenchResult& r : results) {
+      char instr[16] = "n/a";
+      if (r.instructionsPerCall >= 0.0) snprintf(instr, sizeof(instr), "%.0f", r.instructionsPerCall);
+      fprintf(out, "%-16s %-12s %10.1f %10.1f %10.1f %10s %9.5f\n", r.stage.c_str(), r.trace.c_str(), r.nsPerCall,
+              r.p50Ns, r.p99Ns, instr, 100.0 * r.nsPerCall / budgetNs);
+    }
+    if (metrics.empty()) return;
+    fprintf(out, "\n%-36s %-12s %12s\n", "metric", "trace", "value");
+    for (const BenchMetric& m : metrics) {
+      fprintf(out, "%-36s %-12s %12.6g\n", m.metric.c_str(), m.trace.c_str(), m.value);
+    }
+  }
+
+  // Stable, diff-friendly JSON: one result per line, fixed key order.
+  void writeJson(FILE* out) const {
+    fprintf(out, "{\n  \"schema\": 2,\n  \"tick_budget_ns\": %.0f,\n  \"results\": [\n", budgetNs);
+    for (size_t i = 0; i < results.size(); i++) {
+      const BenchResult& r = results[i];
+      fprintf(out, "    {\"stage\": \"%s\", \"trace\": \"%s\", \"calls\": %llu, \"ns_per_call\": %.2f, "
+                   "\"p50_ns\": %.2f, \"p99_ns\": %.2f, \"instructions_per_call\": ",
+              r.stage.c_str(), r.trace.c_str(), (unsigned long long)r.calls, r.nsPerCall, r.p50Ns, r.p99Ns);
+      if (r.instructionsPerCall >= 0.0) fprintf(out, "%.1f", r.instructionsPerCall);
+      else fprintf(out, "null");
+      fprintf(out, ", \"budget_fraction\": %.8f}%s\n", r.nsPerCall / budgetNs, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"metrics\": [\n");
+    for (size_t i = 0; i < metrics.size(); i++) {
+      const BenchMetric& m = metrics[i];
+      fprintf(out, "    {\"metric\": \"%s\", \"trace\": \"%s\", \"value\": %.6g}%s\n", m.metric.c_str(),
+              m.trace.c_str(), m.value, i + 1 < metrics.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+  }
+};
+
+// Keeps benchmark results observable so the compiler cannot drop the work.
+template<typename T>
+inline void benchKeep(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif
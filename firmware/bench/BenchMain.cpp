@@ -0,0 +1,527 @@
+// Host microbenchmarks for the sensor-to-servo hot path.
+//
+//   pio run -e bench && .pio/build/bench/program [--json out.json] [--seconds S]
+//       [--repetitions R] [--trace-csv file.csv --trace-rate HZ]
+//
+// Each stage of the multi-rate pipeline is timed separately over fixed IMU
+// traces sampled at the IMU rate: SensorFusion::update (raw count
+// conversion, axis remap, atan2/sqrt) and the anti-aliasing Decimator per
+// IMU sample; SuspensionSimulator::update per control tick (also on an
+// 8-wheel chassis, and with the quarter-car model); ActuationPredictor and
+// MotionLimiter per control tick; PWMOutputs::setChannel per servo write through the compiled
+// calibration and commitFrame per latched four-servo frame (also through
+// the PCA9685 backend on the fake device); and one whole control tick end
+// to end. Fusion is timed for both
+// engines (complementary and Mahony). The fixed-point path (SUSPENSION_FIXED_POINT)
+// is timed stage by stage as well (the *_fixed stages) and checked against
+// the float one within the tolerances in FixedPoint.h. Synthetic traces also
+// report attitude and vertical acceleration error against the true motion,
+// and a roll step gives the rise time and overshoot of each suspension model.
+// The same traces are replayed into a lagging servo model to measure the
+// phase lag with and without prediction (see LatencyReplay.h), the servo
+// resolution is reported for each PWM frame rate, and the pulse overlap with
+// and without phase staggering.
+// The FastMath approximations are checked against libm on every run, the
+// compiled servo calibration against the direct math it replaces
+// (CalibrationCheck.h), the PCA9685 frames against the LEDC pulses
+// (Pca9685Check.h), the motion limiter's step, glitch and sine responses
+// against its limits (MotionLimiterCheck.h), the binary telemetry frames and
+// their per-client negotiation (TelemetryCheck.h), the JSON endpoints'
+// output and heap use per request against the handlers they replaced
+// (HttpCheck.h), and the /api/history ranges and overwrite handling
+// (HistoryCheck.h), and the exit status is non-zero if any of them or
+// the fixed-point path exceed their bounds. The JSON report goes to stdout
+// (or --json) and is meant to be diffed between commits; a human-readable
+// table goes to stderr.
+
+#include <Arduino.h>
+#include "Config.h"
+#include "SensorFusion.h"
+#include "SuspensionSimulator.h"
+#include "PWMOutputs.h"
+#include "Decimator.h"
+#include "StorageManager.h"
+#include "NativeHal.h"
+#include "BenchHarness.h"
+#include "ImuTraces.h"
+#include "MathAccuracy.h"
+#include "FixedPointCheck.h"
+#include "LatencyReplay.h"
+#include "CalibrationCheck.h"
+#include "Pca9685Check.h"
+#include "MotionLimiterCheck.h"
+#include "TelemetryCheck.h"
+#include "HttpCheck.h"
+#include "HistoryCheck.h"
+#include "ActuationPredictor.h"
+#include "MotionLimiter.h"
+
+namespace {
+
+struct FusedSample {
+  float roll, pitch, verticalAccel, rollRate, pitchRate;
+};
+
+struct CornerOutputs {
+  float fl, fr, rl, rr;
+};
+
+inline void fuseSample(SensorFusion& fusion, const ImuRawSample& s, float dt) {
+  fusion.update(s.ax / 16384.0f, s.ay / 16384.0f, s.az / 16384.0f,
+                s.gx / 131.0f, s.gy / 131.0f, s.gz / 131.0f, dt);
+}
+
+inline void pushFused(Decimator<5>& decimator, const SensorFusion& fusion) {
+  const float fused[5] = {fusion.getRoll(), fusion.getPitch(), fusion.getVerticalAcceleration(),
+                          fusion.getRollRate(), fusion.getPitchRate()};
+  decimator.push(fused);
+}
+
+// RMS roll/pitch error (degrees) of attitude estimates taken once per control
+// tick, against the trace's true attitude at the same instants
+struct AttitudeError {
+  double sumSquares = 0.0;
+  size_t count = 0;
+
+  void add(float roll, float pitch, const ImuTruth& truth) {
+    double dr = roll - truth.rollDeg;
+    double dp = pitch - truth.pitchDeg;
+    sumSquares += dr * dr + dp * dp;
+    count += 2;
+  }
+  double rms() const { return count ? sqrt(sumSquares / count) : 0.0; }
+};
+
+// RMS error (g) of the filtered vertical acceleration against the true
+// value passed through the same low-pass
+struct VerticalError {
+  double sumSquares = 0.0;
+  size_t count = 0;
+  float filteredTruth = 0.0f;
+
+  void step(float truthG, float dt) {
+    float beta = dt / (SensorFusion::VERTICAL_TIME_CONSTANT + dt);
+    filteredTruth += beta * (truthG - filteredTruth);
+  }
+  void add(float estimate) {
+    double d = estimate - filteredTruth;
+    sumSquares += d * d;
+    count++;
+  }
+  double rms() const { return count ? sqrt(sumSquares / count) : 0.0; }
+};
+
+const char* fusionModeName(uint8_t mode) {
+  return mode == FUSION_MAHONY ? "mahony" : "complementary";
+}
+
+void benchTrace(BenchHarness& harness, const ImuTrace& trace, unsigned repetitions,
+                const SuspensionConfig& config, const ServoConfig& servos) {
+  const size_t n = trace.samples.size();
+  const float imuDt = 1.0f / trace.sampleRateHz;
+  const uint32_t controlRateHz = config.sampleRate;
+  const size_t ratio = trace.sampleRateHz > controlRateHz ? trace.sampleRateHz / controlRateHz : 1;
+  const size_t ticks = n / ratio;
+
+  SensorFusion fusion;
+  Decimator<5> decimator;
+  SuspensionSimulator simulator;
+  ActuationPredictor predictor;
+  MotionLimiter limiter;
+  PWMOutputs pwm;
+  pwm.init();
+  pwm.configure(servos);
+  I2cBus bus(Wire);
+  Pca9685ServoBackend pcaBackend(bus);
+  PWMOutputs pca;
+  pca.init(pcaBackend);
+  pca.configure(servos);
+  predictor.configure(config, 1000000 * ratio / trace.sampleRateHz);
+  limiter.configure(servos, 1000000 * ratio / trace.sampleRateHz);
+
+  auto resetFusionMode = [&](uint8_t mode) {
+    fusion = SensorFusion();
+    fusion.setOrientation(config.mpuOrientation);
+    fusion.setMode(mode);
+    fusion.init(trace.sampleRateHz);
+    decimator = Decimator<5>();
+    decimator.init(trace.sampleRateHz, (float)trace.sampleRateHz / ratio);
+  };
+  auto resetFusion = [&]() { resetFusionMode(config.fusionMode); };
+
+  // Reference outputs for feeding the downstream stages in isolation, from
+  // the configured engine; the accuracy metrics cover both.
+  std::vector<FusedSample> fused(ticks);
+  std::vector<CornerOutputs> corners(ticks);
+  for (uint8_t mode : {(uint8_t)FUSION_COMPLEMENTARY, (uint8_t)FUSION_MAHONY}) {
+    AttitudeError attitudeError;
+    VerticalError verticalError;
+    resetFusionMode(mode);
+    simulator.init(config);
+    for (size_t t = 0; t < ticks; t++) {
+      for (size_t i = t * ratio; i < (t + 1) * ratio; i++) {
+        fuseSample(fusion, trace.samples[i], imuDt);
+        pushFused(decimator, fusion);
+        if (!trace.truth.empty()) verticalError.step(trace.truth[i].verticalG, imuDt);
+      }
+      if (!trace.truth.empty()) {
+        attitudeError.add(decimator.output(0), decimator.output(1), trace.truth[(t + 1) * ratio - 1]);
+        verticalError.add(fusion.getVerticalAcceleration());
+      }
+      if (mode != config.fusionMode) continue;
+      fused[t] = {decimator.output(0), decimator.output(1), decimator.output(2), decimator.output(3), decimator.output(4)};
+      simulator.update(fused[t].roll, fused[t].pitch, fused[t].verticalAccel);
+      corners[t] = {simulator.getFrontLeftOutput(), simulator.getFrontRightOutput(),
+                    simulator.getRearLeftOutput(), simulator.getRearRightOutput()};
+    }
+    if (!trace.truth.empty()) {
+      harness.record(std::string("attitude_rms_deg_") + fusionModeName(mode), trace.name, attitudeError.rms());
+      harness.record(std::string("vertical_rms_g_") + fusionModeName(mode), trace.name, verticalError.rms());
+    }
+  }
+
+  if (!trace.truth.empty()) {
+    // Baseline: the single-rate pipeline fused one sample per control tick
+    AttitudeError singleRateError;
+    SensorFusion single;
+    single.setOrientation(config.mpuOrientation);
+    single.init(controlRateHz);
+    for (size_t t = 0; t < ticks; t++) {
+      size_t i = (t + 1) * ratio - 1;
+      fuseSample(single, trace.samples[i], imuDt * ratio);
+      singleRateError.add(single.getRoll(), single.getPitch(), trace.truth[i]);
+    }
+    harness.record("attitude_rms_deg_single_rate", trace.name, singleRateError.rms());
+  }
+
+  harness.run("fusion", trace.name, n, repetitions, [&]() { resetFusionMode(FUSION_COMPLEMENTARY); }, [&](size_t i) {
+    fuseSample(fusion, trace.samples[i], imuDt);
+    benchKeep(fusion);
+  });
+
+  harness.run("fusion_mahony", trace.name, n, repetitions, [&]() { resetFusionMode(FUSION_MAHONY); }, [&](size_t i) {
+    fuseSample(fusion, trace.samples[i], imuDt);
+    benchKeep(fusion);
+  });
+
+  harness.run("decimator", trace.name, n, repetitions, resetFusion, [&](size_t i) {
+    const FusedSample& f = fused[i / ratio < ticks ? i / ratio : ticks - 1];
+    const float in[5] = {f.roll, f.pitch, f.verticalAccel, f.rollRate, f.pitchRate};
+    decimator.push(in);
+    benchKeep(decimator);
+  });
+
+  harness.run("simulator", trace.name, ticks, repetitions, [&]() { simulator.init(config); }, [&](size_t t) {
+    simulator.update(fused[t].roll, fused[t].pitch, fused[t].verticalAccel);
+    benchKeep(simulator);
+  });
+
+  // The quarter-car model (SIMULATION_QUARTER_CAR): `substeps` integrator
+  // steps per tick
+  SuspensionConfig quarterCar = config;
+  quarterCar.simulationMode = SIMULATION_QUARTER_CAR;
+  harness.run("simulator_qcar", trace.name, ticks, repetitions, [&]() { simulator.init(quarterCar); }, [&](size_t t) {
+    simulator.update(fused[t].roll, fused[t].pitch, fused[t].verticalAccel);
+    benchKeep(simulator);
+  });
+
+  // The same model on an 8-wheel chassis (the kernel cost doesn't depend on
+  // the corner count)
+  harness.run("simulator_8wheel", trace.name, ticks, repetitions, [&]() {
+    simulator.init(config);
+    simulator.setGeometry(SuspensionSimulator::chassisGeometry(8), 8);
+  }, [&](size_t t) {
+    simulator.update(fused[t].roll, fused[t].pitch, fused[t].verticalAccel);
+    benchKeep(simulator);
+  });
+
+  harness.run("predictor", trace.name, ticks, repetitions, [&]() { simulator.init(config); }, [&](size_t t) {
+    predictor.predict(simulator, fused[t].rollRate, fused[t].pitchRate);
+    benchKeep(predictor);
+  });
+
+  harness.run("limiter", trace.name, ticks, repetitions, [&]() { limiter.reset(config.rideHeightOffset); }, [&](size_t t) {
+    float commands[4] = {corners[t].fl, corners[t].fr, corners[t].rl, corners[t].rr};
+    limiter.limit(commands, 4);
+    benchKeep(commands);
+  });
+
+  harness.run("pwm", trace.name, ticks * 4, repetitions, []() {}, [&](size_t i) {
+    const CornerOutputs& c = corners[i >> 2];
+    const float angles[4] = {c.fl, c.fr, c.rl, c.rr};
+    uint8_t channel = i & 3;
+    pwm.setChannel(channel, angles[channel]);
+  });
+
+  // One control tick: every IMU sample since the last tick, then the model
+  // and servo writes at the control rate
+  harness.run("pwm_frame", trace.name, ticks, repetitions, []() {}, [&](size_t t) {
+    const float angles[4] = {corners[t].fl, corners[t].fr, corners[t].rl, corners[t].rr};
+    pwm.commitFrame(angles);
+  });
+
+  harness.run("pwm_frame_pca9685", trace.name, ticks, repetitions, []() {}, [&](size_t t) {
+    const float angles[PWMOutputs::MAX_CHANNELS] = {corners[t].fl, corners[t].fr, corners[t].rl, corners[t].rr};
+    pca.commitFrame(angles);
+  });
+
+  harness.run("tick", trace.name, ticks, repetitions, [&]() {
+    resetFusion();
+    simulator.init(config);
+    limiter.reset(config.rideHeightOffset);
+  }, [&](size_t t) {
+    for (size_t i = t * ratio; i < (t + 1) * ratio; i++) {
+      fuseSample(fusion, trace.samples[i], imuDt);
+      pushFused(decimator, fusion);
+    }
+    simulator.update(decimator.output(0), decimator.output(1), decimator.output(2));
+    predictor.predict(simulator, decimator.output(3), decimator.output(4));
+    float commands[4] = {predictor.getOutput(0), predictor.getOutput(1), predictor.getOutput(2), predictor.getOutput(3)};
+    limiter.limit(commands, 4);
+    pwm.commitFrame(commands);
+  });
+
+  // The same stages on the fixed-point path (SUSPENSION_FIXED_POINT,
+  // complementary engine), fed the same inputs
+  const int32_t imuDtUs = 1000000 / trace.sampleRateHz;
+  std::vector<fixedPoint::q16_t> fusedQ(ticks * 5), cornersQ(ticks * 4);
+  for (size_t t = 0; t < ticks; t++) {
+    const float f[5] = {fused[t].roll, fused[t].pitch, fused[t].verticalAccel, fused[t].rollRate, fused[t].pitchRate};
+    const float c[4] = {corners[t].fl, corners[t].fr, corners[t].rl, corners[t].rr};
+    for (size_t k = 0; k < 5; k++) fusedQ[t * 5 + k] = fixedPoint::fromFloat(f[k]);
+    for (size_t k = 0; k < 4; k++) cornersQ[t * 4 + k] = fixedPoint::fromFloat(c[k]);
+  }
+  FixedDecimator<5> fixedDecimator;
+  auto resetFixed = [&]() {
+    resetFusionMode(FUSION_COMPLEMENTARY);
+    fixedDecimator = FixedDecimator<5>();
+    fixedDecimator.init(trace.sampleRateHz, (float)trace.sampleRateHz / ratio);
+  };
+  auto fuseFixed = [&](size_t i) {
+    const ImuRawSample& s = trace.samples[i];
+    fusion.updateFixed(s.ax, s.ay, s.az, s.gx, s.gy, s.gz, imuDtUs);
+  };
+
+  harness.run("fusion_fixed", trace.name, n, repetitions, resetFixed, [&](size_t i) {
+    fuseFixed(i);
+    benchKeep(fusion);
+  });
+
+  harness.run("decimator_fixed", trace.name, n, repetitions, resetFixed, [&](size_t i) {
+    size_t t = i / ratio < ticks ? i / ratio : ticks - 1;
+    fixedDecimator.push(&fusedQ[t * 5]);
+    benchKeep(fixedDecimator);
+  });
+
+  harness.run("simulator_fixed", trace.name, ticks, repetitions, [&]() { simulator.init(config); }, [&](size_t t) {
+    simulator.updateFixed(fusedQ[t * 5], fusedQ[t * 5 + 1], fusedQ[t * 5 + 2]);
+    benchKeep(simulator);
+  });
+
+  harness.run("simulator_qcar_fixed", trace.name, ticks, repetitions, [&]() { simulator.init(quarterCar); }, [&](size_t t) {
+    simulator.updateFixed(fusedQ[t * 5], fusedQ[t * 5 + 1], fusedQ[t * 5 + 2]);
+    benchKeep(simulator);
+  });
+
+  harness.run("predictor_fixed", trace.name, ticks, repetitions, [&]() { simulator.init(config); }, [&](size_t t) {
+    predictor.predictFixed(simulator, fusedQ[t * 5 + 3], fusedQ[t * 5 + 4]);
+    benchKeep(predictor);
+  });
+
+  harness.run("limiter_fixed", trace.name, ticks, repetitions, [&]() { limiter.reset(config.rideHeightOffset); }, [&](size_t t) {
+    fixedPoint::q16_t commands[4] = {cornersQ[t * 4], cornersQ[t * 4 + 1], cornersQ[t * 4 + 2], cornersQ[t * 4 + 3]};
+    limiter.limitFixed(commands, 4);
+    benchKeep(commands);
+  });
+
+  harness.run("pwm_fixed", trace.name, ticks * 4, repetitions, []() {}, [&](size_t i) {
+    uint8_t channel = i & 3;
+    pwm.setChannelFixed(channel, cornersQ[i]);
+  });
+
+  harness.run("pwm_frame_fixed", trace.name, ticks, repetitions, []() {}, [&](size_t t) {
+    pwm.commitFrameFixed(&cornersQ[t * 4]);
+  });
+
+  harness.run("tick_fixed", trace.name, ticks, repetitions, [&]() {
+    resetFixed();
+    simulator.init(config);
+    limiter.reset(config.rideHeightOffset);
+  }, [&](size_t t) {
+    for (size_t i = t * ratio; i < (t + 1) * ratio; i++) {
+      fuseFixed(i);
+      const fixedPoint::q16_t in[5] = {fusion.getRollQ16(), fusion.getPitchQ16(), fusion.getVerticalAccelerationQ16(),
+                                       fusion.getRollRateQ16(), fusion.getPitchRateQ16()};
+      fixedDecimator.push(in);
+    }
+    simulator.updateFixed(fixedDecimator.output(0), fixedDecimator.output(1), fixedDecimator.output(2));
+    predictor.predictFixed(simulator, fixedDecimator.output(3), fixedDecimator.output(4));
+    fixedPoint::q16_t commands[4] = {predictor.getOutputQ16(0), predictor.getOutputQ16(1),
+                                     predictor.getOutputQ16(2), predictor.getOutputQ16(3)};
+    limiter.limitFixed(commands, 4);
+    pwm.commitFrameFixed(commands);
+  });
+}
+
+// Response of the front-left corner to a 10 degree roll step, per suspension
+// model: 10-90% rise time and overshoot past the final position
+void stepResponse(BenchHarness& harness, const SuspensionConfig& config) {
+  const float STEP_DEG = 10.0f;
+  const uint32_t ticks = config.sampleRate * 2;
+  for (uint8_t mode : {(uint8_t)SIMULATION_KINEMATIC, (uint8_t)SIMULATION_QUARTER_CAR}) {
+    SuspensionConfig cfg = config;
+    cfg.simulationMode = mode;
+    SuspensionSimulator simulator;
+    simulator.init(cfg);
+    const float start = simulator.getFrontLeftOutput();
+    std::vector<float> response(ticks);
+    for (uint32_t t = 0; t < ticks; t++) {
+      simulator.update(STEP_DEG, 0.0f, 0.0f);
+      response[t] = simulator.getFrontLeftOutput() - start;
+    }
+    const float final = response.back();
+    int rise10 = -1, rise90 = -1;
+    float peak = 0.0f;
+    for (uint32_t t = 0; t < ticks; t++) {
+      if (rise10 < 0 && response[t] >= 0.1f * final) rise10 = t;
+      if (rise90 < 0 && response[t] >= 0.9f * final) rise90 = t;
+      peak = fmaxf(peak, response[t]);
+    }
+    const char* name = mode == SIMULATION_QUARTER_CAR ? "quarter_car" : "kinematic";
+    harness.record(std::string("step_rise_ms_") + name, "roll_step", 1000.0 * (rise90 - rise10) / cfg.sampleRate);
+    harness.record(std::string("step_overshoot_pct_") + name, "roll_step", final != 0.0f ? 100.0 * (peak - final) / final : 0.0);
+  }
+}
+
+// Servo resolution at each frame rate: degrees per LEDC count, from a fine
+// sweep of the whole travel
+void pwmResolution(BenchHarness& harness) {
+  for (uint16_t hz : {(uint16_t)PWM_FREQ, (uint16_t)PWM_MAX_FREQ}) {
+    PWMOutputs pwm;
+    pwm.init();
+    pwm.setCalibration(0, {0, 0, 180, false, hz, 0, 0});
+    uint32_t steps = 0, lastDuty = 0;
+    for (int i = 0; i <= 180000; i++) {
+      pwm.setChannel(0, i * 0.001f);
+      uint32_t duty = nativeHal::ledcDuty(LedcServoBackend::ledcChannel(0));
+      if (i > 0 && duty != lastDuty) steps++;
+      lastDuty = duty;
+    }
+    harness.record("pwm_degrees_per_count", std::to_string(hz) + "hz", steps ? 180.0 / steps : 0.0);
+  }
+}
+
+// Supply load from the servo pulses at 50 Hz: the most pulses high at once
+// over a frame, and the closest two pulses start, with every servo at full
+// travel (longest pulse) and the pulses all starting together or staggered
+void pwmStagger(BenchHarness& harness) {
+  for (uint16_t staggerUs : {(uint16_t)0, (uint16_t)SERVO_PHASE_STAGGER_US}) {
+    PWMOutputs pwm;
+    pwm.init();
+    pwm.setPhaseStagger(staggerUs);
+    const float angles[LedcServoBackend::CHANNELS] = {180.0f, 180.0f, 180.0f, 180.0f};
+    pwm.commitFrame(angles);
+
+    uint32_t start[LedcServoBackend::CHANNELS], end[LedcServoBackend::CHANNELS];
+    for (uint8_t i = 0; i < LedcServoBackend::CHANNELS; i++) {
+      start[i] = nativeHal::ledcHpoint(LedcServoBackend::ledcChannel(i));
+      end[i] = start[i] + nativeHal::ledcDuty(LedcServoBackend::ledcChannel(i));
+    }
+    uint32_t peak = 0, closestUs = UINT32_MAX;
+    const double usPerCount = 1e6 / PWM_FREQ / (1UL << PWM_RESOLUTION_BITS);
+    for (uint8_t i = 0; i < LedcServoBackend::CHANNELS; i++) {
+      uint32_t high = 0;  // Pulses high when pulse i starts
+      for (uint8_t j = 0; j < LedcServoBackend::CHANNELS; j++) {
+        if (start[j] <= start[i] && start[i] < end[j]) high++;
+        if (j != i) {
+          uint32_t gap = start[i] > start[j] ? start[i] - start[j] : start[j] - start[i];
+          uint32_t gapUs = (uint32_t)(gap * usPerCount + 0.5);
+          closestUs = gapUs < closestUs ? gapUs : closestUs;
+        }
+      }
+      peak = high > peak ? high : peak;
+    }
+    const std::string name = staggerUs ? "staggered" : "aligned";
+    harness.record("pwm_peak_concurrent_pulses", name, peak);
+    harness.record("pwm_min_pulse_spacing_us", name, closestUs);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* jsonPath = nullptr;
+  const char* csvPath = nullptr;
+  uint32_t csvRate = IMU_SAMPLE_RATE_HZ;
+  float seconds = 60.0f;
+  unsigned repetitions = 50;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--json") && i + 1 < argc) jsonPath = argv[++i];
+    else if (!strcmp(argv[i], "--trace-csv") && i + 1 < argc) csvPath = argv[++i];
+    else if (!strcmp(argv[i], "--trace-rate") && i + 1 < argc) csvRate = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = strtof(argv[++i], nullptr);
+    else if (!strcmp(argv[i], "--repetitions") && i + 1 < argc) repetitions = strtoul(argv[++i], nullptr, 10);
+    else {
+      fprintf(stderr, "usage: %s [--json out.json] [--seconds S] [--repetitions R] "
+                      "[--trace-csv file.csv --trace-rate HZ]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  nativeHal::setSerialEnabled(false);
+
+  // Bench against the same defaults the firmware boots with.
+  StorageManager storage;
+  storage.init();
+  SuspensionConfig config = storage.getConfig();
+  ServoConfig servos = storage.getServoConfig();
+
+  std::vector<ImuTrace> traces;
+  if (csvPath) {
+    ImuTrace trace;
+    if (!imuTraces::loadCsv(csvPath, csvRate, trace)) {
+      fprintf(stderr, "could not read trace %s\n", csvPath);
+      return 1;
+    }
+    traces.push_back(trace);
+  } else {
+    traces.push_back(imuTraces::level(IMU_SAMPLE_RATE_HZ, seconds));
+    traces.push_back(imuTraces::sweep(IMU_SAMPLE_RATE_HZ, seconds));
+    traces.push_back(imuTraces::rough(IMU_SAMPLE_RATE_HZ, seconds));
+    traces.push_back(imuTraces::biased(IMU_SAMPLE_RATE_HZ, seconds));
+  }
+
+  BenchHarness harness(1e9 / SUSPENSION_SAMPLE_RATE_HZ);
+  bool fixedOk = fixedPointCheck::checkAtan2(harness);
+  for (const ImuTrace& trace : traces) {
+    benchTrace(harness, trace, repetitions, config, servos);
+    fixedOk &= fixedPointCheck::comparePaths(harness, trace, config, servos);
+    SuspensionConfig quarterCar = config;
+    quarterCar.simulationMode = SIMULATION_QUARTER_CAR;
+    fixedOk &= fixedPointCheck::comparePaths(harness, trace, quarterCar, servos, "fixed_vs_float_qcar");
+  }
+  stepResponse(harness, config);
+  pwmResolution(harness);
+  pwmStagger(harness);
+  for (const ImuTrace& trace : traces) latencyReplay::evaluate(harness, trace, config);
+  bool mathOk = mathAccuracy::checkFastMath(harness, repetitions);
+  bool calibrationOk = calibrationCheck::checkEquivalence(harness);
+  bool pca9685Ok = pca9685Check::checkFrames(harness, servos);
+  bool limiterOk = motionLimiterCheck::checkProfiles(harness, config.sampleRate);
+  bool telemetryOk = telemetryCheck::checkFrames(harness, repetitions);
+  telemetryOk &= telemetryCheck::checkBandLimits(harness);
+  bool httpOk = httpCheck::checkResponses(harness, repetitions);
+  bool historyOk = historyCheck::checkStreams(harness, repetitions);
+
+  harness.printSummary(stderr);
+
+  FILE* out = stdout;
+  if (jsonPath && !(out = fopen(jsonPath, "w"))) {
+    fprintf(stderr, "could not write %s\n", jsonPath);
+    return 1;
+  }
+  harness.writeJson(out);
+  if (out != stdout) fclose(out);
+  return mathOk && fixedOk && calibrationOk && pca9685Ok && limiterOk && telemetryOk && httpOk && historyOk ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#ifndef CALIBRATION_CHECK_H
+#define CALIBRATION_CHECK_H
+
+// Equivalence of PWMOutputs' compiled servo calibration with the direct
+// math it replaces: trim, clamp to the limits, mirror if reversed, then
+// angle -> pulse -> LEDC counts on every write.
+//
+// Sweeps trims, limits, both directions and both frame rates over angles
+// beyond either end of the travel, for the float and Q16.16 writes, and
+// records the largest duty difference. Fails if any differs by more than
+// one count (the two forms round differently exactly at half a count).
+
+#include <cmath>
+#include <cstdlib>
+#include "BenchHarness.h"
+#include "Config.h"
+#include "FixedPoint.h"
+#include "PWMOutputs.h"
+#include "NativeHal.h"
+
+namespace calibrationCheck {
+
+constexpr int32_t MAX_DIFFERENCE_COUNTS = 1;
+
+inline float countsPerMicrosecond(uint16_t hz) {
+  return (float)(1UL << PWM_RESOLUTION_BITS) * hz / 1e6f;
+}
+
+inline uint32_t referenceDuty(float angle, const ServoCalibration& cal) {
+  const float minPulse = SERVO_MIN_PULSE_US * countsPerMicrosecond(cal.refreshHz);
+  const float maxPulse = SERVO_MAX_PULSE_US * countsPerMicrosecond(cal.refreshHz);
+  angle += cal.trim;
+  angle = constrain(angle, (float)cal.minLimit, (float)cal.maxLimit);
+  if (cal.reversed) angle = 180.0f - angle;
+  float counts = minPulse + angle * (maxPulse - minPulse) / 180.0f;
+  counts = constrain(counts, minPulse, maxPulse);
+  return (uint32_t)(counts + 0.5f);
+}
+
+inline uint32_t referenceDutyFixed(fixedPoint::q16_t angle, const ServoCalibration& cal) {
+  const float minPulse = SERVO_MIN_PULSE_US * countsPerMicrosecond(cal.refreshHz);
+  const float maxPulse = SERVO_MAX_PULSE_US * countsPerMicrosecond(cal.refreshHz);
+  angle += fixedPoint::fromInt(cal.trim);
+  angle = fixedPoint::clamp(angle, fixedPoint::fromInt(cal.minLimit), fixedPoint::fromInt(cal.maxLimit));
+  if (cal.reversed) angle = fixedPoint::fromInt(180) - angle;
+  int64_t counts = fixedPoint::fromFloat(minPulse) + (((int64_t)angle * fixedPoint::fromFloat((maxPulse - minPulse) / 180.0f)) >> 16);
+  int32_t duty = (int32_t)((counts + (fixedPoint::ONE >> 1)) >> fixedPoint::FRACTION_BITS);
+  int32_t minDuty = (int32_t)(minPulse + 0.5f), maxDuty = (int32_t)(maxPulse + 0.5f);
+  return (uint32_t)(duty < minDuty ? minDuty : (duty > maxDuty ? maxDuty : duty));
+}
+
+inline bool checkEquivalence(BenchHarness& harness) {
+  PWMOutputs pwm;
+  pwm.init();
+  const uint8_t ledc = LedcServoBackend::ledcChannel(0);
+
+  int32_t maxDifference = 0, maxDifferenceFixed = 0;
+  uint64_t writes = 0, mismatches = 0, mismatchesFixed = 0;
+  for (uint16_t hz : {(uint16_t)PWM_FREQ, (uint16_t)PWM_MAX_FREQ}) {
+    for (int trim = -45; trim <= 45; trim += 3) {
+      for (int minLimit = 0; minLimit <= 90; minLimit += 10) {
+        for (int maxLimit = 90; maxLimit <= 180; maxLimit += 10) {
+          for (bool reversed : {false, true}) {
+            const ServoCalibration cal = {(int8_t)trim, (uint8_t)minLimit, (uint8_t)maxLimit, reversed, hz, 0, 0};
+            pwm.setCalibration(0, cal);
+            for (float angle = -20.0f; angle <= 200.0f; angle += 0.25f) {
+              pwm.setChannel(0, angle);
+              int32_t difference = abs((int32_t)nativeHal::ledcDuty(ledc) - (int32_t)referenceDuty(angle, cal));
+              maxDifference = difference > maxDifference ? difference : maxDifference;
+              if (difference) mismatches++;
+
+              const fixedPoint::q16_t angleQ = fixedPoint::fromFloat(angle);
+              pwm.setChannelFixed(0, angleQ);
+              difference = abs((int32_t)nativeHal::ledcDuty(ledc) - (int32_t)referenceDutyFixed(angleQ, cal));
+              maxDifferenceFixed = difference > maxDifferenceFixed ? difference : maxDifferenceFixed;
+              if (difference) mismatchesFixed++;
+              writes++;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  harness.record("calibration_duty_max_diff_counts", "float", maxDifference);
+  harness.record("calibration_duty_mismatch_frac", "float", writes ? (double)mismatches / writes : 0.0);
+  harness.record("calibration_duty_max_diff_counts", "fixed", maxDifferenceFixed);
+  harness.record("calibration_duty_mismatch_frac", "fixed", writes ? (double)mismatchesFixed / writes : 0.0);
+
+  bool ok = maxDifference <= MAX_DIFFERENCE_COUNTS && maxDifferenceFixed <= MAX_DIFFERENCE_COUNTS;
+  if (!ok) {
+    fprintf(stderr, "Servo calibration check FAILED: %d counts (float), %d counts (fixed)\n", (int)maxDifference,
+            (int)maxDifferenceFixed);
+  }
+  return ok;
+}
+
+}  // namespace calibrationCheck
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef FIXED_POINT_CHECK_H
+#define FIXED_POINT_CHECK_H
+
+// Agreement between the fixed-point control path (SUSPENSION_FIXED_POINT)
+// and the float one.
+//
+// checkAtan2() sweeps the CORDIC atan2 (and its magnitude output) over the
+// whole circle at radii from 1000 counts to the top of its input range.
+// comparePaths() replays a trace through both pipelines side by side,
+// complementary fusion through decimation, suspension model, predictor,
+// motion limiter and PWM duty,
+// from identical start states, and records the largest difference at each
+// stage. Both return false if a
+// difference exceeds the tolerance documented in FixedPoint.h, which fails
+// the bench run.
+
+#include <cmath>
+#include <cstdlib>
+#include "BenchHarness.h"
+#include "ImuTraces.h"
+#include "Config.h"
+#include "FixedPoint.h"
+#include "SensorFusion.h"
+#include "Decimator.h"
+#include "SuspensionSimulator.h"
+#include "ActuationPredictor.h"
+#include "MotionLimiter.h"
+#include "PWMOutputs.h"
+#include "NativeHal.h"
+
+namespace fixedPointCheck {
+
+inline bool checkAtan2(BenchHarness& harness) {
+  const int ANGLE_STEPS = 1 << 16;
+  const double radii[] = {1000.0, 4000.0, 16384.0, 40000.0, 1048575.0};
+
+  double maxError = 0.0, magnitudeError = 0.0;
+  for (int i = 0; i <= ANGLE_STEPS; i++) {
+    double theta = -M_PI + 2.0 * M_PI * i / ANGLE_STEPS;
+    for (double r : radii) {
+      int32_t y = (int32_t)lround(r * sin(theta)), x = (int32_t)lround(r * cos(theta));
+      int32_t magnitude;
+      double e = fabs(fixedPoint::toFloat(fixedPoint::atan2Deg(y, x, &magnitude)) - atan2((double)y, (double)x) * 180.0 / M_PI);
+      maxError = fmax(maxError, e > 180.0 ? 360.0 - e : e);
+      magnitudeError = fmax(magnitudeError, fabs(magnitude / hypot((double)x, (double)y) - 1.0));
+    }
+  }
+  harness.record("fixedpoint_atan2_max_err_deg", "math", maxError);
+  harness.record("fixedpoint_magnitude_max_rel_err", "math", magnitudeError);
+
+  bool ok = maxError <= fixedPoint::ATAN2_MAX_ERROR_DEG && magnitudeError <= fixedPoint::MAGNITUDE_MAX_RELATIVE_ERROR &&
+            fixedPoint::atan2Deg(0, 0) == 0;
+  if (!ok) fprintf(stderr, "Fixed-point atan2 check FAILED: %.3g deg, magnitude %.3g\n", maxError, magnitudeError);
+  return ok;
+}
+
+// `prefix` names the metrics, so the comparison can be repeated for each
+// suspension model (config.simulationMode)
+inline bool comparePaths(BenchHarness& harness, const ImuTrace& trace, const SuspensionConfig& config,
+                         const ServoConfig& servos, const std::string& prefix = "fixed_vs_float") {
+  const uint32_t controlRateHz = config.sampleRate;
+  const size_t ratio = trace.sampleRateHz > controlRateHz ? trace.sampleRateHz / controlRateHz : 1;
+  const size_t ticks = trace.samples.size() / ratio;
+  const int32_t imuDtUs = 1000000 / trace.sampleRateHz;
+
+  SensorFusion floatFusion, fixedFusion;
+  Decimator<5> floatDecimator;
+  FixedDecimator<5> fixedDecimator;
+  SuspensionSimulator floatSimulator, fixedSimulator;
+  ActuationPredictor floatPredictor, fixedPredictor;
+  MotionLimiter floatLimiter, fixedLimiter;
+  PWMOutputs pwm;
+  for (SensorFusion* fusion : {&floatFusion, &fixedFusion}) {
+    fusion->setOrientation(config.mpuOrientation);
+    fusion->setMode(FUSION_COMPLEMENTARY);
+    fusion->init(trace.sampleRateHz);
+  }
+  floatDecimator.init(trace.sampleRateHz, (float)trace.sampleRateHz / ratio);
+  fixedDecimator.init(trace.sampleRateHz, (float)trace.sampleRateHz / ratio);
+  floatSimulator.init(config);
+  fixedSimulator.init(config);
+  floatPredictor.configure(config, 1000000 * ratio / trace.sampleRateHz);
+  fixedPredictor.configure(config, 1000000 * ratio / trace.sampleRateHz);
+  for (MotionLimiter* limiter : {&floatLimiter, &fixedLimiter}) {
+    limiter->configure(servos, 1000000 * ratio / trace.sampleRateHz);
+    limiter->reset(config.rideHeightOffset);
+  }
+  pwm.init();
+  pwm.configure(servos);
+
+  double attitudeError = 0.0, verticalError = 0.0, cornerError = 0.0, commandError = 0.0, limitedError = 0.0;
+  int32_t dutyError = 0;
+  size_t dutyMismatches = 0;
+  for (size_t t = 0; t < ticks; t++) {
+    for (size_t i = t * ratio; i < (t + 1) * ratio; i++) {
+      const ImuRawSample& s = trace.samples[i];
+      floatFusion.update(s.ax / 16384.0f, s.ay / 16384.0f, s.az / 16384.0f,
+                         s.gx / 131.0f, s.gy / 131.0f, s.gz / 131.0f, imuDtUs * 1e-6f);
+      fixedFusion.updateFixed(s.ax, s.ay, s.az, s.gx, s.gy, s.gz, imuDtUs);
+      const float floatFused[5] = {floatFusion.getRoll(), floatFusion.getPitch(), floatFusion.getVerticalAcceleration(),
+                                   floatFusion.getRollRate(), floatFusion.getPitchRate()};
+      const fixedPoint::q16_t fixedFused[5] = {fixedFusion.getRollQ16(), fixedFusion.getPitchQ16(),
+                                               fixedFusion.getVerticalAccelerationQ16(),
+                                               fixedFusion.getRollRateQ16(), fixedFusion.getPitchRateQ16()};
+      floatDecimator.push(floatFused);
+      fixedDecimator.push(fixedFused);
+    }
+    for (int c = 0; c < 2; c++) {
+      attitudeError = fmax(attitudeError, fabs(floatDecimator.output(c) - fixedPoint::toFloat(fixedDecimator.output(c))));
+    }
+    verticalError = fmax(verticalError, fabs(floatDecimator.output(2) - fixedPoint::toFloat(fixedDecimator.output(2))));
+
+    floatSimulator.update(floatDecimator.output(0), floatDecimator.output(1), floatDecimator.output(2));
+    fixedSimulator.updateFixed(fixedDecimator.output(0), fixedDecimator.output(1), fixedDecimator.output(2));
+    floatPredictor.predict(floatSimulator, floatDecimator.output(3), floatDecimator.output(4));
+    fixedPredictor.predictFixed(fixedSimulator, fixedDecimator.output(3), fixedDecimator.output(4));
+    float floatCommands[4];
+    fixedPoint::q16_t fixedCommands[4];
+    for (uint8_t channel = 0; channel < 4; channel++) {
+      cornerError = fmax(cornerError, fabs(floatSimulator.getOutput(channel) - fixedPoint::toFloat(fixedSimulator.getOutputQ16(channel))));
+      floatCommands[channel] = floatPredictor.getOutput(channel);
+      fixedCommands[channel] = fixedPredictor.getOutputQ16(channel);
+      commandError = fmax(commandError, fabs(floatCommands[channel] - fixedPoint::toFloat(fixedCommands[channel])));
+    }
+    floatLimiter.limit(floatCommands, 4);
+    fixedLimiter.limitFixed(fixedCommands, 4);
+    for (uint8_t channel = 0; channel < 4; channel++) {
+      limitedError = fmax(limitedError, fabs(floatCommands[channel] - fixedPoint::toFloat(fixedCommands[channel])));
+      pwm.setChannel(channel, floatCommands[channel]);
+      int32_t floatDuty = (int32_t)nativeHal::ledcDuty(LedcServoBackend::ledcChannel(channel));
+      pwm.setChannelFixed(channel, fixedCommands[channel]);
+      int32_t difference = abs((int32_t)nativeHal::ledcDuty(LedcServoBackend::ledcChannel(channel)) - floatDuty);
+      dutyError = difference > dutyError ? difference : dutyError;
+      if (difference) dutyMismatches++;
+    }
+  }
+
+  harness.record(prefix + "_attitude_max_deg", trace.name, attitudeError);
+  harness.record(prefix + "_vertical_max_g", trace.name, verticalError);
+  harness.record(prefix + "_corner_max_deg", trace.name, cornerError);
+  harness.record(prefix + "_command_max_deg", trace.name, commandError);
+  harness.record(prefix + "_limited_max_deg", trace.name, limitedError);
+  harness.record(prefix + "_duty_max_counts", trace.name, dutyError);
+  harness.record(prefix + "_duty_mismatch_frac", trace.name, ticks ? (double)dutyMismatches / (ticks * 4) : 0.0);
+
+  bool ok = attitudeError <= fixedPoint::ATTITUDE_TOLERANCE_DEG && verticalError <= fixedPoint::VERTICAL_TOLERANCE_G &&
+            cornerError <= fixedPoint::CORNER_TOLERANCE_DEG && commandError <= fixedPoint::CORNER_TOLERANCE_DEG &&
+            limitedError <= fixedPoint::CORNER_TOLERANCE_DEG && dutyError <= fixedPoint::DUTY_TOLERANCE_COUNTS;
+  if (!ok) {
+    fprintf(stderr, "Fixed-point path check (%s) FAILED on %s: attitude %.3g deg, vertical %.3g g, corner %.3g deg, "
+                    "command %.3g deg, limited %.3g deg, duty %d counts\n",
+            prefix.c_str(), trace.name.c_str(), attitudeError, verticalError, cornerError, commandError, limitedError, (int)dutyError);
+  }
+  return ok;
+}
+
+}  // namespace fixedPointCheck
+
+#endif
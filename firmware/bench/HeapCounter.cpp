@@ -0,0 +1,55 @@
+// Global operator new/delete replacements that feed heapCounter (see
+// HeapCounter.h). Counting is off outside start()/stop(), and the bench is
+// single-threaded.
+
+#include <new>
+#include "HeapCounter.h"
+
+namespace heapCounter {
+
+namespace {
+bool counting = false;
+Totals totals = {0, 0};
+}  // namespace
+
+void start() {
+  totals = {0, 0};
+  counting = true;
+}
+
+Totals stop() {
+  counting = false;
+  return totals;
+}
+
+void record(size_t bytes) {
+  if (!counting) return;
+  totals.bytes += bytes;
+  totals.allocations++;
+}
+
+}  // namespace heapCounter
+
+void* operator new(size_t size) {
+  heapCounter::record(size);
+  if (void* pointer = malloc(size ? size : 1)) return pointer;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  heapCounter::record(size);
+  return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { free(pointer); }
@@ -0,0 +1,41 @@
+#ifndef HEAP_COUNTER_H
+#define HEAP_COUNTER_H
+
+// Heap allocations made between start() and stop(), counted by the global
+// operator new replacements in HeapCounter.cpp (std::string, and so the host
+// String, std::function, new'd objects) and by Allocator for ArduinoJson
+// documents built with it. realloc is counted as a fresh allocation of the
+// new size, which is what a growing buffer costs on a fragmented heap.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ArduinoJson.h>
+
+namespace heapCounter {
+
+struct Totals {
+  uint64_t bytes;
+  uint64_t allocations;
+};
+
+void start();
+Totals stop();
+void record(size_t bytes);
+
+class Allocator : public ArduinoJson::Allocator {
+public:
+  void* allocate(size_t size) override {
+    record(size);
+    return malloc(size);
+  }
+  void deallocate(void* pointer) override { free(pointer); }
+  void* reallocate(void* pointer, size_t size) override {
+    record(size);
+    return realloc(pointer, size);
+  }
+};
+
+}  // namespace heapCounter
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef HISTORY_CHECK_H
+#define HISTORY_CHECK_H
+
+// Control loop history: record layout, GET /api/history ranges, and reads
+// racing the writer.
+//
+// checkStreams() records more ticks than HISTORY_CAPACITY into a
+// TelemetryHistory, each filled from its tick number, and fetches
+// /api/history through WebServerManager's routes with several ?since=
+// values. It decodes the body with an independent little-endian reader and
+// checks the header, that every record matches its sequence number, and
+// that the range is the one asked for (everything still held, a recent
+// tail, nothing, or the oldest held after a since that was overwritten).
+// The same stream is read in odd chunk sizes, and with the writer lapping
+// the ring between reads, where records must be skipped, never torn or out
+// of order. Three turns of yaw from either fusion engine must be recorded
+// as a heading within +/-180 degrees, not a saturated value. It records
+// the RAM held, the bytes per record, and the time to record one tick and
+// to stream the full history. Any failure fails the bench run.
+
+#include <cstring>
+#include <string>
+#include "BenchHarness.h"
+#include "SensorFusion.h"
+#include "TelemetryHistory.h"
+#include "WebServer.h"
+
+namespace historyCheck {
+
+inline uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+inline uint32_t readU32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Every field derived from the tick number, so any record can be checked
+// on its own
+inline HistorySample sampleFor(uint32_t tick) {
+  HistorySample sample;
+  sample.timestampUs = tick * 20000u;
+  sample.flags = tick % 7 ? telemetryFrame::FLAG_IMU_ONLINE : 0;
+  for (int i = 0; i < 6; i++) sample.imu[i] = (int16_t)(tick * 31 + i * 1000 - 16000);
+  for (int i = 0; i < 3; i++) sample.attitude[i] = (int16_t)((int)(tick % 36000) - 18000 + i);
+  sample.verticalAccel = (int16_t)(1000 - (int)(tick % 2000));
+  for (int i = 0; i < 4; i++) {
+    sample.targets[i] = (int16_t)(9000 + (tick + i) % 9000);
+    sample.outputs[i] = (int16_t)(9000 - (tick + i) % 9000);
+  }
+  return sample;
+}
+
+inline bool recordMatches(const uint8_t* p, uint32_t sequence, const uint16_t* batteries) {
+  const HistorySample expected = sampleFor(sequence);
+  bool ok = readU32(p) == sequence && readU32(p + 4) == expected.timestampUs && readU16(p + 8) == expected.flags;
+  for (int i = 0; i < 6; i++) ok &= (int16_t)readU16(p + 10 + 2 * i) == expected.imu[i];
+  for (int i = 0; i < 3; i++) ok &= (int16_t)readU16(p + 22 + 2 * i) == expected.attitude[i];
+  ok &= (int16_t)readU16(p + 28) == expected.verticalAccel;
+  for (int i = 0; i < 4; i++) ok &= (int16_t)readU16(p + 30 + 2 * i) == expected.targets[i];
+  for (int i = 0; i < 4; i++) ok &= (int16_t)readU16(p + 38 + 2 * i) == expected.outputs[i];
+  for (int i = 0; i < 3; i++) ok &= readU16(p + 46 + 2 * i) == batteries[i];
+  return ok;
+}
+
+// Decode a body: header fields, then records strictly increasing and each
+// matching its sequence number. Returns the number of records (-1: invalid).
+inline long decode(const std::string& body, uint32_t& first, uint32_t& latest, uint32_t& lowest, uint32_t& highest,
+                   const uint16_t* batteries, bool& gaps) {
+  const uint8_t* p = (const uint8_t*)body.data();
+  if (body.size() < TelemetryHistory::HEADER_SIZE || p[0] != telemetryFrame::VERSION ||
+      p[1] != telemetryFrame::MESSAGE_HISTORY || readU16(p + 2) != TelemetryHistory::RECORD_SIZE ||
+      (body.size() - TelemetryHistory::HEADER_SIZE) % TelemetryHistory::RECORD_SIZE != 0) {
+    return -1;
+  }
+  first = readU32(p + 4);
+  latest = readU32(p + 8);
+  const long count = (long)((body.size() - TelemetryHistory::HEADER_SIZE) / TelemetryHistory::RECORD_SIZE);
+  lowest = highest = 0;
+  gaps = false;
+  for (long i = 0; i < count; i++) {
+    const uint8_t* record = p + TelemetryHistory::HEADER_SIZE + i * TelemetryHistory::RECORD_SIZE;
+    const uint32_t sequence = readU32(record);
+    if (!recordMatches(record, sequence, batteries) || (i > 0 && sequence <= highest) || sequence > latest) return -1;
+    gaps |= i > 0 && sequence != highest + 1;
+    if (i == 0) lowest = sequence;
+    highest = sequence;
+  }
+  if (count > 0 && first != lowest) return -1;
+  return count;
+}
+
+inline std::string fetch(WebServerManager& web, const char* since) {
+  AsyncWebServerRequest request(HTTP_GET, "/api/history");
+  if (since) request.addParam("since", since);
+  web.handleRequest(request);
+  if (request.responseCode != 200 || request.responseType != "application/octet-stream") return std::string();
+  return request.responseBody.str();
+}
+
+inline bool checkStreams(BenchHarness& harness, unsigned repetitions) {
+  static TelemetryHistory history;
+  StorageManager storage;
+  storage.init();
+  WebServerManager web;
+  web.init(storage, history);
+  bool ok = true;
+
+  // No ticks yet: a header and nothing else
+  uint32_t first, latest, lowest, highest;
+  bool gaps;
+  const uint16_t batteries[3] = {12610, 7400, 0};
+  ok &= decode(fetch(web, nullptr), first, latest, lowest, highest, batteries, gaps) == 0 && first == 0 && latest == 0;
+
+  // A lap and a half of ticks; only the newest HISTORY_CAPACITY are held
+  history.setBatteries(12.61f, 7.4f, 0.0f);
+  const uint32_t TICKS = HISTORY_CAPACITY * 3 / 2;
+  for (uint32_t tick = 1; tick <= TICKS; tick++) {
+    HistorySample sample = sampleFor(tick);
+    ok &= history.record(sample) == tick;
+  }
+  const uint32_t oldest = TICKS - HISTORY_CAPACITY + 1;
+  ok &= history.latestSequence() == TICKS && history.oldestSequence() == oldest;
+
+  struct Range {
+    const char* since;
+    uint32_t first;
+    long count;
+  };
+  const std::string tail = std::to_string(TICKS - 10);
+  const std::string newest = std::to_string(TICKS);
+  const Range ranges[] = {
+    {nullptr, oldest, HISTORY_CAPACITY},      // Everything still held
+    {"0", oldest, HISTORY_CAPACITY},
+    {"5", oldest, HISTORY_CAPACITY},          // Overwritten: starts at the oldest held
+    {tail.c_str(), TICKS - 9, 10},            // A client catching up
+    {newest.c_str(), 0, 0},                   // Up to date
+    {"4294967295", 0, 0},
+  };
+  std::string full;
+  for (const Range& range : ranges) {
+    const std::string body = fetch(web, range.since);
+    const long count = decode(body, first, latest, lowest, highest, batteries, gaps);
+    ok &= count == range.count && first == range.first && latest == TICKS && !gaps;
+    ok &= count == 0 || highest == TICKS;
+    if (!range.since) full = body;
+  }
+
+  // The newest tick also answers /api/sensors
+  AsyncWebServerRequest sensors(HTTP_GET, "/api/sensors");
+  web.handleRequest(sensors);
+  const HistorySample newestSample = sampleFor(TICKS);
+  char expected[32];
+  snprintf(expected, sizeof(expected), "{\"roll\":%.1f,", newestSample.attitude[0] * 0.01f);
+  ok &= sensors.responseBody.startsWith(newestSample.flags ? expected : "{\"roll\":null,");
+
+  // Any chunk size gives the same bytes
+  for (size_t chunk : {1u, 7u, 51u, 53u, 1436u}) {
+    TelemetryHistory::Stream stream = history.stream(0);
+    std::string body;
+    uint8_t buffer[1436];
+    for (size_t count; (count = stream.read(buffer, chunk)) > 0;) body.append((const char*)buffer, count);
+    ok &= body == full;
+  }
+
+  // The writer laps the reader mid-stream: the overwritten records are
+  // skipped, the rest arrive whole and in order, and nothing newer than the
+  // request is sent
+  {
+    TelemetryHistory::Stream stream = history.stream(0);
+    std::string body;
+    uint8_t buffer[100];
+    size_t count = stream.read(buffer, sizeof(buffer));  // Header and part of the first record
+    body.append((const char*)buffer, count);
+    for (uint32_t tick = TICKS + 1; tick <= TICKS + HISTORY_CAPACITY / 2; tick++) {
+      HistorySample sample = sampleFor(tick);
+      history.record(sample);
+    }
+    while ((count = stream.read(buffer, sizeof(buffer))) > 0) body.append((const char*)buffer, count);
+    const long records = decode(body, first, latest, lowest, highest, batteries, gaps);
+    ok &= records > 0 && gaps && latest == TICKS && highest == TICKS;
+    ok &= records == (long)(HISTORY_CAPACITY / 2 + 2);  // Two records in flight, then the oldest still held
+    harness.record("history_lapped_records_skipped", "half_lap", (double)(HISTORY_CAPACITY - records));
+  }
+
+  // Spinning at 180 deg/s for three turns: the stored heading stays wrapped
+  // (int16 centidegrees saturate past +/-327 degrees)
+  for (uint8_t mode : {FUSION_COMPLEMENTARY, FUSION_MAHONY}) {
+    SensorFusion fusion;
+    fusion.setMode(mode);
+    fusion.init(IMU_SAMPLE_RATE_HZ);
+    bool wrapped = true;
+    for (uint32_t i = 0; i < 6 * IMU_SAMPLE_RATE_HZ; i++) {
+      fusion.updateRaw(0, 0, SensorFusion::ACCEL_COUNTS_PER_G, 0, 0, (int16_t)(180 * SensorFusion::GYRO_COUNTS_PER_DPS),
+                       1000000 / IMU_SAMPLE_RATE_HZ);
+      const int16_t yaw = TelemetryHistory::centiDegrees(fusion.getYaw());
+      wrapped &= yaw >= -18000 && yaw <= 18000;
+    }
+    ok &= wrapped;
+  }
+
+  harness.record("history_ram_bytes", "capacity_" + std::to_string(HISTORY_CAPACITY), (double)sizeof(TelemetryHistory));
+  harness.record("history_bytes_per_record", "binary", (double)TelemetryHistory::RECORD_SIZE);
+  harness.record("history_response_bytes", "full", (double)full.size());
+
+  HistorySample sample = sampleFor(1);
+  harness.run("history_record", "tick", 1000, repetitions, []() {}, [&](size_t i) {
+    sample.timestampUs = i;
+    benchKeep(history.record(sample));
+  });
+  harness.run("history_stream", "full", 20, repetitions, []() {}, [&](size_t) {
+    TelemetryHistory::Stream stream = history.stream(0);
+    uint8_t segment[AsyncWebServerRequest::SEGMENT_SIZE];
+    size_t bytes = 0;
+    for (size_t count; (count = stream.read(segment, sizeof(segment))) > 0;) bytes += count;
+    benchKeep(bytes);
+  });
+
+  if (!ok) fprintf(stderr, "History check FAILED: /api/history layout, ranges, chunking, overwrite handling or yaw wrapping incorrect\n");
+  return ok;
+}
+
+}  // namespace historyCheck
+
+#endif
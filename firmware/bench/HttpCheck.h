@@ -0,0 +1,365 @@
+#ifndef HTTP_CHECK_H
+#define HTTP_CHECK_H
+
+// HTTP JSON endpoints: heap use, output and conditional GET.
+//
+// checkResponses() serves GET /api/sensors and GET /api/config through
+// WebServerManager's routes, and through copies of the handlers they
+// replace (String concatenation for /api/sensors; three ArduinoJson
+// documents serialized to Strings, parsed back and merged for /api/config).
+// It records the heap bytes and allocations per request of each, counted
+// by HeapCounter, and the time per request. It returns false if a response
+// is not valid JSON, /api/sensors differs from the old output, a battery
+// name is not escaped, an offline IMU does not read as null, /api/config
+// does not fit HTTP_RESPONSE_BUFFER_SIZE, a request beyond
+// HTTP_RESPONSE_BUFFERS in flight is not refused with 503 or the buffers
+// are not returned afterwards, /api/sensors allocates as much as before,
+// the heap a response takes grows with its size, a current ETag does not
+// get 304 or a stale one does, a multi-field update moves the config
+// version more than once, or WebSocket clients are not told the new
+// config version (at most twice for a burst of changes), which fails the
+// bench run.
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <ArduinoJson.h>
+#include "BenchHarness.h"
+#include "HeapCounter.h"
+#include "StorageManager.h"
+#include "WebServer.h"
+
+namespace httpCheck {
+
+// Minimal validator: one JSON value spanning the whole text
+class JsonValidator {
+private:
+  const char* p;
+
+  void skipSpace() {
+    while (isspace((unsigned char)*p)) p++;
+  }
+
+  bool literal(const char* word) {
+    const size_t length = strlen(word);
+    if (strncmp(p, word, length) != 0) return false;
+    p += length;
+    return true;
+  }
+
+  bool string() {
+    if (*p++ != '"') return false;
+    while (*p && *p != '"') {
+      if ((unsigned char)*p < 0x20) return false;
+      if (*p == '\\') {
+        p++;
+        if (*p == 'u') {
+          for (int i = 1; i <= 4; i++) {
+            if (!isxdigit((unsigned char)p[i])) return false;
+          }
+          p += 4;
+        } else if (!strchr("\"\\/bfnrt", *p) || !*p) {
+          return false;
+        }
+      }
+      p++;
+    }
+    return *p++ == '"';
+  }
+
+  bool number() {
+    char* end;
+    strtod(p, &end);
+    if (end == p || *p == '+' || *p == '.' || !strncmp(p, "nan", 3) || !strncmp(p, "inf", 3)) return false;
+    p = end;
+    return true;
+  }
+
+  bool value() {
+    skipSpace();
+    if (*p == '{' || *p == '[') {
+      const char close = *p == '{' ? '}' : ']';
+      const bool object = *p++ == '{';
+      skipSpace();
+      if (*p == close) return p++, true;
+      while (true) {
+        if (object) {
+          skipSpace();
+          if (!string()) return false;
+          skipSpace();
+          if (*p++ != ':') return false;
+        }
+        if (!value()) return false;
+        skipSpace();
+        if (*p == close) return p++, true;
+        if (*p++ != ',') return false;
+      }
+    }
+    if (*p == '"') return string();
+    if (literal("true") || literal("false") || literal("null")) return true;
+    return number();
+  }
+
+public:
+  bool check(const char* text) {
+    p = text;
+    if (!value()) return false;
+    skipSpace();
+    return *p == '\0';
+  }
+};
+
+inline bool validJson(const String& text) {
+  JsonValidator validator;
+  return validator.check(text.c_str());
+}
+
+// GET /api/sensors as served before JsonWriter
+inline void legacySensors(AsyncWebServerRequest* request, const float* values) {
+  String json = "{\"roll\":" + String(values[0], 1) +
+                ",\"pitch\":" + String(values[1], 1) +
+                ",\"yaw\":" + String(values[2], 1) +
+                ",\"verticalAccel\":" + String(values[3], 2) +
+                ",\"batteries\":[" + String(values[4], 2) + "," +
+                String(values[5], 2) + "," + String(values[6], 2) + "]}";
+  request->send(200, "application/json", json);
+}
+
+// GET /api/config as served before JsonWriter: StorageManager serialized
+// the system, servo and battery config into three Strings, which the
+// handler parsed back, merged and serialized again
+inline void legacyConfig(AsyncWebServerRequest* request, const StorageManager& storage,
+                         ArduinoJson::Allocator* allocator) {
+  const SuspensionConfig config = storage.getConfig();
+  const ServoConfig servoConfig = storage.getServoConfig();
+  const BatteriesConfig batteryConfig = storage.getBatteryConfig();
+
+  String configJson, servoConfigJson, batteryConfigJson;
+  {
+    JsonDocument doc(allocator);
+    doc["reactionSpeed"] = config.reactionSpeed;
+    doc["rideHeightOffset"] = config.rideHeightOffset;
+    doc["rangeLimit"] = config.rangeLimit;
+    doc["damping"] = config.damping;
+    doc["frontRearBalance"] = config.frontRearBalance;
+    doc["stiffness"] = config.stiffness;
+    doc["sampleRate"] = config.sampleRate;
+    doc["mpuOrientation"] = config.mpuOrientation;
+    doc["mountRollTrim"] = config.mountRollTrim;
+    doc["mountPitchTrim"] = config.mountPitchTrim;
+    doc["mountYawTrim"] = config.mountYawTrim;
+    doc["fusionMode"] = config.fusionMode;
+    doc["simulationMode"] = config.simulationMode;
+    doc["servoLatencyMs"] = config.servoLatencyMs;
+    doc["servoTimeConstantMs"] = config.servoTimeConstantMs;
+    doc["predictionGain"] = config.predictionGain;
+    serializeJson(doc, configJson);
+  }
+  {
+    JsonDocument doc(allocator);
+    const char* names[4] = {"frontLeft", "frontRight", "rearLeft", "rearRight"};
+    const ServoCalibration* servos[4] = {&servoConfig.frontLeft, &servoConfig.frontRight,
+                                         &servoConfig.rearLeft, &servoConfig.rearRight};
+    for (int i = 0; i < 4; i++) {
+      JsonObject servo = doc[names[i]].to<JsonObject>();
+      servo["trim"] = servos[i]->trim;
+      servo["min"] = servos[i]->minLimit;
+      servo["max"] = servos[i]->maxLimit;
+      servo["reversed"] = servos[i]->reversed;
+      servo["refreshHz"] = servos[i]->refreshHz;
+      servo["maxVelocity"] = servos[i]->maxVelocity;
+      servo["maxAcceleration"] = servos[i]->maxAcceleration;
+    }
+    serializeJson(doc, servoConfigJson);
+  }
+  {
+    JsonDocument doc(allocator);
+    JsonArray batteries = doc["batteries"].to<JsonArray>();
+    for (const BatteryConfig* battery : {&batteryConfig.battery1, &batteryConfig.battery2, &batteryConfig.battery3}) {
+      JsonObject entry = batteries.add<JsonObject>();
+      entry["name"] = battery->name;
+      entry["cellCount"] = battery->cellCount;
+      entry["plugAssignment"] = battery->plugAssignment;
+      entry["showOnDashboard"] = battery->showOnDashboard;
+    }
+    serializeJson(doc, batteryConfigJson);
+  }
+
+  JsonDocument doc(allocator);
+  if (!deserializeJson(doc, configJson)) {
+    JsonDocument servoDoc(allocator);
+    if (!deserializeJson(servoDoc, servoConfigJson)) doc["servos"] = servoDoc;
+    JsonDocument batteryDoc(allocator);
+    if (!deserializeJson(batteryDoc, batteryConfigJson)) doc["batteries"] = batteryDoc["batteries"];
+  }
+  String combinedJson;
+  serializeJson(doc, combinedJson);
+  request->send(200, "application/json", combinedJson);
+}
+
+struct Served {
+  int code;
+  String body;
+  String etag;
+  heapCounter::Totals heap;
+};
+
+// Heap use of one request, excluding the capture of the response on the
+// host request object
+template<typename Handler>
+inline Served serve(const char* url, Handler handle, const char* ifNoneMatch = nullptr) {
+  AsyncWebServerRequest request(HTTP_GET, url);
+  if (ifNoneMatch) request.addRequestHeader("If-None-Match", ifNoneMatch);
+  request.responseType.reserve(32);
+  request.responseBody.reserve(HTTP_RESPONSE_BUFFER_SIZE);
+  heapCounter::start();
+  handle(request);
+  const heapCounter::Totals heap = heapCounter::stop();
+  const AsyncWebHeader* etag = request.responseHeader("ETag");
+  return {request.responseCode, request.responseBody, etag ? etag->value() : String(), heap};
+}
+
+inline bool checkResponses(BenchHarness& harness, unsigned repetitions) {
+  StorageManager storage;
+  storage.init();
+  storage.updateBatteryParameter(1, "name", "Main \"4S\"\\");
+  static TelemetryHistory history;
+  WebServerManager web;
+  web.init(storage, history);
+  const float sensors[7] = {-12.34f, 5.66f, 179.95f, 1.024f, 12.61f, 7.4f, 0.0f};
+  HistorySample sample = {};
+  sample.flags = telemetryFrame::FLAG_IMU_ONLINE;
+  for (int i = 0; i < 3; i++) sample.attitude[i] = TelemetryHistory::centiDegrees(sensors[i]);
+  sample.verticalAccel = TelemetryHistory::milliG(sensors[3]);
+  history.setBatteries(sensors[4], sensors[5], sensors[6]);
+  history.record(sample);
+  heapCounter::Allocator jsonAllocator;
+
+  auto route = [&](AsyncWebServerRequest& request) { web.handleRequest(request); };
+  const Served sensorsNew = serve("/api/sensors", route);
+  const Served sensorsOld = serve("/api/sensors", [&](AsyncWebServerRequest& request) {
+    legacySensors(&request, sensors);
+  });
+  const Served configNew = serve("/api/config", route);
+  const Served configOld = serve("/api/config", [&](AsyncWebServerRequest& request) {
+    legacyConfig(&request, storage, &jsonAllocator);
+  });
+
+  const Served configCurrent = serve("/api/config", route, configNew.etag.c_str());
+
+  const Served* results[5] = {&sensorsOld, &sensorsNew, &configOld, &configNew, &configCurrent};
+  const char* names[5] = {"sensors_legacy", "sensors", "config_legacy", "config", "config_not_modified"};
+  for (int i = 0; i < 5; i++) {
+    harness.record("http_heap_bytes_per_request", names[i], (double)results[i]->heap.bytes);
+    harness.record("http_heap_allocations_per_request", names[i], (double)results[i]->heap.allocations);
+  }
+  harness.record("http_response_bytes", "config", configNew.body.length());
+
+  bool ok = sensorsNew.code == 200 && configNew.code == 200;
+  ok &= validJson(sensorsNew.body) && validJson(configNew.body);
+  ok &= sensorsNew.body == sensorsOld.body;
+  ok &= configNew.body.indexOf("\"name\":\"Main \\\"4S\\\"\\\\\"") >= 0;
+  ok &= configNew.body.indexOf("\"servos\":{\"frontLeft\":{\"trim\":") >= 0;
+  ok &= configNew.body.length() < HTTP_RESPONSE_BUFFER_SIZE;
+  ok &= sensorsNew.heap.bytes < sensorsOld.heap.bytes;
+
+  // What is left is ESPAsyncWebServer's response object and its headers,
+  // the same for any response size
+  storage.updateBatteryParameter(2, "name", "A battery name of 31 characters");
+  storage.updateBatteryParameter(3, "name", "A battery name of 31 characters");
+  const Served configLong = serve("/api/config", route);
+  ok &= configLong.code == 200 && configLong.body.length() > configNew.body.length();
+  ok &= configLong.heap.bytes == configNew.heap.bytes && configLong.heap.allocations == configNew.heap.allocations;
+
+  // Conditional GET: the ETag follows the config version, a current copy
+  // (also as a weak tag or in a list) gets 304 with no body, and any
+  // change makes the old tag stale
+  ok &= configNew.etag.length() > 2 && configNew.etag.startsWith("\"") && configNew.etag != configLong.etag;
+  ok &= configCurrent.code == 304 && configCurrent.body.length() == 0 && configCurrent.etag == configNew.etag;
+  ok &= configCurrent.heap.bytes < configNew.heap.bytes;
+  const String weakList = "\"0-0\", W/" + configLong.etag;
+  ok &= serve("/api/config", route, weakList.c_str()).code == 304;
+  ok &= serve("/api/config", route, "*").code == 304;
+  storage.updateParameter("damping", 0.7f);
+  const Served configChanged = serve("/api/config", route, configLong.etag.c_str());
+  ok &= configChanged.code == 200 && configChanged.etag != configLong.etag && validJson(configChanged.body);
+
+  // A POST /api/config with several fields is one change: applied together
+  // and published once, so the version (and ETag) moves by one
+  const uint32_t versionBefore = storage.getConfigVersion();
+  const StorageManager::ParameterUpdate updates[3] = {{"damping", 0.6f}, {"stiffness", 1.2f}, {"reactionSpeed", 2.0f}};
+  storage.updateParameters(updates, 3);
+  const SuspensionConfig applied = storage.getConfig();
+  ok &= storage.getConfigVersion() == versionBefore + 1;
+  ok &= applied.damping == 0.6f && applied.stiffness == 1.2f && applied.reactionSpeed == 2.0f;
+
+  // The version is pushed to WebSocket clients on connect and after
+  // changes, a burst of changes coalesced into one or two messages
+  AsyncWebSocketClient* client = web.connectClient();
+  String expected = "{\"type\":\"config\",\"version\":" + String(storage.getConfigVersion()) + ",\"etag\":";
+  ok &= String(client->lastMessage.c_str()).startsWith(expected);
+  const uint64_t messagesBefore = client->messagesReceived;
+  for (uint32_t ms = 0; ms < 1000; ms += SERVICE_TASK_PERIOD_MS) {
+    if (ms < 200) storage.updateParameter("damping", 0.5f + ms * 1e-3f);  // A slider drag
+    web.serviceConfigVersion(1000000 + ms);
+  }
+  const uint64_t announcements = client->messagesReceived - messagesBefore;
+  harness.record("config_announcements", "slider_drag_200ms", (double)announcements);
+  expected = "{\"type\":\"config\",\"version\":" + String(storage.getConfigVersion()) + ",\"etag\":";
+  ok &= announcements >= 1 && announcements <= 2 && String(client->lastMessage.c_str()).startsWith(expected);
+
+  // IMU offline: the attitude must read as null
+  HistorySample offlineSample = sample;
+  offlineSample.flags = 0;
+  history.record(offlineSample);
+  const Served offline = serve("/api/sensors", route);
+  ok &= validJson(offline.body) && offline.body.startsWith("{\"roll\":null,");
+  history.record(sample);
+
+  // Requests still being sent hold their buffers; one more gets 503
+  AsyncWebServerRequest* inFlight[HTTP_RESPONSE_BUFFERS];
+  for (auto& request : inFlight) {
+    request = new AsyncWebServerRequest(HTTP_GET, "/api/config");
+    web.handleRequest(*request);
+    ok &= request->responseCode == 200;
+  }
+  ok &= serve("/api/config", route).code == 503;
+  for (auto* request : inFlight) delete request;
+  ok &= serve("/api/config", route).code == 200;
+
+  harness.run("http_sensors", "legacy", 100, repetitions, []() {}, [&](size_t) {
+    AsyncWebServerRequest request(HTTP_GET, "/api/sensors");
+    legacySensors(&request, sensors);
+    benchKeep(request.responseBody.length());
+  });
+  harness.run("http_sensors", "writer", 100, repetitions, []() {}, [&](size_t) {
+    AsyncWebServerRequest request(HTTP_GET, "/api/sensors");
+    web.handleRequest(request);
+    benchKeep(request.responseBody.length());
+  });
+  harness.run("http_config", "legacy", 100, repetitions, []() {}, [&](size_t) {
+    AsyncWebServerRequest request(HTTP_GET, "/api/config");
+    legacyConfig(&request, storage, &jsonAllocator);
+    benchKeep(request.responseBody.length());
+  });
+  harness.run("http_config", "writer", 100, repetitions, []() {}, [&](size_t) {
+    AsyncWebServerRequest request(HTTP_GET, "/api/config");
+    web.handleRequest(request);
+    benchKeep(request.responseBody.length());
+  });
+  const String currentETag = serve("/api/config", route).etag;
+  harness.run("http_config", "not_modified", 100, repetitions, []() {}, [&](size_t) {
+    AsyncWebServerRequest request(HTTP_GET, "/api/config");
+    request.addRequestHeader("If-None-Match", currentETag);
+    web.handleRequest(request);
+    benchKeep(request.responseCode);
+  });
+
+  if (!ok) fprintf(stderr, "HTTP check FAILED: JSON responses, conditional GET, config announcements, response buffers or heap use incorrect\n");
+  return ok;
+}
+
+}  // namespace httpCheck
+
+#endif
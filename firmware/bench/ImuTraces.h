@@ -0,0 +1,152 @@
+#ifndef IMU_TRACES_H
+#define IMU_TRACES_H
+
+// Fixed IMU traces for the host benchmarks.
+//
+// Traces are generated from a fixed seed so every run (and every commit)
+// replays exactly the same raw MPU6050 samples. A recorded trace can also be
+// loaded from CSV: one sample per line, "ax,ay,az,gx,gy,gz" in raw counts.
+// Synthetic traces also carry the true attitude for accuracy metrics.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct ImuRawSample {
+  int16_t ax, ay, az, gx, gy, gz;
+};
+
+struct ImuTruth {
+  float rollDeg, pitchDeg;
+  float verticalG;  // World-frame vertical acceleration, gravity removed
+};
+
+struct ImuTrace {
+  std::string name;
+  uint32_t sampleRateHz = 0;
+  std::vector<ImuRawSample> samples;
+  std::vector<ImuTruth> truth;  // Empty for recorded traces
+};
+
+namespace imuTraces {
+
+constexpr float ACCEL_LSB_PER_G = 16384.0f;
+constexpr float GYRO_LSB_PER_DPS = 131.0f;
+constexpr float DEG2RAD = 0.017453292519943295f;
+
+// Deterministic noise so traces are bit-identical across hosts.
+class Lcg {
+private:
+  uint32_t state;
+
+public:
+  explicit Lcg(uint32_t seed) : state(seed) {}
+  float next() {  // uniform in [-1, 1)
+    state = state * 1664525u + 1013904223u;
+    return (float)(state >> 8) / 8388608.0f - 1.0f;
+  }
+};
+
+inline int16_t toCounts(float value, float scale) {
+  float counts = value * scale;
+  if (counts > 32767.0f) counts = 32767.0f;
+  if (counts < -32768.0f) counts = -32768.0f;
+  return (int16_t)lrintf(counts);
+}
+
+// Builds a trace from body attitude functions (degrees) plus noise and a
+// vertical disturbance (g). Rates are differentiated numerically. Axes are
+// the MPU6050's (right-handed, z up): nose-up pitch shows as +ax and as a
+// negative rotation rate about y.
+template<typename Roll, typename Pitch, typename Vertical>
+ImuTrace synthesize(const char* name, uint32_t rateHz, float seconds, uint32_t seed, float accelNoiseG,
+                    float gyroNoiseDps, Roll rollDeg, Pitch pitchDeg, Vertical verticalG, float gyroBiasDps = 0.0f) {
+  ImuTrace trace;
+  trace.name = name;
+  trace.sampleRateHz = rateHz;
+
+  Lcg noise(seed);
+  const float dt = 1.0f / rateHz;
+  const size_t count = (size_t)(seconds * rateHz);
+  trace.samples.reserve(count);
+  trace.truth.reserve(count);
+
+  for (size_t i = 0; i < count; i++) {
+    float t = i * dt;
+    float roll = rollDeg(t) * DEG2RAD;
+    float pitch = pitchDeg(t) * DEG2RAD;
+    float rollRate = (rollDeg(t + dt) - rollDeg(t)) / dt;
+    float pitchRate = (pitchDeg(t + dt) - pitchDeg(t)) / dt;
+    float g = 1.0f + verticalG(t);
+
+    ImuRawSample s;
+    s.ax = toCounts(sinf(pitch) * g + accelNoiseG * noise.next(), ACCEL_LSB_PER_G);
+    s.ay = toCounts(cosf(pitch) * sinf(roll) * g + accelNoiseG * noise.next(), ACCEL_LSB_PER_G);
+    s.az = toCounts(cosf(pitch) * cosf(roll) * g + accelNoiseG * noise.next(), ACCEL_LSB_PER_G);
+    s.gx = toCounts(rollRate + gyroBiasDps + gyroNoiseDps * noise.next(), GYRO_LSB_PER_DPS);
+    s.gy = toCounts(-pitchRate - gyroBiasDps + gyroNoiseDps * noise.next(), GYRO_LSB_PER_DPS);
+    s.gz = toCounts(gyroBiasDps + gyroNoiseDps * noise.next(), GYRO_LSB_PER_DPS);
+    trace.samples.push_back(s);
+    trace.truth.push_back({rollDeg(t), pitchDeg(t), verticalG(t)});
+  }
+  return trace;
+}
+
+// Parked vehicle: sensor noise only.
+inline ImuTrace level(uint32_t rateHz, float seconds) {
+  return synthesize("level", rateHz, seconds, 1, 0.01f, 0.2f,
+                    [](float) { return 0.0f; },
+                    [](float) { return 0.0f; },
+                    [](float) { return 0.0f; });
+}
+
+// Slow body roll/pitch sweep, as when driving over gentle terrain.
+inline ImuTrace sweep(uint32_t rateHz, float seconds) {
+  return synthesize("sweep", rateHz, seconds, 2, 0.01f, 0.2f,
+                    [](float t) { return 10.0f * sinf(2.0f * (float)M_PI * 0.5f * t); },
+                    [](float t) { return 6.0f * sinf(2.0f * (float)M_PI * 0.3f * t); },
+                    [](float) { return 0.0f; });
+}
+
+// The sweep again with an uncalibrated gyro: 2 deg/s bias on every axis.
+inline ImuTrace biased(uint32_t rateHz, float seconds) {
+  return synthesize("biased", rateHz, seconds, 4, 0.01f, 0.2f,
+                    [](float t) { return 10.0f * sinf(2.0f * (float)M_PI * 0.5f * t); },
+                    [](float t) { return 6.0f * sinf(2.0f * (float)M_PI * 0.3f * t); },
+                    [](float) { return 0.0f; }, 2.0f);
+}
+
+// Cornering on a rough surface: quick roll transitions (peaking at about
+// 150 deg/s, inside the gyro's range), fast pitch chatter and vertical
+// bumps, with heavier vibration noise.
+inline ImuTrace rough(uint32_t rateHz, float seconds) {
+  return synthesize("rough", rateHz, seconds, 3, 0.15f, 3.0f,
+                    [](float t) { return 12.0f * tanhf(8.0f * sinf(2.0f * (float)M_PI * 0.25f * t)) + 2.0f * sinf(2.0f * (float)M_PI * 3.0f * t); },
+                    [](float t) { return 4.0f * sinf(2.0f * (float)M_PI * 2.2f * t); },
+                    [](float t) { return 0.4f * sinf(2.0f * (float)M_PI * 7.0f * t) * sinf(2.0f * (float)M_PI * 0.4f * t); });
+}
+
+inline bool loadCsv(const char* path, uint32_t rateHz, ImuTrace& trace) {
+  FILE* file = fopen(path, "r");
+  if (!file) return false;
+
+  trace.name = "csv";
+  trace.sampleRateHz = rateHz;
+  trace.samples.clear();
+  trace.truth.clear();
+
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    int v[6];
+    if (sscanf(line, "%d,%d,%d,%d,%d,%d", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6) continue;
+    trace.samples.push_back({(int16_t)v[0], (int16_t)v[1], (int16_t)v[2], (int16_t)v[3], (int16_t)v[4], (int16_t)v[5]});
+  }
+  fclose(file);
+  return !trace.samples.empty();
+}
+
+}  // namespace imuTraces
+
+#endif
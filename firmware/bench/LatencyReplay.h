@@ -0,0 +1,124 @@
+#ifndef LATENCY_REPLAY_H
+#define LATENCY_REPLAY_H
+
+// How late the servos follow the body, with and without predictive
+// actuation (ActuationPredictor).
+//
+// A trace with a known true attitude is replayed through the float control
+// path (fusion, decimation, suspension model, predictor) into a servo model
+// with the configured lag: the command is held for the control period, the
+// servo starts moving servoLatencyMs later and follows with a first-order
+// lag of servoTimeConstantMs. The front-left servo position is compared
+// with the position the model asks for given the true attitude at the same
+// instant. The phase lag is the shift that best aligns the two
+// (cross-correlation, at the IMU sample spacing with parabolic
+// interpolation), and the tracking error is their RMS difference. Vertical
+// acceleration is left out so both runs see only the attitude path.
+
+#include <cmath>
+#include <vector>
+#include "BenchHarness.h"
+#include "ImuTraces.h"
+#include "Config.h"
+#include "SensorFusion.h"
+#include "Decimator.h"
+#include "SuspensionSimulator.h"
+#include "ActuationPredictor.h"
+
+namespace latencyReplay {
+
+// Shift (in samples, 0..maxShift) of `delayed` that best matches `reference`
+inline double bestShift(const std::vector<float>& reference, const std::vector<float>& delayed, size_t maxShift) {
+  const size_t n = reference.size();
+  double meanR = 0.0, meanD = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    meanR += reference[i];
+    meanD += delayed[i];
+  }
+  meanR /= n;
+  meanD /= n;
+
+  std::vector<double> score(maxShift + 1, 0.0);
+  for (size_t k = 0; k <= maxShift; k++) {
+    for (size_t i = 0; i + k < n; i++) score[k] += (reference[i] - meanR) * (delayed[i + k] - meanD);
+    score[k] /= (double)(n - k);
+  }
+  size_t best = 0;
+  for (size_t k = 1; k <= maxShift; k++) {
+    if (score[k] > score[best]) best = k;
+  }
+  if (best == 0 || best == maxShift) return (double)best;
+  double a = score[best - 1], b = score[best], c = score[best + 1];
+  double denominator = a - 2.0 * b + c;
+  return best + (denominator != 0.0 ? 0.5 * (a - c) / denominator : 0.0);
+}
+
+inline void evaluate(BenchHarness& harness, const ImuTrace& trace, const SuspensionConfig& config) {
+  bool moving = false;
+  for (const ImuTruth& truth : trace.truth) moving |= truth.rollDeg != 0.0f || truth.pitchDeg != 0.0f;
+  if (!moving) return;  // No motion to lag behind (also skips recorded traces)
+
+  const uint32_t controlRateHz = config.sampleRate;
+  const size_t ratio = trace.sampleRateHz > controlRateHz ? trace.sampleRateHz / controlRateHz : 1;
+  const size_t ticks = trace.samples.size() / ratio;
+  const float imuDt = 1.0f / trace.sampleRateHz;
+  const uint32_t periodUs = 1000000 * ratio / trace.sampleRateHz;
+  const size_t deadSamples = (size_t)lroundf(config.servoLatencyMs * 1e-3f * trace.sampleRateHz);
+  const float follow = config.servoTimeConstantMs > 0.0f ? 1.0f - expf(-imuDt / (config.servoTimeConstantMs * 1e-3f)) : 1.0f;
+
+  for (bool predicted : {false, true}) {
+    SuspensionConfig cfg = config;
+    if (!predicted) cfg.predictionGain = 0.0f;
+
+    SensorFusion fusion;
+    Decimator<5> decimator;
+    SuspensionSimulator simulator;
+    ActuationPredictor predictor;
+    fusion.setOrientation(cfg.mpuOrientation);
+    fusion.setMode(cfg.fusionMode);
+    fusion.init(trace.sampleRateHz);
+    decimator.init(trace.sampleRateHz, (float)trace.sampleRateHz / ratio);
+    simulator.init(cfg);
+    predictor.configure(cfg, periodUs);
+
+    // Servo commands and positions, one per IMU sample
+    std::vector<float> command(ticks * ratio), servo(ticks * ratio), reference(ticks * ratio);
+    float position = cfg.rideHeightOffset;
+    for (size_t t = 0; t < ticks; t++) {
+      for (size_t i = t * ratio; i < (t + 1) * ratio; i++) {
+        const ImuRawSample& s = trace.samples[i];
+        fusion.update(s.ax / 16384.0f, s.ay / 16384.0f, s.az / 16384.0f,
+                      s.gx / 131.0f, s.gy / 131.0f, s.gz / 131.0f, imuDt);
+        const float fused[5] = {fusion.getRoll(), fusion.getPitch(), fusion.getVerticalAcceleration(),
+                                fusion.getRollRate(), fusion.getPitchRate()};
+        decimator.push(fused);
+      }
+      simulator.update(decimator.output(0), decimator.output(1), 0.0f);
+      predictor.predict(simulator, decimator.output(3), decimator.output(4));
+
+      for (size_t i = t * ratio; i < (t + 1) * ratio; i++) {
+        command[i] = predictor.getOutput(0);
+        position += follow * ((i >= deadSamples ? command[i - deadSamples] : cfg.rideHeightOffset) - position);
+        servo[i] = position;
+        float target = cfg.rideHeightOffset + simulator.getRollGain(0) * trace.truth[i].rollDeg +
+                       simulator.getPitchGain(0) * trace.truth[i].pitchDeg;
+        reference[i] = constrain(target, simulator.getMinPosition(), simulator.getMaxPosition());
+      }
+    }
+
+    // Skip the first second while the filters settle
+    const size_t settle = trace.sampleRateHz < reference.size() ? trace.sampleRateHz : 0;
+    std::vector<float> r(reference.begin() + settle, reference.end()), y(servo.begin() + settle, servo.end());
+    double sumSquares = 0.0;
+    for (size_t i = 0; i < r.size(); i++) sumSquares += (double)(y[i] - r[i]) * (y[i] - r[i]);
+
+    const char* name = predicted ? "predicted" : "unpredicted";
+    double lagMs = 1000.0 * bestShift(r, y, trace.sampleRateHz / 2) / trace.sampleRateHz;
+    harness.record(std::string("servo_phase_lag_ms_") + name, trace.name, lagMs);
+    harness.record(std::string("servo_tracking_rms_deg_") + name, trace.name, r.empty() ? 0.0 : sqrt(sumSquares / r.size()));
+  }
+}
+
+}  // namespace latencyReplay
+
+#endif
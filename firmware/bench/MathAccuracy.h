@@ -0,0 +1,89 @@
+#ifndef MATH_ACCURACY_H
+#define MATH_ACCURACY_H
+
+// Accuracy and cost of the FastMath approximations against libm.
+//
+// Errors are measured in double precision over the full input range: atan2
+// around the whole circle at radii from 1e-30 to 1e30 plus the axes and
+// origin, asin across [-1, 1], and sqrt/invSqrt over every exponent of the
+// normal float range. The maxima are recorded as metrics and checked against
+// the bounds documented in FastMath.h; checkFastMath() returns false if any
+// is exceeded, which fails the bench run.
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "BenchHarness.h"
+#include "FastMath.h"
+
+namespace mathAccuracy {
+
+inline double angleError(double a, double b) {
+  double e = fabs(a - b);
+  return e > M_PI ? 2.0 * M_PI - e : e;
+}
+
+inline bool checkFastMath(BenchHarness& harness, unsigned repetitions) {
+  const int ANGLE_STEPS = 1 << 20;
+  const float radii[] = {1e-30f, 1e-6f, 1e-3f, 1.0f, 1e3f, 1e6f, 1e30f};
+
+  double atan2Error = 0.0;
+  for (int i = 0; i <= ANGLE_STEPS; i++) {
+    double theta = -M_PI + 2.0 * M_PI * i / ANGLE_STEPS;
+    for (float r : radii) {
+      float y = (float)(r * sin(theta)), x = (float)(r * cos(theta));
+      atan2Error = fmax(atan2Error, angleError(fastMath::approxAtan2(y, x), atan2((double)y, (double)x)));
+    }
+  }
+  const float axes[][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1}};
+  for (const auto& a : axes) {
+    atan2Error = fmax(atan2Error, angleError(fastMath::approxAtan2(a[0], a[1]), atan2((double)a[0], (double)a[1])));
+  }
+  bool originOk = fastMath::approxAtan2(0.0f, 0.0f) == 0.0f;
+
+  double asinError = 0.0;
+  for (int i = 0; i <= ANGLE_STEPS; i++) {
+    float x = -1.0f + 2.0f * i / ANGLE_STEPS;
+    asinError = fmax(asinError, fabs(fastMath::approxAsin(x) - asin((double)x)));
+  }
+
+  double sqrtError = 0.0, invSqrtError = 0.0;
+  for (uint32_t bits = 0x00800000u; bits < 0x7f800000u; bits += 97) {
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    double exact = sqrt((double)x);
+    sqrtError = fmax(sqrtError, fabs(fastMath::approxSqrt(x) / exact - 1.0));
+    invSqrtError = fmax(invSqrtError, fabs(fastMath::approxInvSqrt(x) * exact - 1.0));
+  }
+
+  harness.record("fastmath_atan2_max_err_deg", "math", atan2Error * 180.0 / M_PI);
+  harness.record("fastmath_asin_max_err_deg", "math", asinError * 180.0 / M_PI);
+  harness.record("fastmath_sqrt_max_rel_err", "math", sqrtError);
+  harness.record("fastmath_invsqrt_max_rel_err", "math", invSqrtError);
+
+  // Cost per call, libm vs. approximation, on typical accelerometer inputs
+  std::vector<float> ys(4096), xs(4096);
+  for (size_t i = 0; i < ys.size(); i++) {
+    float theta = -3.1f + 6.2f * i / ys.size();
+    ys[i] = sinf(theta);
+    xs[i] = 0.5f + 0.5f * cosf(theta) * cosf(theta);
+  }
+  const size_t n = ys.size();
+  float sink = 0.0f;
+  harness.run("libm_atan2f", "math", n, repetitions, []() {}, [&](size_t i) { sink += atan2f(ys[i], xs[i]); benchKeep(sink); });
+  harness.run("fast_atan2", "math", n, repetitions, []() {}, [&](size_t i) { sink += fastMath::approxAtan2(ys[i], xs[i]); benchKeep(sink); });
+  harness.run("libm_sqrtf", "math", n, repetitions, []() {}, [&](size_t i) { sink += sqrtf(xs[i]); benchKeep(sink); });
+  harness.run("fast_sqrt", "math", n, repetitions, []() {}, [&](size_t i) { sink += fastMath::approxSqrt(xs[i]); benchKeep(sink); });
+
+  bool ok = originOk && atan2Error <= fastMath::ATAN2_MAX_ERROR_RAD && asinError <= fastMath::ASIN_MAX_ERROR_RAD &&
+            sqrtError <= fastMath::SQRT_MAX_RELATIVE_ERROR && invSqrtError <= fastMath::SQRT_MAX_RELATIVE_ERROR;
+  if (!ok) {
+    fprintf(stderr, "FastMath accuracy check FAILED: atan2 %.3g rad, asin %.3g rad, sqrt %.3g, invSqrt %.3g%s\n",
+            atan2Error, asinError, sqrtError, invSqrtError, originOk ? "" : ", atan2(0, 0) != 0");
+  }
+  return ok;
+}
+
+}  // namespace mathAccuracy
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef MOTION_LIMITER_CHECK_H
+#define MOTION_LIMITER_CHECK_H
+
+// Servo command profiles through MotionLimiter at the control rate.
+//
+// Each case feeds one channel a command sequence: a 60 degree step (a ride
+// height change), a one-tick 60 degree spike (an IMU glitch), a sine the
+// servo limits allow (roll at 1 Hz) and one they do not. It records the peak
+// velocity and acceleration of the limited command, the overshoot past the
+// step and the time to settle within 0.1 degree of it, how far the glitch
+// moves the servo, and how far the allowed sine is altered. The fixed-point
+// limiter is run on the same sequences. checkProfiles() returns false if a
+// limit is exceeded, the step overshoots, the allowed sine is changed, or
+// the fixed-point output is more than CORNER_TOLERANCE_DEG from the float
+// one, which fails the bench run.
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include "BenchHarness.h"
+#include "Config.h"
+#include "FixedPoint.h"
+#include "MotionLimiter.h"
+
+namespace motionLimiterCheck {
+
+struct Profile {
+  const char* name;
+  std::vector<float> target;
+};
+
+inline std::vector<Profile> profiles(uint32_t rateHz) {
+  const size_t ticks = rateHz * 2;
+  std::vector<Profile> cases = {{"step", {}}, {"glitch", {}}, {"sine_allowed", {}}, {"sine_fast", {}}};
+  for (size_t t = 0; t < ticks; t++) {
+    const float seconds = (float)t / rateHz;
+    cases[0].target.push_back(t < rateHz / 5 ? 90.0f : 150.0f);
+    cases[1].target.push_back(t == rateHz / 5 ? 150.0f : 90.0f);
+    cases[2].target.push_back(90.0f + 20.0f * cosf(2.0f * (float)M_PI * 1.0f * seconds));
+    cases[3].target.push_back(90.0f + 40.0f * cosf(2.0f * (float)M_PI * 4.0f * seconds));
+  }
+  return cases;
+}
+
+inline bool checkProfiles(BenchHarness& harness, uint32_t controlRateHz) {
+  const uint32_t periodUs = 1000000 / controlRateHz;
+  const float rate = 1e6f / periodUs;
+  const float vMax = DEFAULT_SERVO_MAX_VELOCITY, aMax = DEFAULT_SERVO_MAX_ACCELERATION;
+  bool ok = true;
+
+  for (const Profile& profile : profiles(controlRateHz)) {
+    MotionLimiter limiter, fixedLimiter;
+    limiter.setLimits(0, DEFAULT_SERVO_MAX_VELOCITY, DEFAULT_SERVO_MAX_ACCELERATION, periodUs);
+    fixedLimiter.setLimits(0, DEFAULT_SERVO_MAX_VELOCITY, DEFAULT_SERVO_MAX_ACCELERATION, periodUs);
+    limiter.reset(profile.target[0]);
+    fixedLimiter.reset(profile.target[0]);
+
+    const float final = profile.target.back();
+    float last = profile.target[0], lastVelocity = 0.0f;
+    double peakVelocity = 0.0, peakAcceleration = 0.0, overshoot = 0.0, deviation = 0.0, fixedError = 0.0, excursion = 0.0;
+    size_t settled = 0;
+    for (size_t t = 0; t < profile.target.size(); t++) {
+      float command = profile.target[t];
+      fixedPoint::q16_t commandQ = fixedPoint::fromFloat(command);
+      limiter.limit(&command, 1);
+      fixedLimiter.limitFixed(&commandQ, 1);
+
+      const float velocity = (command - last) * rate;
+      peakVelocity = fmax(peakVelocity, fabsf(velocity));
+      peakAcceleration = fmax(peakAcceleration, fabsf(velocity - lastVelocity) * rate);
+      overshoot = fmax(overshoot, (command - final) * (final >= profile.target[0] ? 1.0f : -1.0f));
+      deviation = fmax(deviation, fabsf(command - profile.target[t]));
+      excursion = fmax(excursion, fabsf(command - profile.target[0]));
+      fixedError = fmax(fixedError, fabsf(command - fixedPoint::toFloat(commandQ)));
+      if (fabsf(command - final) > 0.1f) settled = t + 1;
+      last = command;
+      lastVelocity = velocity;
+    }
+
+    const std::string name = profile.name;
+    harness.record("limiter_peak_velocity_dps", name, peakVelocity);
+    harness.record("limiter_peak_accel_dps2", name, peakAcceleration);
+    harness.record("limiter_fixed_max_deg", name, fixedError);
+    bool caseOk = peakVelocity <= vMax * 1.001 && peakAcceleration <= aMax * 1.001 &&
+                  fixedError <= fixedPoint::CORNER_TOLERANCE_DEG;
+    if (name == "step") {
+      const double stepStartMs = 1000.0 * (controlRateHz / 5) / rate;
+      harness.record("limiter_overshoot_deg", name, overshoot);
+      harness.record("limiter_settle_ms", name, 1000.0 * settled / rate - stepStartMs);
+      caseOk &= overshoot <= 1e-3;
+    } else if (name == "glitch") {
+      harness.record("limiter_glitch_excursion_deg", name, excursion);
+    } else if (name == "sine_allowed") {
+      harness.record("limiter_deviation_max_deg", name, deviation);
+      caseOk &= deviation <= 1e-3;
+    }
+    if (!caseOk) {
+      fprintf(stderr, "Motion limiter check FAILED on %s: %.1f deg/s, %.0f deg/s^2, overshoot %.3g deg, "
+                      "deviation %.3g deg, fixed-point %.3g deg\n",
+              profile.name, peakVelocity, peakAcceleration, overshoot, deviation, fixedError);
+    }
+    ok &= caseOk;
+  }
+  return ok;
+}
+
+}  // namespace motionLimiterCheck
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef PCA9685_CHECK_H
+#define PCA9685_CHECK_H
+
+// The PCA9685 servo backend against the fake device in the native HAL.
+//
+// Frames of servo commands go through PWMOutputs twice, once on the LEDC
+// backend and once on the PCA9685. Each PCA9685 frame must be exactly one
+// I2C write of 1 + 4 * channels bytes. Every channel's ON count must be
+// its phase, and its pulse (OFF - ON) must match the LEDC pulse (for the
+// four corners LEDC drives) to within one 12-bit count. Also reports the bus time of a frame at I2C_CLOCK_HZ
+// and the 12-bit servo resolution.
+
+#include <cmath>
+#include <Wire.h>
+#include "BenchHarness.h"
+#include "Config.h"
+#include "I2cBus.h"
+#include "PWMOutputs.h"
+#include "LedcServoBackend.h"
+#include "Pca9685ServoBackend.h"
+#include "NativeHal.h"
+
+namespace pca9685Check {
+
+constexpr double MAX_PULSE_DIFFERENCE_COUNTS = 1.0;
+
+inline bool checkFrames(BenchHarness& harness, const ServoConfig& servos) {
+  I2cBus bus(Wire);
+  Pca9685ServoBackend backend(bus);
+  PWMOutputs pca, ledc;
+  if (!pca.init(backend)) {
+    fprintf(stderr, "PCA9685 check FAILED: no response at 0x%02X\n", PCA9685_ADDRESS);
+    return false;
+  }
+  ledc.init();
+  pca.configure(servos);
+  ledc.configure(servos);
+
+  const uint8_t channels = pca.getChannelCount();
+  const double pcaCountsPerUs = backend.countsPerMicrosecond(0);
+  const double ledcCountsPerUs = (double)(1UL << PWM_RESOLUTION_BITS) * PWM_FREQ / 1e6;
+  uint64_t frames = 0, badFrames = 0, badPhases = 0;
+  double maxDifference = 0.0;
+  const uint64_t transactionsBefore = nativeHal::pca9685Transactions();
+  for (float sweep = 0.0f; sweep < 180.0f; sweep += 0.25f) {
+    float angles[PWMOutputs::MAX_CHANNELS];
+    for (uint8_t i = 0; i < channels; i++) angles[i] = fmodf(sweep + 37.0f * i, 180.0f);
+
+    const uint64_t transactions = nativeHal::pca9685Transactions();
+    const uint64_t bytes = nativeHal::pca9685BytesWritten();
+    pca.commitFrame(angles);
+    ledc.commitFrame(angles);
+    frames++;
+    if (nativeHal::pca9685Transactions() - transactions != 1 ||
+        nativeHal::pca9685BytesWritten() - bytes != 1u + 4u * channels) {
+      badFrames++;
+    }
+
+    for (uint8_t i = 0; i < channels; i++) {
+      const uint16_t on = nativeHal::pca9685On(i), off = nativeHal::pca9685Off(i);
+      const uint32_t expectedPhase = (uint32_t)(i * pca.getPhaseStagger() * pcaCountsPerUs + 0.5);
+      if (on != expectedPhase) badPhases++;
+      if (i >= ledc.getChannelCount()) continue;  // Middle axles have no LEDC output to compare with
+      const double pulseUs = ((off - on) & (Pca9685ServoBackend::FRAME_COUNTS - 1)) / pcaCountsPerUs;
+      const double referenceUs = nativeHal::ledcDuty(LedcServoBackend::ledcChannel(i)) / ledcCountsPerUs;
+      const double difference = fabs(pulseUs - referenceUs) * pcaCountsPerUs;
+      maxDifference = difference > maxDifference ? difference : maxDifference;
+    }
+  }
+
+  // Address byte + payload, 9 clocks each, plus start and stop
+  const double bytesPerFrame = 1.0 + 4.0 * channels;
+  harness.record("pca9685_i2c_transactions_per_frame", "frame", frames ? (double)(nativeHal::pca9685Transactions() - transactionsBefore) / frames : 0.0);
+  harness.record("pca9685_i2c_bytes_per_frame", "frame", bytesPerFrame);
+  harness.record("pca9685_i2c_bus_us_per_frame", "frame", ((1.0 + bytesPerFrame) * 9.0 + 2.0) * 1e6 / I2C_CLOCK_HZ);
+  harness.record("pca9685_pulse_max_diff_counts", "vs_ledc", maxDifference);
+  harness.record("pwm_degrees_per_count", "pca9685", 180.0 / ((SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US) * pcaCountsPerUs));
+
+  bool ok = badFrames == 0 && badPhases == 0 && maxDifference <= MAX_PULSE_DIFFERENCE_COUNTS;
+  if (!ok) {
+    fprintf(stderr, "PCA9685 check FAILED: %llu frames not a single burst, %llu wrong phases, pulse off by %.2f counts\n",
+            (unsigned long long)badFrames, (unsigned long long)badPhases, maxDifference);
+  }
+  return ok;
+}
+
+}  // namespace pca9685Check
+
+#endif
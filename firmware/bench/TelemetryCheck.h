@@ -0,0 +1,246 @@
+#ifndef TELEMETRY_CHECK_H
+#define TELEMETRY_CHECK_H
+
+// WebSocket telemetry: frame layout, per-client formats and rates, and
+// backpressure.
+//
+// checkFrames() decodes binary frames with an independent little-endian
+// reader and compares every field with the sample (NaN attitude included),
+// then runs ten seconds of 50 Hz attitude and 2 Hz battery updates through
+// a TelemetryPublisher with four clients on a host WebSocket: JSON at the
+// default rate, binary at 50 and 10 Hz, and binary at 50 Hz on a link that
+// drains only 10 messages a second. It records each client's frame rate,
+// the bytes per frame of each format, the stalled client's peak queue and
+// the time to serialize one frame in each format. checkBandLimits() then
+// drives 10 to 20 Hz roll through a publisher with a default-rate JSON
+// client and a 50 Hz binary one, and records the amplitude each shows. It
+// returns false if a frame does not round-trip or carry the newest sample,
+// a client gets the wrong format or rate or a non-increasing sequence
+// number, the stalled client's queue exceeds TELEMETRY_MAX_QUEUED_FRAMES,
+// vibration aliases into the default client's frames, or 10 Hz motion is
+// removed from the 50 Hz client's, which fails the bench run.
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include "BenchHarness.h"
+#include "TelemetryFrame.h"
+#include "TelemetryPublisher.h"
+#include "NativeHal.h"
+
+namespace telemetryCheck {
+
+inline uint32_t readU32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+inline float readFloat(const uint8_t* p) {
+  uint32_t bits = readU32(p);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline bool sameFloat(float a, float b) {
+  return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// Attitude fields (other than yaw) within `tolerance` of the sample, as
+// they are low-passed for the client's rate; everything else exact
+inline bool decodeMatches(const uint8_t* frame, size_t length, const TelemetrySample& sample, float tolerance = 0.0f) {
+  if (length != telemetryFrame::BINARY_SIZE || frame[0] != telemetryFrame::VERSION ||
+      frame[1] != telemetryFrame::MESSAGE_TELEMETRY) {
+    return false;
+  }
+  const uint16_t flags = (uint16_t)(frame[2] | frame[3] << 8);
+  const bool online = !std::isnan(sample.roll);
+  bool ok = ((flags & telemetryFrame::FLAG_IMU_ONLINE) != 0) == online;
+  ok &= readU32(frame + 4) == sample.sequence && readU32(frame + 8) == sample.timestampUs;
+  const float fields[7] = {sample.roll, sample.pitch, sample.yaw, sample.verticalAccel,
+                           sample.batteries[0], sample.batteries[1], sample.batteries[2]};
+  for (int i = 0; i < 7; i++) {
+    const float value = readFloat(frame + 12 + 4 * i);
+    const bool filtered = online && (i == 0 || i == 1 || i == 3);
+    ok &= filtered ? fabsf(value - fields[i]) <= tolerance : sameFloat(value, fields[i]);
+  }
+  return ok;
+}
+
+inline bool checkFrames(BenchHarness& harness, unsigned repetitions) {
+  const TelemetrySample samples[] = {
+    {0, 0, 0.0f, 0.0f, 0.0f, 0.0f, {0.0f, 0.0f, 0.0f}},
+    {41, 123456789, -12.3f, 4.5f, 179.9f, 1.02f, {12.6f, 7.4f, 0.0f}},
+    {0xFFFFFFFFu, 0xFFFFFFFFu, NAN, NAN, NAN, NAN, {11.1f, 0.0f, 25.2f}},
+  };
+  bool ok = true;
+  for (const TelemetrySample& sample : samples) {
+    uint8_t frame[telemetryFrame::BINARY_SIZE];
+    ok &= decodeMatches(frame, telemetryFrame::encodeBinary(sample, frame), sample);
+  }
+
+  // Four clients on one socket, simulated for ten seconds of service passes:
+  // JSON at the default rate, binary at 50 Hz and 10 Hz, and binary at 50 Hz
+  // over a link that only drains 10 messages a second
+  struct Subscriber {
+    const char* name;
+    const char* hello;
+    uint32_t expectedRate;
+    bool stalled;
+  };
+  const Subscriber subscribers[4] = {
+    {"json_default", nullptr, TELEMETRY_RATE_HZ, false},
+    {"binary_50hz", "{\"type\":\"hello\",\"telemetry\":\"binary\",\"rateHz\":50}", 50, false},
+    {"binary_10hz", "{\"type\":\"hello\",\"telemetry\":\"binary\",\"rateHz\":10}", 10, false},
+    {"binary_50hz_stalled", "{\"type\":\"hello\",\"telemetry\":\"binary\",\"rateHz\":50}", 10, true},
+  };
+  AsyncWebSocket ws("/ws");
+  TelemetryPublisher publisher(ws);
+  ws.onEvent([&](AsyncWebSocket*, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    publisher.onEvent(client, type, arg, data, len);
+  });
+  AsyncWebSocketClient* clients[4];
+  for (int i = 0; i < 4; i++) {
+    clients[i] = ws.connectClient();
+    if (subscribers[i].hello) ws.receiveText(clients[i]->id(), subscribers[i].hello);
+    clients[i]->stalled = subscribers[i].stalled;
+  }
+  ok &= clients[1]->lastMessage == "{\"type\":\"hello\",\"telemetry\":\"binary\",\"version\":1,\"rateHz\":50}";
+  ws.receiveText(clients[0]->id(), "{\"type\":\"hello\",\"telemetry\":\"carrier-pigeon\"}");  // Format unchanged
+  ok &= publisher.getFormat(clients[0]->id()) == TelemetryPublisher::FORMAT_JSON;
+
+  const uint32_t SECONDS = 10;
+  const char* jsonPrefix = "{\"type\":\"telemetry\",\"seq\":";
+  const size_t prefixLength = strlen(jsonPrefix);
+  uint64_t received[4], bytesBefore[4];
+  int64_t lastSequence[4] = {-1, -1, -1, -1};
+  size_t peakQueue = 0;
+  for (int i = 0; i < 4; i++) received[i] = clients[i]->messagesReceived, bytesBefore[i] = clients[i]->bytesReceived;
+  TelemetrySample expected = samples[1];
+  for (uint32_t ms = 0; ms < SECONDS * 1000; ms += SERVICE_TASK_PERIOD_MS) {
+    nativeHal::advanceMicros(SERVICE_TASK_PERIOD_MS * 1000);
+    if (ms % (1000 / SUSPENSION_SAMPLE_RATE_HZ) == 0) {
+      expected.roll = 10.0f * sinf(ms * 1e-3f);
+      expected.timestampUs = ms * 1000;
+      publisher.setAttitude(expected.roll, expected.pitch, expected.yaw, expected.verticalAccel, expected.timestampUs);
+    }
+    if (ms % 500 == 0) {
+      expected.batteries[0] = 12.6f - ms * 1e-5f;
+      publisher.setBatteries(expected.batteries[0], expected.batteries[1], expected.batteries[2]);
+    }
+    if (ms % 100 == 0) clients[3]->drain(1);  // 10 messages a second
+
+    uint64_t before[4];
+    for (int i = 0; i < 4; i++) before[i] = clients[i]->messagesReceived;
+    publisher.service(millis());
+    for (int i = 0; i < 4; i++) {
+      if (clients[i]->messagesReceived == before[i]) continue;
+      // Every frame carries the newest sample and a higher sequence number
+      const std::string& message = clients[i]->lastMessage;
+      int64_t frameSequence;
+      if (clients[i]->lastMessageBinary) {
+        const uint8_t* frame = (const uint8_t*)message.data();
+        frameSequence = readU32(frame + 4);
+        expected.sequence = (uint32_t)frameSequence;
+        ok &= subscribers[i].hello && decodeMatches(frame, message.size(), expected, 1.0f);
+      } else {
+        ok &= !subscribers[i].hello && message.compare(0, prefixLength, jsonPrefix) == 0;
+        frameSequence = strtol(message.c_str() + prefixLength, nullptr, 10);
+      }
+      ok &= frameSequence > lastSequence[i];
+      lastSequence[i] = frameSequence;
+    }
+    peakQueue = clients[3]->queueLen() > peakQueue ? clients[3]->queueLen() : peakQueue;
+  }
+  for (int i = 0; i < 4; i++) {
+    const double rate = (double)(clients[i]->messagesReceived - received[i]) / SECONDS;
+    harness.record("telemetry_frames_per_s", subscribers[i].name, rate);
+    ok &= fabs(rate - subscribers[i].expectedRate) <= 1.0;
+  }
+  harness.record("telemetry_bytes_per_frame", "json", (double)(clients[0]->bytesReceived - bytesBefore[0]) /
+                                                      (clients[0]->messagesReceived - received[0]));
+  harness.record("telemetry_bytes_per_frame", "binary", (double)(clients[1]->bytesReceived - bytesBefore[1]) /
+                                                        (clients[1]->messagesReceived - received[1]));
+  harness.record("telemetry_stalled_peak_queue", "binary_50hz_stalled", peakQueue);
+  harness.record("telemetry_coalesced_per_s", "binary_50hz_stalled", (double)publisher.getStats().coalesced / SECONDS);
+  ok &= peakQueue <= TELEMETRY_MAX_QUEUED_FRAMES;
+
+  // Serialization cost per frame
+  uint8_t frame[telemetryFrame::BINARY_SIZE];
+  char json[telemetryFrame::JSON_CAPACITY];
+  TelemetrySample sample = samples[1];
+  harness.run("telemetry_binary", "frame", 1000, repetitions, []() {}, [&](size_t i) {
+    sample.sequence = i;
+    benchKeep(telemetryFrame::encodeBinary(sample, frame));
+    benchKeep(frame);
+  });
+  harness.run("telemetry_json", "frame", 1000, repetitions, []() {}, [&](size_t i) {
+    sample.sequence = i;
+    benchKeep(telemetryFrame::encodeJson(sample, json, sizeof(json)));
+    benchKeep(json);
+  });
+
+  if (!ok) fprintf(stderr, "Telemetry check FAILED: frames, format negotiation, rates or backpressure incorrect\n");
+  return ok;
+}
+
+// Peak roll (as a fraction of the input amplitude) each client shows in
+// the last two of four seconds of `frequencyHz` roll fed at the control
+// rate: [0] the default JSON client, [1] a binary client at
+// TELEMETRY_MAX_RATE_HZ
+inline void rollGain(float frequencyHz, float gain[2]) {
+  const float AMPLITUDE = 10.0f;
+  AsyncWebSocket ws("/ws");
+  TelemetryPublisher publisher(ws);
+  ws.onEvent([&](AsyncWebSocket*, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    publisher.onEvent(client, type, arg, data, len);
+  });
+  AsyncWebSocketClient* clients[2] = {ws.connectClient(), ws.connectClient()};
+  char hello[64];
+  snprintf(hello, sizeof(hello), "{\"type\":\"hello\",\"telemetry\":\"binary\",\"rateHz\":%d}", TELEMETRY_MAX_RATE_HZ);
+  ws.receiveText(clients[1]->id(), hello);
+
+  gain[0] = gain[1] = 0.0f;
+  for (uint32_t ms = 0; ms < 4000; ms += SERVICE_TASK_PERIOD_MS) {
+    nativeHal::advanceMicros(SERVICE_TASK_PERIOD_MS * 1000);
+    if (ms % (1000 / SUSPENSION_SAMPLE_RATE_HZ) == 0) {
+      const float roll = AMPLITUDE * sinf(2.0f * (float)M_PI * frequencyHz * ms * 1e-3f + 0.3f);
+      publisher.setAttitude(roll, 0.0f, 0.0f, 1.0f, ms * 1000);
+    }
+    uint64_t before[2] = {clients[0]->messagesReceived, clients[1]->messagesReceived};
+    publisher.service(millis());
+    if (ms < 2000) continue;
+    if (clients[0]->messagesReceived != before[0]) {
+      const char* field = strstr(clients[0]->lastMessage.c_str(), "\"roll\":");
+      if (field) gain[0] = fmaxf(gain[0], fabsf(strtof(field + 7, nullptr)) / AMPLITUDE);
+    }
+    if (clients[1]->messagesReceived != before[1] && clients[1]->lastMessageBinary) {
+      gain[1] = fmaxf(gain[1], fabsf(readFloat((const uint8_t*)clients[1]->lastMessage.data() + 12)) / AMPLITUDE);
+    }
+  }
+}
+
+// Roll is low-passed per subscribed rate: 10 to 20 Hz vibration must not
+// alias into the default TELEMETRY_RATE_HZ client's frames, while 10 Hz
+// motion still reaches a TELEMETRY_MAX_RATE_HZ client (not -3 dB down)
+inline bool checkBandLimits(BenchHarness& harness) {
+  bool ok = true;
+  float worstAlias = 0.0f;
+  for (float frequencyHz : {10.0f, 12.0f, 15.0f, 17.0f, 20.0f}) {
+    float gain[2];
+    rollGain(frequencyHz, gain);
+    worstAlias = fmaxf(worstAlias, gain[0]);
+    if (frequencyHz == 10.0f) {
+      harness.record("telemetry_filter_gain", "50hz_client_10hz", gain[1]);
+      ok &= gain[1] >= 0.707f;
+    }
+  }
+  harness.record("telemetry_alias_gain", "default_client_10_20hz", worstAlias);
+  ok &= worstAlias <= 0.1f;
+
+  if (!ok) fprintf(stderr, "Telemetry check FAILED: telemetry not band-limited for each client's rate\n");
+  return ok;
+}
+
+}  // namespace telemetryCheck
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef ACTUATION_PREDICTOR_H
+#define ACTUATION_PREDICTOR_H
+
+#include "Config.h"
+#include "FixedPoint.h"
+#include "SuspensionSimulator.h"
+#include <cmath>
+
+// Feed-forward stage between SuspensionSimulator and PWMOutputs.
+//
+// A command written this tick is held until the next one (half a control
+// period late on average), then the servo starts moving after its dead time
+// and follows with a first-order lag. For a body rolling or pitching at a
+// steady rate all three delays add up, so each corner is commanded where
+// the model will want it `horizon` seconds from now:
+//
+//   output = position + gain * (rollGain * rollRate + pitchGain * pitchRate) * horizon
+//   horizon = period / 2 + servoLatency + servoTimeConstant
+//
+// using the gyro rates (decimated with the attitude) rather than differencing
+// the attitude, which would add another tick of delay. The lead is capped at
+// PREDICTION_MAX_LEAD_DEG so a gyro spike cannot throw a servo across its
+// range, and the result stays inside the model's range limit.
+class ActuationPredictor {
+private:
+  float horizon = 0.0f;            // Seconds of lead, scaled by the prediction gain
+  fixedPoint::q16_t horizonQ = 0;
+  
+  float output[SuspensionSimulator::MAX_CORNERS] = {};
+  fixedPoint::q16_t outputQ[SuspensionSimulator::MAX_CORNERS] = {};
+  
+public:
+  // Recompute the horizon from the servo lag model (on config changes)
+  void configure(const SuspensionConfig& cfg, uint32_t controlPeriodUs) {
+    float lagSeconds = controlPeriodUs * 0.5e-6f + (cfg.servoLatencyMs + cfg.servoTimeConstantMs) * 1e-3f;
+    horizon = constrain(cfg.predictionGain, 0.0f, 1.0f) * lagSeconds;
+    horizonQ = fixedPoint::fromFloat(horizon);
+  }
+  
+  float getHorizonSeconds() const { return horizon; }
+  
+  // Attitude rates in deg/s, from SensorFusion
+  void predict(const SuspensionSimulator& simulator, float rollRate, float pitchRate) {
+    const float low = fmaxf(simulator.getMinPosition(), 0.0f), high = fminf(simulator.getMaxPosition(), 180.0f);
+    for (uint8_t i = 0; i < simulator.getCornerCount(); i++) {
+      float lead = (simulator.getRollGain(i) * rollRate + simulator.getPitchGain(i) * pitchRate) * horizon;
+      lead = constrain(lead, -PREDICTION_MAX_LEAD_DEG, PREDICTION_MAX_LEAD_DEG);
+      output[i] = constrain(simulator.getOutput(i) + lead, low, high);
+    }
+  }
+  
+  // The same in Q16.16, after SuspensionSimulator::updateFixed(). Also
+  // refreshes the float outputs.
+  void predictFixed(const SuspensionSimulator& simulator, fixedPoint::q16_t rollRate, fixedPoint::q16_t pitchRate) {
+    const fixedPoint::q16_t maxLead = fixedPoint::fromFloat(PREDICTION_MAX_LEAD_DEG);
+    const fixedPoint::q16_t low = fixedPoint::clamp(simulator.getMinPositionQ16(), 0, fixedPoint::fromInt(180));
+    const fixedPoint::q16_t high = fixedPoint::clamp(simulator.getMaxPositionQ16(), 0, fixedPoint::fromInt(180));
+    for (uint8_t i = 0; i < simulator.getCornerCount(); i++) {
+      fixedPoint::q16_t rate = fixedPoint::mul(simulator.getRollGainQ16(i), rollRate) +
+                               fixedPoint::mul(simulator.getPitchGainQ16(i), pitchRate);
+      fixedPoint::q16_t lead = fixedPoint::clamp(fixedPoint::mul(rate, horizonQ), -maxLead, maxLead);
+      outputQ[i] = fixedPoint::clamp(simulator.getOutputQ16(i) + lead, low, high);
+      output[i] = fixedPoint::toFloat(outputQ[i]);
+    }
+  }
+  
+  // Servo commands (0-180 degrees)
+  float getOutput(uint8_t corner) const { return output[corner]; }
+  fixedPoint::q16_t getOutputQ16(uint8_t corner) const { return outputQ[corner]; }
+};
+
+#endif
@@ -2,13 +2,36 @@
 #define CONFIG_H
 
 // Sensor configuration
-#define SUSPENSION_SAMPLE_RATE_HZ 25  // 25 Hz update rate (reduced from 50 Hz for I2C stability)
+#define SUSPENSION_SAMPLE_RATE_HZ 50  // Suspension model + servo update rate (IMU is sampled separately)
+#define TELEMETRY_RATE_HZ 5           // Sensor data broadcast to web clients (default; each client may ask for its own rate)
+#define TELEMETRY_MAX_RATE_HZ 50      // Fastest rate a client may subscribe at
+#define TELEMETRY_MAX_CLIENTS 8       // WebSocket clients tracked for telemetry (ESPAsyncWebServer's default limit)
+#define TELEMETRY_MAX_QUEUED_FRAMES 2 // A client with this many messages unsent skips telemetry until it catches up
+#define HTTP_RESPONSE_BUFFERS 3       // JSON responses in flight at once (see ResponseBufferPool.h)
+#define HTTP_RESPONSE_BUFFER_SIZE 1536 // Largest JSON response (/api/config)
+#define CONFIG_ANNOUNCE_INTERVAL_MS 250 // Config version pushed to WebSocket clients at most this often
+#define HISTORY_CAPACITY 512          // Control ticks kept for /api/history (power of two; ~10 s at 50 Hz, 52 bytes each)
 #define I2C_SDA_PIN 21
 #define I2C_SCL_PIN 22
+#define I2C_CLOCK_HZ 400000  // Fast mode, needed for FIFO bursts at the IMU rate
+
+// IMU acquisition: the MPU6050 samples into its FIFO at this rate and the
+// acquisition task drains it in bursts (see ImuAcquisition.h)
+#define IMU_SAMPLE_RATE_HZ 500
+#define IMU_DLPF_MODE MPU6050_DLPF_BW_98   // Keep the bandwidth under half the sample rate
+#define IMU_INT_PIN 19                     // MPU6050 INT -> GPIO 19 (-1 if not wired: poll on a timer)
+#define IMU_BURST_SAMPLES 8                // Wake the acquisition task every N samples
+#define IMU_RING_CAPACITY 128              // Samples buffered for the control loop (power of two)
+#define IMU_STALL_TIMEOUT_MS 100           // No data for this long = sensor offline
+#define IMU_RECONFIGURE_INTERVAL_MS 1000   // Retry interval while offline
 
 // PWM Output configuration (using PCA9685 or direct GPIO)
-#define PWM_FREQ 50  // 50 Hz for servo control
-// Note: PWM_RESOLUTION is defined in PWMOutputs.h
+#define PWM_FREQ 50  // 50 Hz for servo control (default frame rate; set per servo, see ServoCalibration)
+#define PWM_MAX_FREQ 333             // Fastest frame rate (digital servos): the 2 ms pulse must fit the period
+#define PWM_RESOLUTION_BITS 16       // LEDC duty resolution: 0.3 us per count at 50 Hz, 0.05 us at 333 Hz
+#define SERVO_MIN_PULSE_US 1000      // Pulse at 0 degrees
+#define SERVO_MAX_PULSE_US 2000      // Pulse at 180 degrees
+#define SERVO_PHASE_STAGGER_US 2500  // Each servo's pulse starts this long after the previous one's (0 = together)
 
 // GPIO assignments for PWM outputs (if using direct GPIO instead of PCA9685)
 #define PWM_FL_PIN 12  // Front Left
@@ -16,6 +39,19 @@
 #define PWM_RL_PIN 14  // Rear Left
 #define PWM_RR_PIN 15  // Rear Right
 
+// Servo output backend: direct GPIO LEDC (4 servos, 16-bit, a frame rate per
+// servo) or a PCA9685 on the IMU's I2C bus (16 channels, 12-bit, one frame
+// rate for all). Build with -DSERVO_OUTPUT_BACKEND=1 (the esp32_pca9685
+// environment) for the PCA9685.
+#define SERVO_BACKEND_LEDC 0
+#define SERVO_BACKEND_PCA9685 1
+#ifndef SERVO_OUTPUT_BACKEND
+#define SERVO_OUTPUT_BACKEND SERVO_BACKEND_LEDC
+#endif
+#define PCA9685_ADDRESS 0x40
+#define PCA9685_FRAME_HZ PWM_FREQ          // Shared by every channel
+#define PCA9685_OSCILLATOR_HZ 25000000     // Internal oscillator (trim if the measured frame rate is off)
+
 // Default suspension parameters
 #define DEFAULT_REACTION_SPEED 1.0f
 #define DEFAULT_RIDE_HEIGHT 90.0f
@@ -24,12 +60,21 @@
 #define DEFAULT_FRONT_REAR_BALANCE 0.5f
 #define DEFAULT_STIFFNESS 1.0f
 #define DEFAULT_FPV_AUTO_MODE false // FPV auto mode default
+#define PARAMETER_RAMP_MS 500         // Live tuning changes blend in over this time
+#ifndef SUSPENSION_WHEELS
+#define SUSPENSION_WHEELS 4           // Corners in the suspension model: 4, 6 or 8 (see SuspensionSimulator.h)
+#endif
 
 // Default servo calibration parameters
 #define DEFAULT_SERVO_TRIM 0         // No trim offset (degrees)
 #define DEFAULT_SERVO_MIN 15         // Minimum angle (degrees)
 #define DEFAULT_SERVO_MAX 165        // Maximum angle (degrees)
 #define DEFAULT_SERVO_REVERSED false // Standard rotation direction
+#define DEFAULT_SERVO_REFRESH_HZ PWM_FREQ  // Analog servos; digital ones accept up to PWM_MAX_FREQ
+#define DEFAULT_SERVO_MAX_VELOCITY 600       // Slew limit (deg/s, 0 = unlimited): about a standard servo's no-load speed
+#define DEFAULT_SERVO_MAX_ACCELERATION 6000  // Acceleration limit (deg/s^2, 0 = unlimited): full speed in 0.1 s
+#define SERVO_MAX_VELOCITY_LIMIT 2000        // Largest settable limits
+#define SERVO_MAX_ACCELERATION_LIMIT 50000
 
 // Battery monitoring configuration
 #define BATTERY_ADC_PIN_A 34  // GPIO 34 (ADC1_CH6)
@@ -57,6 +102,42 @@
 #define WIFI_AP_GATEWAY 192, 168, 4, 1
 #define WIFI_AP_SUBNET 255, 255, 255, 0
 
+// Math: 1 = bounded-error approximations for atan2/asin/sqrt on the fusion
+// hot path (see FastMath.h), 0 = libm
+#ifndef SUSPENSION_FAST_MATH
+#define SUSPENSION_FAST_MATH 1
+#endif
+
+// Control path arithmetic: 1 = Q16.16 integers from the raw IMU counts to
+// the PWM duty (complementary fusion, decimation, suspension model, servo
+// mapping; see FixedPoint.h), 0 = float. Float is the default because the
+// ESP32 has a single-precision FPU; build with -DSUSPENSION_FIXED_POINT=1
+// (the esp32_fixed environment) to compare.
+#ifndef SUSPENSION_FIXED_POINT
+#define SUSPENSION_FIXED_POINT 0
+#endif
+
+// Task layout: on the ESP32 the control loop runs in its own task pinned to
+// one core, and web/storage/battery work runs in a service task on the other.
+// The native build runs both from loop() on a single thread.
+#ifndef SUSPENSION_DUAL_CORE
+#ifdef NATIVE_BUILD
+#define SUSPENSION_DUAL_CORE 0
+#else
+#define SUSPENSION_DUAL_CORE 1
+#endif
+#endif
+#define CONTROL_TASK_CORE 1
+#define CONTROL_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define CONTROL_TASK_STACK_SIZE 4096
+#define SERVICE_TASK_CORE 0   // Same core as WiFi and AsyncTCP
+#define SERVICE_TASK_PRIORITY 2
+#define SERVICE_TASK_STACK_SIZE 8192
+#define SERVICE_TASK_PERIOD_MS 10
+#define IMU_TASK_CORE CONTROL_TASK_CORE
+#define IMU_TASK_PRIORITY (configMAX_PRIORITIES - 1)  // Short bursts, must not miss the FIFO
+#define IMU_TASK_STACK_SIZE 3072
+
 // Storage configuration
 #define CONFIG_SPIFFS_PATH "/config.json"
 
@@ -71,6 +152,34 @@ enum MPU6050Orientation {
 };
 
 #define DEFAULT_MPU6050_ORIENTATION ARROW_FORWARD_UP
+#define DEFAULT_MOUNT_TRIM 0.0f     // Board misalignment on the chassis (degrees)
+
+// Sensor fusion engine (see SensorFusion.h)
+enum FusionMode {
+  FUSION_COMPLEMENTARY = 0,  // Euler-angle complementary filter
+  FUSION_MAHONY = 1          // Quaternion filter with gyro-bias estimation
+};
+
+#define DEFAULT_FUSION_MODE FUSION_COMPLEMENTARY
+
+// Suspension model (see SuspensionSimulator.h)
+enum SimulationMode {
+  SIMULATION_KINEMATIC = 0,   // Target positions through a 1st-order smoothing filter
+  SIMULATION_QUARTER_CAR = 1  // Spring-damper-mass per corner, integrated with sub-steps
+};
+
+#define DEFAULT_SIMULATION_MODE SIMULATION_KINEMATIC
+#define QUARTER_CAR_FREQUENCY_HZ 3.0f    // Corner natural frequency at reactionSpeed 1.0 (scales with it)
+#define QUARTER_CAR_DAMPING_RATIO 0.7f   // Fraction of critical damping
+#define QUARTER_CAR_MAX_STEP_S 0.0025f   // Longest integrator step; each tick is split into sub-steps
+#define QUARTER_CAR_MAX_SUBSTEPS 16
+
+// Predictive actuation (see ActuationPredictor.h): servo lag model and how
+// much of it to lead by
+#define DEFAULT_SERVO_LATENCY_MS 20.0f        // Dead time from PWM update to the servo starting to move
+#define DEFAULT_SERVO_TIME_CONSTANT_MS 15.0f  // First-order lag of the servo once it moves
+#define DEFAULT_PREDICTION_GAIN 1.0f          // 0 = command the current position, 1 = lead by the full lag
+#define PREDICTION_MAX_LEAD_DEG 15.0f         // Largest correction the predictor may add to a corner
 
 // Data structures
 struct SuspensionConfig {
@@ -82,6 +191,14 @@ struct SuspensionConfig {
   float stiffness;
   uint16_t sampleRate;
   uint8_t mpuOrientation;  // MPU6050 mounting orientation
+  float mountRollTrim;     // Residual board misalignment (degrees)
+  float mountPitchTrim;
+  float mountYawTrim;
+  uint8_t fusionMode;      // FusionMode
+  uint8_t simulationMode;  // SimulationMode
+  float servoLatencyMs;       // Servo lag model for predictive actuation
+  float servoTimeConstantMs;
+  float predictionGain;
   bool fpvAutoMode;        // FPV auto mode persistent setting
 };
 
@@ -91,6 +208,9 @@ struct ServoCalibration {
   uint8_t minLimit;   // Minimum angle (0-90 degrees)
   uint8_t maxLimit;   // Maximum angle (90-180 degrees)
   bool reversed;      // Reverse direction flag
+  uint16_t refreshHz; // PWM frame rate (PWM_FREQ to PWM_MAX_FREQ)
+  uint16_t maxVelocity;     // Command slew limit in deg/s (0 = unlimited, see MotionLimiter.h)
+  uint16_t maxAcceleration; // Command acceleration limit in deg/s^2 (0 = unlimited)
 };
 
 struct ServoConfig {
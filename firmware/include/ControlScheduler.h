@@ -0,0 +1,86 @@
+#ifndef CONTROL_SCHEDULER_H
+#define CONTROL_SCHEDULER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Fixed-rate tick scheduler with microsecond timing.
+//
+// Deadlines sit on a fixed grid (start + k * period), so a late tick does not
+// shift the ones after it. Missed ticks are run back to back to catch up, up
+// to MAX_CATCHUP_TICKS; beyond that they are dropped, but the grid phase is
+// kept. All arithmetic is wrap-safe for the 32-bit micros() counter.
+class ControlScheduler {
+public:
+  static constexpr uint32_t MAX_CATCHUP_TICKS = 2;
+
+  struct Stats {
+    uint32_t ticks = 0;          // Ticks executed
+    uint32_t lateTicks = 0;      // Ticks that started a full period or more behind their deadline
+    uint32_t skippedTicks = 0;   // Ticks dropped because we fell too far behind
+    uint32_t overruns = 0;       // Ticks whose execution took longer than one period
+    uint32_t maxJitterUs = 0;    // Worst start lateness
+    uint32_t maxExecUs = 0;      // Worst execution time
+    float meanJitterUs = 0.0f;   // Running mean of start lateness
+  };
+
+private:
+  uint32_t periodUs = 1000000 / SUSPENSION_SAMPLE_RATE_HZ;
+  uint32_t nextDeadlineUs = 0;
+  uint32_t tickStartUs = 0;
+  Stats stats;
+
+public:
+  void init(uint16_t rateHz, uint32_t nowUs) {
+    if (rateHz == 0) rateHz = SUSPENSION_SAMPLE_RATE_HZ;
+    periodUs = 1000000UL / rateHz;
+    nextDeadlineUs = nowUs + periodUs;
+    stats = Stats();
+  }
+
+  // Returns true when a tick is due; the caller must then run the tick and
+  // call endTick(). Advances the deadline grid.
+  bool beginTick(uint32_t nowUs) {
+    int32_t lateness = (int32_t)(nowUs - nextDeadlineUs);
+    if (lateness < 0) return false;
+
+    if ((uint32_t)lateness >= periodUs) {
+      stats.lateTicks++;
+      uint32_t missed = (uint32_t)lateness / periodUs;
+      if (missed > MAX_CATCHUP_TICKS) {
+        // Too far behind: drop the excess ticks but stay on the grid
+        uint32_t dropped = missed - MAX_CATCHUP_TICKS;
+        nextDeadlineUs += dropped * periodUs;
+        stats.skippedTicks += dropped;
+        lateness = (int32_t)(nowUs - nextDeadlineUs);
+      }
+    }
+
+    stats.ticks++;
+    if ((uint32_t)lateness > stats.maxJitterUs) stats.maxJitterUs = (uint32_t)lateness;
+    stats.meanJitterUs += ((float)lateness - stats.meanJitterUs) / stats.ticks;
+
+    tickStartUs = nowUs;
+    nextDeadlineUs += periodUs;
+    return true;
+  }
+
+  void endTick(uint32_t nowUs) {
+    uint32_t execUs = nowUs - tickStartUs;
+    if (execUs > stats.maxExecUs) stats.maxExecUs = execUs;
+    if (execUs > periodUs) stats.overruns++;
+  }
+
+  // Time left until the next deadline (0 if a tick is already due)
+  uint32_t microsUntilNext(uint32_t nowUs) const {
+    int32_t remaining = (int32_t)(nextDeadlineUs - nowUs);
+    return remaining > 0 ? (uint32_t)remaining : 0;
+  }
+
+  uint32_t getPeriodUs() const { return periodUs; }
+  float getPeriodSeconds() const { return periodUs * 1e-6f; }
+  const Stats& getStats() const { return stats; }
+  void resetStats() { stats = Stats(); }
+};
+
+#endif
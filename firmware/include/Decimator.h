@@ -0,0 +1,145 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <cmath>
+#include <cstddef>
+#include "FixedPoint.h"
+
+// 2nd-order Butterworth low-pass coefficients (bilinear transform with
+// prewarping, Q = 1/sqrt(2)) for a cutoff at `cutoffFraction` of the output
+// Nyquist frequency. Degenerates to a pass-through when there is nothing to
+// remove.
+struct LowPassCoefficients {
+  float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+  static LowPassCoefficients design(float inputRateHz, float outputRateHz, float cutoffFraction) {
+    LowPassCoefficients c;
+    float cutoffHz = cutoffFraction * 0.5f * outputRateHz;
+    if (cutoffHz < 0.45f * inputRateHz) {
+      const float q = 0.70710678f;
+      float k = tanf((float)M_PI * cutoffHz / inputRateHz);
+      float norm = 1.0f / (1.0f + k / q + k * k);
+      c.b0 = k * k * norm;
+      c.b1 = 2.0f * c.b0;
+      c.b2 = c.b0;
+      c.a1 = 2.0f * (k * k - 1.0f) * norm;
+      c.a2 = (1.0f - k / q + k * k) * norm;
+    }
+    return c;
+  }
+};
+
+// Anti-aliasing low-pass between two pipeline rates.
+//
+// The producer pushes every sample at the input rate; the consumer reads
+// output() whenever it runs at its own, lower rate. A 2nd-order Butterworth
+// section per channel (transposed direct form II) removes content above
+// `cutoffFraction` of the output Nyquist frequency, so reading at the lower
+// rate doesn't fold vibration into the band the consumer acts on.
+template<size_t Channels>
+class Decimator {
+private:
+  float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+  float z1[Channels] = {};
+  float z2[Channels] = {};
+  float out[Channels] = {};
+  bool primed = false;
+
+public:
+  void init(float inputRateHz, float outputRateHz, float cutoffFraction = 0.8f) {
+    LowPassCoefficients c = LowPassCoefficients::design(inputRateHz, outputRateHz, cutoffFraction);
+    b0 = c.b0;
+    b1 = c.b1;
+    b2 = c.b2;
+    a1 = c.a1;
+    a2 = c.a2;
+    primed = false;
+  }
+
+  // Settle the filter on a constant input (no start-up transient)
+  void reset(const float value[Channels]) {
+    for (size_t c = 0; c < Channels; c++) {
+      z1[c] = value[c] * (1.0f - b0);
+      z2[c] = value[c] * (b2 - a2);
+      out[c] = value[c];
+    }
+    primed = true;
+  }
+
+  void push(const float in[Channels]) {
+    if (!primed) {
+      reset(in);
+      return;
+    }
+    for (size_t c = 0; c < Channels; c++) {
+      float x = in[c];
+      float y = b0 * x + z1[c];
+      z1[c] = b1 * x - a1 * y + z2[c];
+      z2[c] = b2 * x - a2 * y;
+      out[c] = y;
+    }
+  }
+
+  const float* output() const { return out; }
+  float output(size_t channel) const { return out[channel]; }
+};
+
+// Integer twin of Decimator for the fixed-point path: the same filter on
+// Q16.16 samples. Direct form I with Q28 coefficients and 64-bit
+// accumulators, so the recursion carries no rounding in its state beyond
+// the Q16 output itself.
+template<size_t Channels>
+class FixedDecimator {
+private:
+  static constexpr int COEFFICIENT_BITS = 28;
+
+  int32_t b0 = 1 << COEFFICIENT_BITS, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+  fixedPoint::q16_t x1[Channels] = {};
+  fixedPoint::q16_t x2[Channels] = {};
+  fixedPoint::q16_t y1[Channels] = {};
+  fixedPoint::q16_t y2[Channels] = {};
+  bool primed = false;
+
+  static int32_t toCoefficient(float value) {
+    return (int32_t)lroundf(value * (float)(1 << COEFFICIENT_BITS));
+  }
+
+public:
+  void init(float inputRateHz, float outputRateHz, float cutoffFraction = 0.8f) {
+    LowPassCoefficients c = LowPassCoefficients::design(inputRateHz, outputRateHz, cutoffFraction);
+    b0 = toCoefficient(c.b0);
+    b1 = toCoefficient(c.b1);
+    b2 = toCoefficient(c.b2);
+    a1 = toCoefficient(c.a1);
+    a2 = toCoefficient(c.a2);
+    primed = false;
+  }
+
+  void reset(const fixedPoint::q16_t value[Channels]) {
+    for (size_t c = 0; c < Channels; c++) {
+      x1[c] = x2[c] = y1[c] = y2[c] = value[c];
+    }
+    primed = true;
+  }
+
+  void push(const fixedPoint::q16_t in[Channels]) {
+    if (!primed) {
+      reset(in);
+      return;
+    }
+    for (size_t c = 0; c < Channels; c++) {
+      int64_t acc = (int64_t)b0 * in[c] + (int64_t)b1 * x1[c] + (int64_t)b2 * x2[c]
+                  - (int64_t)a1 * y1[c] - (int64_t)a2 * y2[c];
+      fixedPoint::q16_t y = (fixedPoint::q16_t)((acc + (1 << (COEFFICIENT_BITS - 1))) >> COEFFICIENT_BITS);
+      x2[c] = x1[c];
+      x1[c] = in[c];
+      y2[c] = y1[c];
+      y1[c] = y;
+    }
+  }
+
+  const fixedPoint::q16_t* output() const { return y1; }
+  fixedPoint::q16_t output(size_t channel) const { return y1[channel]; }
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "Config.h"
+
+// Bounded-error replacements for the libm calls on the fusion hot path.
+//
+// The ESP32's FPU has no divide or square-root instruction, so sqrtf and
+// atan2f run as long software sequences. The approximations here cost a few
+// multiplies each:
+//
+//   approxAtan2   |error| < 3e-6 rad (0.0002 deg) over the whole plane
+//   approxAsin    |error| < 5e-6 rad for |x| <= 1
+//   approxInvSqrt relative error < 5e-6 for normal floats (two Newton steps)
+//   approxSqrt    relative error < 5e-6 for normal floats
+//
+// The bench checks these bounds against libm (see bench/MathAccuracy.h).
+// Firmware code calls the unprefixed wrappers, which map to the
+// approximations or to libm depending on SUSPENSION_FAST_MATH.
+namespace fastMath {
+
+constexpr float PI_F = 3.14159265f;
+constexpr float HALF_PI_F = 1.57079633f;
+
+// Documented error bounds (checked by the bench)
+constexpr double ATAN2_MAX_ERROR_RAD = 3e-6;
+constexpr double ASIN_MAX_ERROR_RAD = 5e-6;
+constexpr double SQRT_MAX_RELATIVE_ERROR = 5e-6;
+
+// atan on [-1, 1], odd minimax polynomial
+inline float atanUnit(float z) {
+  float z2 = z * z;
+  return z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f + z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+}
+
+inline float approxAtan2(float y, float x) {
+  float ax = fabsf(x), ay = fabsf(y);
+  if (ax == 0.0f && ay == 0.0f) return 0.0f;
+
+  // Reduce to an argument in [0, 1], then unfold the octant
+  float angle;
+  if (ay <= ax) {
+    angle = atanUnit(ay / ax);
+  } else {
+    angle = HALF_PI_F - atanUnit(ax / ay);
+  }
+  if (x < 0.0f) angle = PI_F - angle;
+  return y < 0.0f ? -angle : angle;
+}
+
+inline float approxInvSqrt(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  bits = 0x5f375a86u - (bits >> 1);
+  float y;
+  memcpy(&y, &bits, sizeof(y));
+  float halfX = 0.5f * x;
+  y = y * (1.5f - halfX * y * y);
+  y = y * (1.5f - halfX * y * y);
+  return y;
+}
+
+inline float approxSqrt(float x) {
+  return x > 0.0f ? x * approxInvSqrt(x) : 0.0f;
+}
+
+inline float approxAsin(float x) {
+  if (x >= 1.0f) return HALF_PI_F;
+  if (x <= -1.0f) return -HALF_PI_F;
+  return approxAtan2(x, approxSqrt(1.0f - x * x));
+}
+
+#if SUSPENSION_FAST_MATH
+inline float atan2(float y, float x) { return approxAtan2(y, x); }
+inline float asin(float x) { return approxAsin(x); }
+inline float sqrt(float x) { return approxSqrt(x); }
+inline float invSqrt(float x) { return approxInvSqrt(x); }
+#else
+inline float atan2(float y, float x) { return atan2f(y, x); }
+inline float asin(float x) { return asinf(x); }
+inline float sqrt(float x) { return sqrtf(x); }
+inline float invSqrt(float x) { return 1.0f / sqrtf(x); }
+#endif
+
+}  // namespace fastMath
+
+#endif
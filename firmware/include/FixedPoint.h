@@ -0,0 +1,140 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <cstdint>
+#include "Config.h"
+
+// Q16.16 arithmetic for the optional integer control path
+// (SUSPENSION_FIXED_POINT).
+//
+// Angles are carried in degrees, accelerations in g and servo positions in
+// degrees, all as Q16.16 (1.0 = 65536): +/-32768 of range and 1.5e-5 of
+// resolution, plenty for +/-180 degrees. Products go through 64-bit
+// intermediates. Filter weights that stay within [0, 1] use Q30.
+//
+// atan2Deg() is a 20-step CORDIC in vectoring mode. It needs only shifts,
+// adds and a small table, and gives the magnitude of (x, y) for free, which
+// the pitch angle needs. Its error is below ATAN2_MAX_ERROR_DEG for vectors
+// of at least 1000 counts (0.06 g on the accelerometer); the bench
+// checks this and compares the whole fixed-point path with the float one
+// (see bench/FixedPointCheck.h).
+namespace fixedPoint {
+
+typedef int32_t q16_t;
+
+constexpr int FRACTION_BITS = 16;
+constexpr q16_t ONE = (q16_t)1 << FRACTION_BITS;
+constexpr int WEIGHT_BITS = 30;  // Q30 filter weights
+constexpr int32_t WEIGHT_ONE = (int32_t)1 << WEIGHT_BITS;
+
+// Documented error bounds (checked by the bench): the CORDIC atan2, and the
+// largest difference from the float path over the bench traces at each stage
+constexpr double ATAN2_MAX_ERROR_DEG = 1e-3;
+constexpr double MAGNITUDE_MAX_RELATIVE_ERROR = 6e-4;
+constexpr double ATTITUDE_TOLERANCE_DEG = 0.005;   // Decimated roll/pitch
+constexpr double VERTICAL_TOLERANCE_G = 0.001;   // Decimated vertical acceleration
+constexpr double CORNER_TOLERANCE_DEG = 0.005;     // Suspension model and predicted servo positions
+constexpr int32_t DUTY_TOLERANCE_COUNTS = 1;     // LEDC duty written
+
+inline q16_t fromFloat(float value) {
+  return (q16_t)(value * (float)ONE + (value >= 0.0f ? 0.5f : -0.5f));
+}
+
+inline float toFloat(q16_t value) {
+  return (float)value * (1.0f / ONE);
+}
+
+inline q16_t fromInt(int32_t value) {
+  return value * ONE;
+}
+
+// Truncating conversion to an integer, like a float -> int cast for positive values
+inline int32_t toInt(q16_t value) {
+  return value >> FRACTION_BITS;
+}
+
+inline q16_t mul(q16_t a, q16_t b) {
+  return (q16_t)(((int64_t)a * b) >> FRACTION_BITS);
+}
+
+inline q16_t clamp(q16_t value, q16_t low, q16_t high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+// Filter weight in Q30 from a float in [0, 1] (set-up time only)
+inline int32_t weightFromFloat(float weight) {
+  return (int32_t)(weight * (float)WEIGHT_ONE + 0.5f);
+}
+
+// a + weight * (b - a), with the weight in Q30. Rounded: a truncating shift
+// would bias slow filters (small weights) by up to half an LSB per step.
+inline q16_t blend(q16_t a, q16_t b, int32_t weight) {
+  return a + (q16_t)(((int64_t)(b - a) * weight + (1 << (WEIGHT_BITS - 1))) >> WEIGHT_BITS);
+}
+
+// floor(sqrt(value)), one result bit per step (at most 32). The square root
+// of a Q32.32 value is its Q16.16 square root.
+inline uint32_t sqrt64(uint64_t value) {
+  uint64_t root = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+  while (bit > value) bit >>= 2;
+  while (bit) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+// CORDIC rotation angles atan(2^-i), degrees in Q16.16
+constexpr int CORDIC_STEPS = 20;
+static const int32_t CORDIC_ANGLES[CORDIC_STEPS] = {
+  2949120, 1740967, 919879, 466945, 234379, 117304, 58666, 29335, 14668, 7334,
+  3667, 1833, 917, 458, 229, 115, 57, 29, 14, 7
+};
+constexpr int32_t CORDIC_INV_GAIN_Q30 = 652032874;  // 1 / prod(sqrt(1 + 2^-2i))
+constexpr int CORDIC_HEADROOM_BITS = 9;             // Extra input precision for the late steps
+
+// atan2(y, x) in degrees (Q16.16, -180..180) for integer inputs of up to
+// +/-2^20 (raw sensor counts). If `magnitude` is given it receives
+// sqrt(x^2 + y^2) in the inputs' units.
+inline q16_t atan2Deg(int32_t y, int32_t x, int32_t* magnitude = nullptr) {
+  if (x == 0 && y == 0) {
+    if (magnitude) *magnitude = 0;
+    return 0;
+  }
+
+  // Fold into the right half-plane, then rotate (x, y) onto the x axis
+  q16_t angle = 0;
+  if (x < 0) {
+    angle = y >= 0 ? fromInt(180) : fromInt(-180);
+    x = -x;
+    y = -y;
+  }
+  x <<= CORDIC_HEADROOM_BITS;
+  y <<= CORDIC_HEADROOM_BITS;
+  for (int i = 0; i < CORDIC_STEPS; i++) {
+    // Rotate towards the x axis; the direction is applied as a conditional
+    // negate (mask = 0 or -1) so the loop has no data-dependent branches
+    int32_t mask = -(int32_t)(y <= 0);
+    int32_t dx = ((y >> i) ^ mask) - mask;
+    int32_t dy = ((x >> i) ^ mask) - mask;
+    x += dx;
+    y -= dy;
+    angle += (CORDIC_ANGLES[i] ^ mask) - mask;
+  }
+
+  if (magnitude) {
+    const int shift = WEIGHT_BITS + CORDIC_HEADROOM_BITS;
+    *magnitude = (int32_t)(((int64_t)x * CORDIC_INV_GAIN_Q30 + ((int64_t)1 << (shift - 1))) >> shift);
+  }
+  return angle;
+}
+
+}  // namespace fixedPoint
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef HISTORY_RING_H
+#define HISTORY_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Lock-free fixed-capacity history: one writer task, any number of readers.
+//
+// Every push() gets the next sequence number (1, 2, 3...) and overwrites the
+// oldest entry once the ring is full. Readers copy entries by sequence
+// number without ever blocking the writer: each slot carries the sequence
+// number it holds, cleared while the writer is filling it, and a read is
+// only valid if that number was the one asked for both before and after
+// the copy (a per-slot seqlock). A reader that falls a whole lap behind
+// simply gets false. Capacity must be a power of two; T must be trivially
+// copyable.
+template<typename T, size_t Capacity>
+class HistoryRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+  static constexpr size_t MASK = Capacity - 1;
+
+  struct Slot {
+    std::atomic<uint32_t> sequence{0};  // 0 while empty or being written
+    T value;
+  };
+
+  Slot slots[Capacity];
+  std::atomic<uint32_t> latest{0};  // Newest complete entry (0: none yet)
+
+public:
+  // Writer side; returns the entry's sequence number
+  uint32_t push(const T& value) {
+    const uint32_t sequence = latest.load(std::memory_order_relaxed) + 1;
+    Slot& slot = slots[sequence & MASK];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.value, &value, sizeof(T));
+    slot.sequence.store(sequence, std::memory_order_release);
+    latest.store(sequence, std::memory_order_release);
+    return sequence;
+  }
+
+  // Copy entry `sequence` into `value`; false if it is not (or no longer)
+  // in the ring
+  bool read(uint32_t sequence, T& value) const {
+    if (sequence == 0) return false;
+    const Slot& slot = slots[sequence & MASK];
+    if (slot.sequence.load(std::memory_order_acquire) != sequence) return false;
+    memcpy(&value, &slot.value, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+  }
+
+  uint32_t latestSequence() const { return latest.load(std::memory_order_acquire); }
+
+  // Oldest entry still held, as of latestSequence() (0: none yet)
+  uint32_t oldestSequence() const {
+    const uint32_t newest = latestSequence();
+    if (newest == 0) return 0;
+    return newest > Capacity ? newest - Capacity + 1 : 1;
+  }
+
+  static constexpr size_t capacity() { return Capacity; }
+};
+
+#endif
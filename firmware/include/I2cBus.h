@@ -0,0 +1,70 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <mutex>
+
+// Arbitration for the I2C bus shared by the MPU6050 (ImuAcquisition) and an
+// I2C servo driver (Pca9685ServoBackend).
+//
+// Each client wraps a complete exchange in a Transaction (the FIFO count and
+// burst read, or one servo frame), so no other task can slip a transfer in
+// between a register address and its data. The lock is a mutex, which has
+// priority inheritance on FreeRTOS: if the acquisition task wakes while the
+// control task is mid-frame, the control task is boosted to finish its
+// short burst first; and since the control task runs below the acquisition
+// task on the same core, it only ever starts a frame between IMU bursts.
+// Waits are counted so bus contention shows up in the stats.
+class I2cBus {
+public:
+  struct Stats {
+    uint32_t transactions = 0;  // Exchanges completed
+    uint32_t contended = 0;     // Exchanges that had to wait for another client
+    uint32_t maxWaitUs = 0;     // Longest such wait
+  };
+
+  // Holds the bus for its lifetime (no-op without a bus)
+  class Transaction {
+  private:
+    I2cBus* bus;
+
+  public:
+    explicit Transaction(I2cBus* owner) : bus(owner) {
+      if (bus) bus->acquire();
+    }
+    ~Transaction() {
+      if (bus) bus->release();
+    }
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+  };
+
+private:
+  TwoWire& wire;
+  std::mutex mutex;
+  Stats stats;
+
+  void acquire() {
+    if (!mutex.try_lock()) {
+      uint32_t startUs = micros();
+      mutex.lock();
+      uint32_t waitedUs = micros() - startUs;
+      stats.contended++;
+      if (waitedUs > stats.maxWaitUs) stats.maxWaitUs = waitedUs;
+    }
+    stats.transactions++;
+  }
+
+  void release() { mutex.unlock(); }
+
+public:
+  explicit I2cBus(TwoWire& bus) : wire(bus) {}
+
+  // The underlying bus, for use inside a Transaction
+  TwoWire& getWire() { return wire; }
+
+  const Stats& getStats() const { return stats; }
+};
+
+#endif
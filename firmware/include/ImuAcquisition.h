@@ -0,0 +1,241 @@
+#ifndef IMU_ACQUISITION_H
+#define IMU_ACQUISITION_H
+
+#include <Arduino.h>
+#include <MPU6050.h>
+#include <atomic>
+#include "Config.h"
+#include "I2cBus.h"
+#include "SpscQueue.h"
+
+// One raw MPU6050 reading with the time it was sampled
+struct ImuSample {
+  uint32_t timestampUs;  // micros() time base
+  int16_t ax, ay, az;
+  int16_t gx, gy, gz;
+};
+
+// Background IMU acquisition.
+//
+// The MPU6050 samples on its own clock into its internal FIFO (accel + gyro,
+// 12 bytes per frame) and pulses its INT pin on every new sample. The ISR only
+// records when that happened and, every IMU_BURST_SAMPLES samples, wakes the
+// acquisition task, which drains the FIFO in one burst read and queues the
+// samples for the control loop. Frame timestamps are reconstructed backwards
+// from the newest data-ready edge at the configured sample period.
+//
+// Without the INT pin wired (IMU_INT_PIN < 0) the task polls on a timer
+// instead and timestamps against the time of the read. The native build has
+// no tasks or interrupts; there service() is called from loop(). If the bus
+// is shared (I2cBus), each drain holds it from the FIFO count to the last
+// byte read.
+class ImuAcquisition {
+public:
+  struct Stats {
+    uint32_t samples = 0;         // Samples queued for the control loop
+    uint32_t bursts = 0;          // FIFO drains that returned data
+    uint32_t fifoOverflows = 0;   // FIFO filled up before we drained it (data lost)
+    uint32_t ringDrops = 0;       // Samples dropped because the control loop fell behind
+    uint32_t reconfigures = 0;    // Recovery attempts after the sensor stopped producing data
+  };
+
+private:
+  static constexpr uint16_t FIFO_SIZE = 1024;
+  static constexpr uint8_t FRAME_SIZE = 12;
+  static constexpr uint8_t MAX_BURST_FRAMES = 10;  // 120 bytes, inside the I2C driver's 128-byte buffer
+
+  MPU6050* mpu = nullptr;
+  I2cBus* bus = nullptr;
+  uint16_t rateHz = IMU_SAMPLE_RATE_HZ;
+  uint32_t periodUs = 1000000UL / IMU_SAMPLE_RATE_HZ;
+  int8_t interruptPin = -1;
+
+  SpscQueue<ImuSample, IMU_RING_CAPACITY> ring;  // acquisition -> control
+
+  // Written by the data-ready ISR
+  volatile uint32_t dataReadyUs = 0;
+  volatile uint32_t dataReadyCount = 0;
+
+  uint32_t lastDataUs = 0;
+  uint32_t lastConfigureUs = 0;
+  std::atomic<bool> receiving{false};
+  Stats stats;
+
+#ifndef NATIVE_BUILD
+  TaskHandle_t taskHandle = nullptr;
+
+  static void IRAM_ATTR onDataReady(void* arg) {
+    ImuAcquisition* self = static_cast<ImuAcquisition*>(arg);
+    self->dataReadyUs = micros();
+    uint32_t count = self->dataReadyCount + 1;
+    self->dataReadyCount = count;
+    if (self->taskHandle && count % IMU_BURST_SAMPLES == 0) {
+      BaseType_t woken = pdFALSE;
+      vTaskNotifyGiveFromISR(self->taskHandle, &woken);
+      if (woken) portYIELD_FROM_ISR();
+    }
+  }
+
+  static void taskEntry(void* parameter) {
+    ImuAcquisition* self = static_cast<ImuAcquisition*>(parameter);
+    uint32_t burstMs = (uint32_t)IMU_BURST_SAMPLES * 1000 / self->rateHz;
+    if (burstMs == 0) burstMs = 1;
+    for (;;) {
+      if (self->interruptPin >= 0) {
+        // Timeout keeps stall detection alive if the interrupts stop
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(burstMs * 2));
+      } else {
+        vTaskDelay(pdMS_TO_TICKS(burstMs));
+      }
+      self->service();
+    }
+  }
+#endif
+
+  // Sample rate, DLPF, FIFO contents and data-ready interrupt
+  void configure() {
+    mpu->setDLPFMode(IMU_DLPF_MODE);  // Gyro output rate is 1 kHz with the DLPF on
+    mpu->setRate((uint8_t)(1000 / rateHz - 1));
+    mpu->setFullScaleAccelRange(MPU6050_ACCEL_FS_2);
+    mpu->setFullScaleGyroRange(MPU6050_GYRO_FS_250);
+
+    mpu->setFIFOEnabled(false);
+    mpu->setTempFIFOEnabled(false);
+    mpu->setAccelFIFOEnabled(true);
+    mpu->setXGyroFIFOEnabled(true);
+    mpu->setYGyroFIFOEnabled(true);
+    mpu->setZGyroFIFOEnabled(true);
+    mpu->resetFIFO();
+    mpu->setFIFOEnabled(true);
+
+    mpu->setInterruptMode(false);   // Active high
+    mpu->setInterruptDrive(false);  // Push-pull
+    mpu->setInterruptLatch(false);  // 50 us pulse, no status read needed to clear
+    mpu->setIntDataReadyEnabled(true);
+
+    lastConfigureUs = micros();
+  }
+
+  static int16_t readBigEndian(const uint8_t* p) { return (int16_t)((p[0] << 8) | p[1]); }
+
+public:
+  // Configure the sensor and start sampling. On the ESP32 call startTask()
+  // afterwards; natively call service() regularly instead.
+  void begin(MPU6050& sensor, uint16_t sampleRateHz, int8_t intPin, I2cBus* sharedBus = nullptr) {
+    mpu = &sensor;
+    bus = sharedBus;
+    if (sampleRateHz < 4) sampleRateHz = 4;
+    if (sampleRateHz > 1000) sampleRateHz = 1000;
+    rateHz = sampleRateHz;
+    periodUs = 1000000UL / rateHz;
+    interruptPin = intPin;
+
+    configure();
+    lastDataUs = micros();
+
+#ifndef NATIVE_BUILD
+    if (interruptPin >= 0) {
+      pinMode(interruptPin, INPUT);
+      attachInterruptArg(interruptPin, onDataReady, this, RISING);
+    }
+#endif
+  }
+
+#ifndef NATIVE_BUILD
+  void startTask() {
+    xTaskCreatePinnedToCore(taskEntry, "imu", IMU_TASK_STACK_SIZE, this,
+                            IMU_TASK_PRIORITY, &taskHandle, IMU_TASK_CORE);
+  }
+#endif
+
+  // Drain whatever the FIFO holds into the ring buffer (acquisition side)
+  void service() {
+    if (!mpu) return;
+    I2cBus::Transaction transaction(bus);
+
+    // Take the FIFO level together with the newest data-ready edge; retry if
+    // a sample landed in between so the two refer to the same frame
+    uint32_t edgeCount, edgeUs;
+    uint16_t bytes;
+    uint8_t attempts = 0;
+    do {
+      edgeCount = dataReadyCount;
+      edgeUs = dataReadyUs;
+      bytes = mpu->getFIFOCount();
+    } while (edgeCount != dataReadyCount && ++attempts < 3);
+    uint32_t nowUs = micros();
+    uint32_t newestUs = (interruptPin >= 0 && edgeCount != 0) ? edgeUs : nowUs;
+
+    if (bytes >= FIFO_SIZE - FRAME_SIZE || bytes % FRAME_SIZE != 0) {
+      // Overflowed (oldest frames already overwritten) or misaligned: start over
+      if (bytes >= FIFO_SIZE - FRAME_SIZE) stats.fifoOverflows++;
+      mpu->resetFIFO();
+      return;
+    }
+
+    uint16_t frames = bytes / FRAME_SIZE;
+    if (frames == 0) {
+      if (nowUs - lastDataUs > IMU_STALL_TIMEOUT_MS * 1000UL) {
+        // Sensor went quiet (unplugged or reset): report it and periodically
+        // try to bring the FIFO back up
+        receiving.store(false);
+        if (nowUs - lastConfigureUs > IMU_RECONFIGURE_INTERVAL_MS * 1000UL) {
+          mpu->initialize();
+          if (mpu->testConnection()) configure();
+          lastConfigureUs = nowUs;
+          stats.reconfigures++;
+        }
+      }
+      return;
+    }
+
+    uint8_t buffer[MAX_BURST_FRAMES * FRAME_SIZE];
+    uint16_t remaining = frames;
+    bool gotData = false;
+    while (remaining > 0) {
+      uint8_t chunk = remaining > MAX_BURST_FRAMES ? MAX_BURST_FRAMES : (uint8_t)remaining;
+      mpu->getFIFOBytes(buffer, chunk * FRAME_SIZE);
+      for (uint8_t i = 0; i < chunk; i++) {
+        const uint8_t* frame = buffer + i * FRAME_SIZE;
+        remaining--;
+
+        ImuSample sample;
+        sample.timestampUs = newestUs - remaining * periodUs;
+        sample.ax = readBigEndian(frame);
+        sample.ay = readBigEndian(frame + 2);
+        sample.az = readBigEndian(frame + 4);
+        sample.gx = readBigEndian(frame + 6);
+        sample.gy = readBigEndian(frame + 8);
+        sample.gz = readBigEndian(frame + 10);
+
+        // An all-zero frame is what a failed I2C read leaves behind
+        if (!sample.ax && !sample.ay && !sample.az && !sample.gx && !sample.gy && !sample.gz) continue;
+
+        gotData = true;
+        if (ring.push(sample)) {
+          stats.samples++;
+        } else {
+          stats.ringDrops++;
+        }
+      }
+    }
+
+    if (gotData) {
+      stats.bursts++;
+      lastDataUs = nowUs;
+      receiving.store(true);
+    }
+  }
+
+  // Next sample in time order (control side)
+  bool pop(ImuSample& sample) { return ring.pop(sample); }
+
+  // False once the sensor has produced no data for IMU_STALL_TIMEOUT_MS
+  bool isReceiving() const { return receiving.load(); }
+
+  uint16_t getRateHz() const { return rateHz; }
+  uint32_t getPeriodUs() const { return periodUs; }
+  const Stats& getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+// Writes JSON straight into a caller-owned buffer (no heap allocation), for
+// responses built from config structs and sensor values.
+//
+//   JsonWriter json(buffer, sizeof(buffer));
+//   json.beginObject();
+//   json.key("roll").value(roll, 1);
+//   json.key("batteries").beginArray().value(12.6f, 2).endArray();
+//   json.endObject();
+//   if (json.ok()) send(json.c_str(), json.size());
+//
+// Commas are inserted automatically. Floats are written with the given
+// number of decimals, or with up to 7 significant digits when decimals is
+// negative; NaN and infinity become null. Output that does not fit sets an
+// overflow flag and ok() returns false.
+class JsonWriter {
+private:
+  static constexpr uint8_t MAX_DEPTH = 16;
+
+  char* out;
+  size_t capacity;
+  size_t length = 0;
+  bool overflow = false;
+  uint8_t depth = 0;
+  uint16_t hasMembers = 0;    // Bit per nesting level: next member needs a comma
+  bool afterKey = false;
+
+  void put(const char* text, size_t count) {
+    if (overflow || length + count >= capacity) {
+      overflow = true;
+      return;
+    }
+    memcpy(out + length, text, count);
+    length += count;
+    out[length] = '\0';
+  }
+
+  void put(char c) { put(&c, 1); }
+
+  // Comma before every member or element but the first
+  void separate() {
+    if (afterKey) {
+      afterKey = false;
+      return;
+    }
+    const uint16_t bit = 1u << depth;
+    if (hasMembers & bit) put(',');
+    hasMembers |= bit;
+  }
+
+  void open(char bracket) {
+    separate();
+    put(bracket);
+    if (depth + 1 >= MAX_DEPTH) {
+      overflow = true;
+      return;
+    }
+    depth++;
+    hasMembers &= ~(1u << depth);
+  }
+
+  void close(char bracket) {
+    if (depth == 0) {
+      overflow = true;
+      return;
+    }
+    depth--;
+    put(bracket);
+  }
+
+  __attribute__((format(printf, 2, 3))) void putFormatted(const char* format, ...) {
+    if (overflow) return;
+    va_list args;
+    va_start(args, format);
+    const int count = vsnprintf(out + length, capacity - length, format, args);
+    va_end(args);
+    if (count < 0 || length + count >= capacity) {
+      overflow = true;
+      out[length] = '\0';
+      return;
+    }
+    length += count;
+  }
+
+  void putString(const char* text) {
+    put('"');
+    for (const char* p = text; *p; p++) {
+      const unsigned char c = (unsigned char)*p;
+      if (c == '"' || c == '\\') {
+        put('\\');
+        put((char)c);
+      } else if (c < 0x20) {
+        putFormatted("\\u%04x", c);
+      } else {
+        put((char)c);
+      }
+    }
+    put('"');
+  }
+
+public:
+  JsonWriter(char* buffer, size_t size) : out(buffer), capacity(size) {
+    if (capacity) out[0] = '\0';
+    else overflow = true;
+  }
+
+  JsonWriter& beginObject() { open('{'); return *this; }
+  JsonWriter& endObject() { close('}'); return *this; }
+  JsonWriter& beginArray() { open('['); return *this; }
+  JsonWriter& endArray() { close(']'); return *this; }
+
+  // Member name; follow with a value or beginObject()/beginArray()
+  JsonWriter& key(const char* name) {
+    separate();
+    putString(name);
+    put(':');
+    afterKey = true;
+    return *this;
+  }
+
+  JsonWriter& value(float number, int decimals = -1) {
+    separate();
+    if (!std::isfinite(number)) put("null", 4);
+    else if (decimals < 0) putFormatted("%.7g", number);
+    else putFormatted("%.*f", decimals, number);
+    return *this;
+  }
+
+  template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+  JsonWriter& value(T number) {
+    separate();
+    if (std::is_signed<T>::value) putFormatted("%ld", (long)number);
+    else putFormatted("%lu", (unsigned long)number);
+    return *this;
+  }
+
+  JsonWriter& value(bool flag) {
+    separate();
+    if (flag) put("true", 4);
+    else put("false", 5);
+    return *this;
+  }
+
+  JsonWriter& value(const char* text) {
+    separate();
+    putString(text);
+    return *this;
+  }
+
+  // True if everything fit and every object/array was closed
+  bool ok() const { return !overflow && depth == 0; }
+  size_t size() const { return length; }
+  const char* c_str() const { return out; }
+};
+
+#endif
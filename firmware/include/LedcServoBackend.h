@@ -0,0 +1,76 @@
+#ifndef LEDC_SERVO_BACKEND_H
+#define LEDC_SERVO_BACKEND_H
+
+#include "Config.h"
+#include "ServoBackend.h"
+#include <Arduino.h>
+#include <driver/ledc.h>
+
+// Servo pulses from the ESP32's LEDC peripheral on direct GPIOs: four
+// servos at 16-bit resolution, each on its own timer so each can run its own
+// frame rate. The phase is the LEDC hpoint.
+class LedcServoBackend : public ServoBackend {
+public:
+  static constexpr uint8_t CHANNELS = 4;
+  
+  // LEDC channel driving each servo. Channels 2n and 2n+1 share a timer, so
+  // using every other one gives each servo its own timer and frame rate.
+  static uint8_t ledcChannel(uint8_t servo) { return servo * 2; }
+  
+private:
+  // The same channels as the IDF driver sees them (Arduino channels 0-7 are
+  // the high-speed group, channel 2n runs on timer n)
+  static constexpr ledc_mode_t LEDC_MODE = LEDC_HIGH_SPEED_MODE;
+  static ledc_channel_t driverChannel(uint8_t servo) { return (ledc_channel_t)ledcChannel(servo); }
+  static ledc_timer_t driverTimer(uint8_t servo) { return (ledc_timer_t)servo; }
+  
+  uint8_t pins[CHANNELS] = {PWM_FL_PIN, PWM_FR_PIN, PWM_RL_PIN, PWM_RR_PIN};
+  uint16_t refreshHz[CHANNELS] = {};
+  
+public:
+  bool begin() override {
+    for (uint8_t i = 0; i < CHANNELS; i++) {
+      setRefreshRate(i, PWM_FREQ);
+      ledcAttachPin(pins[i], ledcChannel(i));
+    }
+    return true;
+  }
+  
+  uint8_t channelCount() const override { return CHANNELS; }
+  
+  uint16_t setRefreshRate(uint8_t channel, uint16_t hz) override {
+    if (channel >= CHANNELS) return 0;
+    refreshHz[channel] = hz;
+    ledcSetup(ledcChannel(channel), hz, PWM_RESOLUTION_BITS);
+    return hz;
+  }
+  
+  float countsPerMicrosecond(uint8_t channel) const override {
+    return (float)(1UL << PWM_RESOLUTION_BITS) * refreshHz[channel] / 1e6f;
+  }
+  
+  uint32_t frameCounts(uint8_t channel) const override { return 1UL << PWM_RESOLUTION_BITS; }
+  
+  // Restart all timers back to back
+  void alignFrames() override {
+    for (uint8_t i = 0; i < CHANNELS; i++) ledc_timer_rst(LEDC_MODE, driverTimer(i));
+  }
+  
+  void write(uint8_t channel, uint32_t duty, uint32_t phase) override {
+    if (channel >= CHANNELS) return;
+    ledc_set_duty_with_hpoint(LEDC_MODE, driverChannel(channel), duty, phase);
+    ledc_update_duty(LEDC_MODE, driverChannel(channel));
+  }
+  
+  // Load every servo's duty first, then release them back to back. The LEDC
+  // takes a released duty at that channel's next period boundary, so a pulse
+  // already in flight keeps its width and each servo's next pulse carries
+  // this frame's command, never a mix of two frames.
+  void writeFrame(const uint32_t* duty, const uint32_t* phase, uint8_t count) override {
+    if (count > CHANNELS) count = CHANNELS;
+    for (uint8_t i = 0; i < count; i++) ledc_set_duty_with_hpoint(LEDC_MODE, driverChannel(i), duty[i], phase[i]);
+    for (uint8_t i = 0; i < count; i++) ledc_update_duty(LEDC_MODE, driverChannel(i));
+  }
+};
+
+#endif
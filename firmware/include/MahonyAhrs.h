@@ -0,0 +1,130 @@
+#ifndef MAHONY_AHRS_H
+#define MAHONY_AHRS_H
+
+#include <cmath>
+#include "FastMath.h"
+
+// Mahony quaternion attitude filter (6-axis, no magnetometer).
+//
+// Works in the vehicle frame after axis remapping: right-handed, x forward,
+// z up, accelerometer reading +1 g on z when level. The gyro is integrated
+// as a quaternion; the accelerometer's gravity direction corrects the drift
+// through a PI loop, whose integral term doubles as the gyro-bias estimate.
+// Yaw is not observable from gravity, so only the part of the z bias seen
+// while tilted is corrected.
+//
+// Angles follow SensorFusion's conventions: roll positive with the left side
+// up, pitch positive nose up.
+class MahonyAhrs {
+public:
+  static constexpr float DEFAULT_KP = 1.0f;       // Proportional gain (rad/s per unit gravity error)
+  static constexpr float DEFAULT_KI = 0.2f;       // Integral gain (bias estimation)
+  static constexpr float ACCEL_REJECT_G = 0.25f;  // Skip correction when |a| is this far from 1 g
+  static constexpr float MAX_BIAS_RAD_S = 0.1f;   // Clamp on the bias estimate (~5.7 deg/s)
+
+private:
+  float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;
+  float biasX = 0.0f, biasY = 0.0f, biasZ = 0.0f;  // Estimated gyro bias (rad/s)
+  float kp = DEFAULT_KP;
+  float ki = DEFAULT_KI;
+
+  // Gravity ("up") direction in the vehicle frame, from the last update
+  float upX = 0.0f, upY = 0.0f, upZ = 1.0f;
+
+  static float clampBias(float b) {
+    return b > MAX_BIAS_RAD_S ? MAX_BIAS_RAD_S : (b < -MAX_BIAS_RAD_S ? -MAX_BIAS_RAD_S : b);
+  }
+
+  void updateUp() {
+    upX = 2.0f * (q1 * q3 - q0 * q2);
+    upY = 2.0f * (q0 * q1 + q2 * q3);
+    upZ = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+  }
+
+public:
+  void setGains(float proportional, float integral) {
+    kp = proportional;
+    ki = integral;
+  }
+
+  // Start from a known attitude (degrees), keeping the bias estimate
+  void reset(float rollDeg, float pitchDeg, float yawDeg) {
+    const float halfDegToRad = 0.5f * 0.0174532925f;
+    float cr = cosf(rollDeg * halfDegToRad), sr = sinf(rollDeg * halfDegToRad);
+    float cp = cosf(-pitchDeg * halfDegToRad), sp = sinf(-pitchDeg * halfDegToRad);
+    float cy = cosf(yawDeg * halfDegToRad), sy = sinf(yawDeg * halfDegToRad);
+    q0 = cr * cp * cy + sr * sp * sy;
+    q1 = sr * cp * cy - cr * sp * sy;
+    q2 = cr * sp * cy + sr * cp * sy;
+    q3 = cr * cp * sy - sr * sp * cy;
+    updateUp();
+  }
+
+  // Accel in g, gyro in rad/s
+  void update(float ax, float ay, float az, float gx, float gy, float gz, float dt) {
+    // Gravity error: cross product of measured and estimated up directions.
+    // Skipped while the accelerometer sees much more than gravity (bumps).
+    float normSq = ax * ax + ay * ay + az * az;
+    float lowG = 1.0f - ACCEL_REJECT_G, highG = 1.0f + ACCEL_REJECT_G;
+    if (normSq > lowG * lowG && normSq < highG * highG) {
+      float invNorm = fastMath::invSqrt(normSq);
+      ax *= invNorm;
+      ay *= invNorm;
+      az *= invNorm;
+
+      float ex = ay * upZ - az * upY;
+      float ey = az * upX - ax * upZ;
+      float ez = ax * upY - ay * upX;
+
+      if (ki > 0.0f) {
+        biasX = clampBias(biasX - ki * ex * dt);
+        biasY = clampBias(biasY - ki * ey * dt);
+        biasZ = clampBias(biasZ - ki * ez * dt);
+      }
+      gx += kp * ex;
+      gy += kp * ey;
+      gz += kp * ez;
+    }
+
+    gx -= biasX;
+    gy -= biasY;
+    gz -= biasZ;
+
+    // Integrate q' = 0.5 * q * (0, g)
+    float h = 0.5f * dt;
+    float a = q0, b = q1, c = q2;
+    q0 += (-b * gx - c * gy - q3 * gz) * h;
+    q1 += (a * gx + c * gz - q3 * gy) * h;
+    q2 += (a * gy - b * gz + q3 * gx) * h;
+    q3 += (a * gz + b * gy - c * gx) * h;
+
+    float invNorm = fastMath::invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= invNorm;
+    q1 *= invNorm;
+    q2 *= invNorm;
+    q3 *= invNorm;
+
+    updateUp();
+  }
+
+  float getRoll() const { return fastMath::atan2(upY, upZ) * 57.2957795f; }
+  float getPitch() const {
+    float s = upX > 1.0f ? 1.0f : (upX < -1.0f ? -1.0f : upX);
+    return fastMath::asin(s) * 57.2957795f;
+  }
+  float getYaw() const {
+    return fastMath::atan2(2.0f * (q1 * q2 + q0 * q3), q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3) * 57.2957795f;
+  }
+
+  // World-frame vertical specific force minus gravity (g), for a
+  // vehicle-frame accelerometer reading in g
+  float verticalAcceleration(float ax, float ay, float az) const {
+    return ax * upX + ay * upY + az * upZ - 1.0f;
+  }
+
+  float getBiasX() const { return biasX; }
+  float getBiasY() const { return biasY; }
+  float getBiasZ() const { return biasZ; }
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef MOTION_LIMITER_H
+#define MOTION_LIMITER_H
+
+#include "Config.h"
+#include "FixedPoint.h"
+#include "SuspensionSimulator.h"
+#include <cmath>
+#include <cstdlib>
+
+// Motion profiling between ActuationPredictor and PWMOutputs.
+//
+// Each servo command is limited to the servo's maxVelocity (deg/s) and
+// maxAcceleration (deg/s^2) from its ServoCalibration, so a step from a
+// config change or an IMU glitch turns into a ramp the servo (and its
+// supply) can follow. Per tick and channel the cost is one square root:
+//
+//   brake  = largest approach speed that can still stop on the target,
+//            (sqrt(a^2 + 8 a |error|) - a) / 2 for a step change of a
+//   wanted = target's own step + sign(error) * brake, within +/-maxVelocity
+//   step   = wanted, within the last step +/- a
+//
+// Braking along that curve lands exactly on a still target (no overshoot).
+// A command that moves within the limits, and is already being tracked, is
+// passed through unchanged, so normal suspension motion sees no delay. A
+// limit of 0 disables it; with both 0 the stage is a passthrough.
+class MotionLimiter {
+public:
+  static constexpr uint8_t MAX_CHANNELS = SuspensionSimulator::MAX_CORNERS;
+  
+private:
+  // Limits per control tick: largest step and largest change of step (0 = none)
+  float maxStep[MAX_CHANNELS] = {};
+  float maxStepChange[MAX_CHANNELS] = {};
+  fixedPoint::q16_t maxStepQ[MAX_CHANNELS] = {};
+  fixedPoint::q16_t maxStepChangeQ[MAX_CHANNELS] = {};
+  
+  // Output position, its last step and the last target, per channel
+  float position[MAX_CHANNELS] = {};
+  float velocity[MAX_CHANNELS] = {};
+  float lastTarget[MAX_CHANNELS] = {};
+  fixedPoint::q16_t positionQ[MAX_CHANNELS] = {};
+  fixedPoint::q16_t velocityQ[MAX_CHANNELS] = {};
+  fixedPoint::q16_t lastTargetQ[MAX_CHANNELS] = {};
+  
+  float step(uint8_t channel, float target) {
+    const float vMax = maxStep[channel], a = maxStepChange[channel];
+    float targetStep = target - lastTarget[channel];
+    lastTarget[channel] = target;
+    const float error = target - position[channel];
+    
+    float v = error;
+    if (a <= 0.0f) {
+      if (vMax > 0.0f) v = constrain(error, -vMax, vMax);
+    } else {
+      const float previous = velocity[channel];
+      if (vMax > 0.0f) targetStep = constrain(targetStep, -vMax, vMax);
+      // Land on the target when that is one step away at an allowed
+      // speed change, and the next step can match the target's speed
+      if (fabsf(error - previous) > a || fabsf(error - targetStep) > a || (vMax > 0.0f && fabsf(error) > vMax)) {
+        const float brake = 0.5f * (sqrtf(a * a + 8.0f * a * fabsf(error)) - a);
+        float wanted = targetStep + (error < 0.0f ? -brake : brake);
+        if (vMax > 0.0f) wanted = constrain(wanted, -vMax, vMax);
+        v = constrain(wanted, previous - a, previous + a);
+      }
+    }
+    velocity[channel] = v;
+    position[channel] = v == error ? target : position[channel] + v;
+    return position[channel];
+  }
+  
+  fixedPoint::q16_t stepFixed(uint8_t channel, fixedPoint::q16_t target) {
+    const fixedPoint::q16_t vMax = maxStepQ[channel], a = maxStepChangeQ[channel];
+    fixedPoint::q16_t targetStep = target - lastTargetQ[channel];
+    lastTargetQ[channel] = target;
+    const fixedPoint::q16_t error = target - positionQ[channel];
+    
+    fixedPoint::q16_t v = error;
+    if (a <= 0) {
+      if (vMax > 0) v = fixedPoint::clamp(error, -vMax, vMax);
+    } else {
+      const fixedPoint::q16_t previous = velocityQ[channel];
+      if (vMax > 0) targetStep = fixedPoint::clamp(targetStep, -vMax, vMax);
+      if (abs(error - previous) > a || abs(error - targetStep) > a || (vMax > 0 && abs(error) > vMax)) {
+        // a^2 + 8 a |error| in Q32.32, so its integer square root is Q16.16
+        const uint64_t square = (uint64_t)((int64_t)a * a) + 8 * (uint64_t)((int64_t)a * abs(error));
+        const fixedPoint::q16_t brake = ((fixedPoint::q16_t)fixedPoint::sqrt64(square) - a) >> 1;
+        fixedPoint::q16_t wanted = targetStep + (error < 0 ? -brake : brake);
+        if (vMax > 0) wanted = fixedPoint::clamp(wanted, -vMax, vMax);
+        v = fixedPoint::clamp(wanted, previous - a, previous + a);
+      }
+    }
+    velocityQ[channel] = v;
+    positionQ[channel] += v;
+    position[channel] = fixedPoint::toFloat(positionQ[channel]);
+    return positionQ[channel];
+  }
+  
+public:
+  MotionLimiter() { reset(90.0f); }
+  
+  // Set one channel's limits (deg/s, deg/s^2, 0 = unlimited) for a control
+  // period. Keeps the channel's motion state.
+  void setLimits(uint8_t channel, uint16_t maxVelocity, uint16_t maxAcceleration, uint32_t controlPeriodUs) {
+    if (channel >= MAX_CHANNELS) return;
+    const float dt = controlPeriodUs * 1e-6f;
+    maxStep[channel] = maxVelocity * dt;
+    maxStepChange[channel] = maxAcceleration * dt * dt;
+    // At least one LSB, so a tiny limit does not round to "unlimited"
+    const fixedPoint::q16_t stepQ = fixedPoint::fromFloat(maxStep[channel]);
+    const fixedPoint::q16_t stepChangeQ = fixedPoint::fromFloat(maxStepChange[channel]);
+    maxStepQ[channel] = maxVelocity ? (stepQ > 0 ? stepQ : 1) : 0;
+    maxStepChangeQ[channel] = maxAcceleration ? (stepChangeQ > 0 ? stepChangeQ : 1) : 0;
+  }
+  
+  // Take the limits of the four corner servos (on config changes).
+  // Middle-axle servos keep the defaults.
+  void configure(const ServoConfig& servos, uint32_t controlPeriodUs) {
+    const ServoCalibration* corners[4] = {&servos.frontLeft, &servos.frontRight, &servos.rearLeft, &servos.rearRight};
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+      if (i < 4) setLimits(i, corners[i]->maxVelocity, corners[i]->maxAcceleration, controlPeriodUs);
+      else setLimits(i, DEFAULT_SERVO_MAX_VELOCITY, DEFAULT_SERVO_MAX_ACCELERATION, controlPeriodUs);
+    }
+  }
+  
+  // Every channel at rest at `angle` (PWMOutputs starts the servos centered)
+  void reset(float angle) {
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+      position[i] = lastTarget[i] = angle;
+      velocity[i] = 0.0f;
+      positionQ[i] = lastTargetQ[i] = fixedPoint::fromFloat(angle);
+      velocityQ[i] = 0;
+    }
+  }
+  
+  // Limit one control tick's servo commands (degrees) in place
+  void limit(float* commands, uint8_t count) {
+    for (uint8_t i = 0; i < count && i < MAX_CHANNELS; i++) commands[i] = step(i, commands[i]);
+  }
+  
+  // The same for Q16.16 commands. Also refreshes the float outputs.
+  void limitFixed(fixedPoint::q16_t* commands, uint8_t count) {
+    for (uint8_t i = 0; i < count && i < MAX_CHANNELS; i++) commands[i] = stepFixed(i, commands[i]);
+  }
+  
+  // Limited commands from the last tick (degrees)
+  float getOutput(uint8_t channel) const { return position[channel]; }
+  fixedPoint::q16_t getOutputQ16(uint8_t channel) const { return positionQ[channel]; }
+};
+
+#endif
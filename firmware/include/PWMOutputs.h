@@ -2,77 +2,214 @@
 #define PWM_OUTPUTS_H
 
 #include "Config.h"
+#include "FixedPoint.h"
+#include "LedcServoBackend.h"
+#include "ServoBackend.h"
 #include <Arduino.h>
+#include <cmath>
 
 class PWMOutputs {
+public:
+  // One servo per suspension corner (SuspensionSimulator::MAX_CORNERS); how
+  // many are driven depends on the backend and SUSPENSION_WHEELS
+  static constexpr uint8_t MAX_CHANNELS = 8;
+  
 private:
-  // PWM channel assignments (using direct GPIO PWM)
-  uint8_t channels[4] = {PWM_FL_PIN, PWM_FR_PIN, PWM_RL_PIN, PWM_RR_PIN};
+  // Pulse hardware: direct GPIO LEDC unless init() is given another backend
+  LedcServoBackend ledc;
+  ServoBackend* backend = &ledc;
+  uint8_t channelCount = 0;
   
   // PWM parameters for servo control
-  // ESP32 PWM: 50 Hz for servos (20ms period)
+  // 50 Hz for analog servos (20ms period), up to 333 Hz (3ms) for digital ones
   // Min pulse: 1ms (0°), Max pulse: 2ms (180°), Center: 1.5ms (90°)
-  static constexpr uint32_t PWM_BASE_FREQ = 50;  // 50 Hz
-  static constexpr uint8_t SUSPENSION_PWM_RESOLUTION = 8;   // 8-bit (0-255)
+  // With 16-bit LEDC one degree is 18 counts at 50 Hz (121 at 333 Hz)
+  
+  // Microseconds -> backend counts for each channel's frame rate
+  uint16_t refreshHz[MAX_CHANNELS] = {};
+  float countsPerMicrosecond[MAX_CHANNELS] = {};
+  float minPulseCounts[MAX_CHANNELS] = {};
+  float maxPulseCounts[MAX_CHANNELS] = {};
+  
+  // Phase staggering: servo i's pulse starts i * staggerUs into the frame,
+  // limited so the longest pulse still ends inside it. The frames are
+  // aligned across channels so servos at the same frame rate keep these
+  // offsets.
+  uint16_t staggerUs = SERVO_PHASE_STAGGER_US;
+  uint32_t phase[MAX_CHANNELS] = {};
+  
+  // Each servo's calibration (trim, limits, reversal) and frame rate folded
+  // into one affine map from model angle to backend counts, rebuilt by
+  // compile() whenever either changes. The limits clamp the angle before a
+  // monotonic map, so they can be applied to the counts instead:
+  //   counts = clamp(offset + gain * angle, low, high)
+  ServoCalibration calibration[MAX_CHANNELS] = {};
+  float offset[MAX_CHANNELS] = {};
+  float gain[MAX_CHANNELS] = {};
+  float low[MAX_CHANNELS] = {};
+  float high[MAX_CHANNELS] = {};
+  int64_t offsetQ16[MAX_CHANNELS] = {};   // The same in Q16.16 counts, for the fixed-point writes
+  int32_t gainQ16[MAX_CHANNELS] = {};     // (64-bit: 333 Hz pulses exceed 32767 counts)
+  int64_t lowQ16[MAX_CHANNELS] = {};
+  int64_t highQ16[MAX_CHANNELS] = {};
+  
+  void compile(uint8_t channel) {
+    const ServoCalibration& cal = calibration[channel];
+    const float countsPerDegree = (maxPulseCounts[channel] - minPulseCounts[channel]) / 180.0f;
+    float minAngle = constrain((float)cal.minLimit, 0.0f, 180.0f);
+    float maxAngle = constrain((float)cal.maxLimit, minAngle, 180.0f);
+    
+    // angle + trim, limited, then mirrored if reversed
+    float sign = cal.reversed ? -1.0f : 1.0f;
+    float origin = cal.reversed ? 180.0f - cal.trim : (float)cal.trim;
+    if (cal.reversed) {
+      float mirroredMin = 180.0f - maxAngle;
+      maxAngle = 180.0f - minAngle;
+      minAngle = mirroredMin;
+    }
+    offset[channel] = minPulseCounts[channel] + origin * countsPerDegree;
+    gain[channel] = sign * countsPerDegree;
+    low[channel] = minPulseCounts[channel] + minAngle * countsPerDegree;
+    high[channel] = minPulseCounts[channel] + maxAngle * countsPerDegree;
+    
+    offsetQ16[channel] = llround((double)offset[channel] * fixedPoint::ONE);
+    gainQ16[channel] = fixedPoint::fromFloat(gain[channel]);
+    lowQ16[channel] = llround((double)low[channel] * fixedPoint::ONE);
+    highQ16[channel] = llround((double)high[channel] * fixedPoint::ONE);
+  }
+  
+  void updatePhase(uint8_t channel) {
+    const float latest = backend->frameCounts(channel) - maxPulseCounts[channel];
+    const float start = (float)channel * staggerUs * countsPerMicrosecond[channel];
+    phase[channel] = (uint32_t)((start < latest ? start : latest) + 0.5f);
+  }
+  
+  uint32_t dutyFor(uint8_t channel, float angle) const {
+    float counts = offset[channel] + gain[channel] * angle;
+    counts = counts < low[channel] ? low[channel] : (counts > high[channel] ? high[channel] : counts);
+    return (uint32_t)(counts + 0.5f);
+  }
+  
+  uint32_t dutyForFixed(uint8_t channel, fixedPoint::q16_t angle) const {
+    int64_t counts = offsetQ16[channel] + (((int64_t)angle * gainQ16[channel]) >> fixedPoint::FRACTION_BITS);
+    counts = counts < lowQ16[channel] ? lowQ16[channel] : (counts > highQ16[channel] ? highQ16[channel] : counts);
+    return (uint32_t)((counts + (fixedPoint::ONE >> 1)) >> fixedPoint::FRACTION_BITS);
+  }
   
 public:
-  void init() {
-    // Configure PWM pins
-    for (int i = 0; i < 4; i++) {
-      ledcSetup(i, PWM_BASE_FREQ, SUSPENSION_PWM_RESOLUTION);
-      ledcAttachPin(channels[i], i);
-      ledcWrite(i, 128);  // Initialize to center (1.5ms)
+  PWMOutputs() = default;
+  PWMOutputs(const PWMOutputs&) = delete;  // `backend` may point at our own `ledc`
+  PWMOutputs& operator=(const PWMOutputs&) = delete;
+  
+  void init() { init(ledc); }
+  
+  // Drive the servos through `outputs` (see ServoBackend.h). Every channel
+  // starts at full travel and centered until configure().
+  bool init(ServoBackend& outputs) {
+    backend = &outputs;
+    if (!backend->begin()) {
+      Serial.println("PWM outputs not responding");
+      return false;
+    }
+    uint8_t count = backend->channelCount();
+    count = count < MAX_CHANNELS ? count : MAX_CHANNELS;
+    channelCount = count < SUSPENSION_WHEELS ? count : SUSPENSION_WHEELS;
+    for (uint8_t i = 0; i < channelCount; i++) {
+      calibration[i] = {0, 0, 180, false, PWM_FREQ, 0, 0};
+      setRefreshRate(i, PWM_FREQ);
+      setChannelMicroseconds(i, (SERVO_MIN_PULSE_US + SERVO_MAX_PULSE_US) / 2);  // Initialize to center (1.5ms)
     }
+    backend->alignFrames();
     Serial.println("PWM outputs initialized");
+    return true;
   }
   
-  void setChannel(uint8_t channel, float angle) {
-    if (channel >= 4) return;
-    
-    // Convert angle (0-180) to PWM value (0-255)
-    // 0° = 1ms = 51 counts (at 50Hz, 8-bit)
-    // 90° = 1.5ms = 76 counts
-    // 180° = 2ms = 102 counts
-    
-    // Map 0-180 degrees to 51-102 PWM counts
-    float pwmValue = 51.0f + (angle / 180.0f) * 51.0f;
-    pwmValue = constrain(pwmValue, 51.0f, 102.0f);
+  uint8_t getChannelCount() const { return channelCount; }
+  
+  // Change a channel's frame rate (PWM_FREQ to PWM_MAX_FREQ, if the backend
+  // allows per-channel rates). Takes effect from the next write.
+  // configure() also realigns the frames, which keeps the phase staggering
+  // between servos at the same rate.
+  void setRefreshRate(uint8_t channel, uint16_t hz) {
+    if (channel >= channelCount) return;
+    hz = constrain(hz, (uint16_t)PWM_FREQ, (uint16_t)PWM_MAX_FREQ);
+    refreshHz[channel] = backend->setRefreshRate(channel, hz);
     
-    ledcWrite(channel, (uint8_t)pwmValue);
+    countsPerMicrosecond[channel] = backend->countsPerMicrosecond(channel);
+    minPulseCounts[channel] = SERVO_MIN_PULSE_US * countsPerMicrosecond[channel];
+    maxPulseCounts[channel] = SERVO_MAX_PULSE_US * countsPerMicrosecond[channel];
+    updatePhase(channel);
+    compile(channel);
   }
   
-  void setChannel(uint8_t channel, float angle, const ServoCalibration& cal) {
-    if (channel >= 4) return;
-    
-    // 1. Apply trim offset
-    angle += cal.trim;
-    
-    // 2. Apply per-servo limits (final authority on safe travel)
-    angle = constrain(angle, (float)cal.minLimit, (float)cal.maxLimit);
-    
-    // 3. Apply reverse if needed
-    if (cal.reversed) {
-      angle = 180.0f - angle;
+  uint16_t getRefreshRate(uint8_t channel) const { return channel < channelCount ? refreshHz[channel] : 0; }
+  
+  // Offset between successive servos' pulses within a frame (0 = all start
+  // together). Takes effect from the next write.
+  void setPhaseStagger(uint16_t microseconds) {
+    staggerUs = microseconds;
+    for (uint8_t i = 0; i < channelCount; i++) updatePhase(i);
+  }
+  
+  uint16_t getPhaseStagger() const { return staggerUs; }
+  
+  // Take a new calibration for one servo (trim, limits, reversal, frame rate)
+  void setCalibration(uint8_t channel, const ServoCalibration& cal) {
+    if (channel >= channelCount) return;
+    calibration[channel] = cal;
+    if (cal.refreshHz != refreshHz[channel]) setRefreshRate(channel, cal.refreshHz);  // Also compiles
+    else compile(channel);
+  }
+  
+  // Take the calibration of the four corner servos (when the config
+  // changes). Middle-axle servos keep the full-travel default.
+  void configure(const ServoConfig& servos) {
+    uint16_t previousHz[MAX_CHANNELS];
+    for (uint8_t i = 0; i < channelCount; i++) previousHz[i] = refreshHz[i];
+    setCalibration(0, servos.frontLeft);
+    setCalibration(1, servos.frontRight);
+    setCalibration(2, servos.rearLeft);
+    setCalibration(3, servos.rearRight);
+    for (uint8_t i = 0; i < channelCount; i++) {
+      if (refreshHz[i] != previousHz[i]) {
+        backend->alignFrames();
+        break;
+      }
     }
-    
-    // 4. Convert to PWM and send
-    float pwmValue = 51.0f + (angle / 180.0f) * 51.0f;
-    pwmValue = constrain(pwmValue, 51.0f, 102.0f);
-    
-    ledcWrite(channel, (uint8_t)pwmValue);
+  }
+  
+  // One control frame: drive every servo to its model angle (0-180 degrees,
+  // getChannelCount() of them) through its calibration, latched together
+  void commitFrame(const float* angles) {
+    uint32_t duty[MAX_CHANNELS];
+    for (uint8_t i = 0; i < channelCount; i++) duty[i] = dutyFor(i, angles[i]);
+    backend->writeFrame(duty, phase, channelCount);
+  }
+  
+  // Fixed-point version of commitFrame() for Q16.16 angles
+  void commitFrameFixed(const fixedPoint::q16_t* angles) {
+    uint32_t duty[MAX_CHANNELS];
+    for (uint8_t i = 0; i < channelCount; i++) duty[i] = dutyForFixed(i, angles[i]);
+    backend->writeFrame(duty, phase, channelCount);
+  }
+  
+  // Drive a single servo to a model angle (0-180 degrees) through its calibration
+  void setChannel(uint8_t channel, float angle) {
+    if (channel >= channelCount) return;
+    backend->write(channel, dutyFor(channel, angle), phase[channel]);
+  }
+  
+  // Fixed-point version of setChannel() for a Q16.16 angle
+  void setChannelFixed(uint8_t channel, fixedPoint::q16_t angle) {
+    if (channel >= channelCount) return;
+    backend->write(channel, dutyForFixed(channel, angle), phase[channel]);
   }
   
   void setChannelMicroseconds(uint8_t channel, uint16_t microseconds) {
-    if (channel >= 4) return;
-    
-    // Convert microseconds to PWM value at 50Hz, 8-bit resolution
-    // 1000us = 51 counts, 2000us = 102 counts
-    // Resolution: 20000us / 256 = 78.125us per count
-    
-    microseconds = constrain(microseconds, (uint16_t)1000, (uint16_t)2000);
-    uint8_t pwmValue = ((microseconds - 1000) / 78.125f) + 51.0f;
+    if (channel >= channelCount) return;
     
-    ledcWrite(channel, pwmValue);
+    microseconds = constrain(microseconds, (uint16_t)SERVO_MIN_PULSE_US, (uint16_t)SERVO_MAX_PULSE_US);
+    backend->write(channel, (uint32_t)(microseconds * countsPerMicrosecond[channel] + 0.5f), phase[channel]);
   }
 };
 
@@ -0,0 +1,126 @@
+#ifndef PCA9685_SERVO_BACKEND_H
+#define PCA9685_SERVO_BACKEND_H
+
+#include "Config.h"
+#include "I2cBus.h"
+#include "ServoBackend.h"
+#include <Arduino.h>
+
+// Servo pulses from a PCA9685 16-channel, 12-bit PWM driver on the I2C bus
+// shared with the MPU6050.
+//
+// All channels share one prescaler, so they run at one frame rate
+// (PCA9685_FRAME_HZ) and per-servo refresh rates are ignored. With
+// auto-increment on, a whole frame goes out as one I2C write starting at
+// LED0_ON_L (4 bytes per channel: ON count = phase, OFF count = phase +
+// duty). MODE2.OCH is left clear so the outputs change on the STOP
+// condition, and the chip applies new ON/OFF values at the end of a
+// channel's cycle, so every channel takes the frame together and a pulse in
+// flight is never cut.
+class Pca9685ServoBackend : public ServoBackend {
+public:
+  static constexpr uint8_t CHANNELS = 16;
+  static constexpr uint32_t FRAME_COUNTS = 4096;
+  
+private:
+  static constexpr uint8_t REG_MODE1 = 0x00;
+  static constexpr uint8_t REG_MODE2 = 0x01;
+  static constexpr uint8_t REG_LED0_ON_L = 0x06;
+  static constexpr uint8_t REG_PRE_SCALE = 0xFE;
+  static constexpr uint8_t MODE1_RESTART = 0x80;
+  static constexpr uint8_t MODE1_AI = 0x20;      // Register auto-increment
+  static constexpr uint8_t MODE1_SLEEP = 0x10;   // Oscillator off (required to change the prescaler)
+  static constexpr uint8_t MODE2_OUTDRV = 0x04;  // Totem-pole outputs
+  static constexpr uint16_t LED_FULL_OFF = 0x1000;
+  
+  I2cBus& bus;
+  uint8_t address;
+  uint16_t requestedHz;
+  uint16_t frameHz = PWM_FREQ;
+  float countsPerUs = 0.0f;
+  uint32_t frames = 0;
+  uint32_t writeErrors = 0;
+  uint8_t buffer[1 + 4 * CHANNELS];
+  
+  static void encode(uint8_t* out, uint32_t duty, uint32_t phase) {
+    uint16_t on = (uint16_t)(phase & (FRAME_COUNTS - 1));
+    uint16_t off = duty ? (uint16_t)((phase + duty) & (FRAME_COUNTS - 1)) : LED_FULL_OFF;
+    out[0] = on & 0xFF;
+    out[1] = on >> 8;
+    out[2] = off & 0xFF;
+    out[3] = off >> 8;
+  }
+  
+  // One write transaction; the caller holds the bus
+  bool transmit(const uint8_t* data, size_t length) {
+    TwoWire& wire = bus.getWire();
+    wire.beginTransmission(address);
+    wire.write(data, length);
+    if (wire.endTransmission() == 0) return true;
+    writeErrors++;
+    return false;
+  }
+  
+  bool writeRegister(uint8_t reg, uint8_t value) {
+    const uint8_t data[2] = {reg, value};
+    return transmit(data, sizeof(data));
+  }
+  
+public:
+  explicit Pca9685ServoBackend(I2cBus& i2c, uint8_t i2cAddress = PCA9685_ADDRESS, uint16_t hz = PCA9685_FRAME_HZ)
+    : bus(i2c), address(i2cAddress), requestedHz(hz) {}
+  
+  // Set the frame rate (the prescaler can only be written while the
+  // oscillator sleeps), wake up, wait for the oscillator, then restart with
+  // auto-increment and totem-pole outputs
+  bool begin() override {
+    uint32_t prescale = (uint32_t)((float)PCA9685_OSCILLATOR_HZ / (FRAME_COUNTS * (float)requestedHz) + 0.5f) - 1;
+    prescale = prescale < 3 ? 3 : (prescale > 255 ? 255 : prescale);
+    frameHz = (uint16_t)((float)PCA9685_OSCILLATOR_HZ / (FRAME_COUNTS * (prescale + 1)) + 0.5f);
+    countsPerUs = (float)PCA9685_OSCILLATOR_HZ / (prescale + 1) / 1e6f;
+    
+    I2cBus::Transaction transaction(&bus);
+    bool ok = writeRegister(REG_MODE1, MODE1_SLEEP | MODE1_AI);
+    ok = ok && writeRegister(REG_PRE_SCALE, (uint8_t)prescale);
+    ok = ok && writeRegister(REG_MODE1, MODE1_AI);
+    delayMicroseconds(500);
+    ok = ok && writeRegister(REG_MODE1, MODE1_AI | MODE1_RESTART);
+    ok = ok && writeRegister(REG_MODE2, MODE2_OUTDRV);
+    return ok;
+  }
+  
+  uint8_t channelCount() const override { return CHANNELS; }
+  
+  uint16_t setRefreshRate(uint8_t channel, uint16_t hz) override { return frameHz; }
+  
+  // From the prescaler actually programmed (e.g. 50.03 Hz for 50)
+  float countsPerMicrosecond(uint8_t channel) const override { return countsPerUs; }
+  
+  uint32_t frameCounts(uint8_t channel) const override { return FRAME_COUNTS; }
+  
+  // One counter drives every channel, so frames are always aligned
+  void alignFrames() override {}
+  
+  void write(uint8_t channel, uint32_t duty, uint32_t phase) override {
+    if (channel >= CHANNELS) return;
+    buffer[0] = REG_LED0_ON_L + 4 * channel;
+    encode(buffer + 1, duty, phase);
+    I2cBus::Transaction transaction(&bus);
+    transmit(buffer, 5);
+  }
+  
+  void writeFrame(const uint32_t* duty, const uint32_t* phase, uint8_t count) override {
+    if (count > CHANNELS) count = CHANNELS;
+    buffer[0] = REG_LED0_ON_L;
+    for (uint8_t i = 0; i < count; i++) encode(buffer + 1 + 4 * i, duty[i], phase[i]);
+    I2cBus::Transaction transaction(&bus);
+    transmit(buffer, 1 + 4 * count);
+    frames++;
+  }
+  
+  uint16_t getFrameRate() const { return frameHz; }
+  uint32_t getFrameCount() const { return frames; }
+  uint32_t getWriteErrors() const { return writeErrors; }
+};
+
+#endif
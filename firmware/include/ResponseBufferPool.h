@@ -0,0 +1,50 @@
+#ifndef RESPONSE_BUFFER_POOL_H
+#define RESPONSE_BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+
+// Fixed buffers for HTTP responses, so building and sending a JSON response
+// needs no heap.
+//
+// A handler acquires a buffer, writes the response into it (JsonWriter.h)
+// and hands it to ESPAsyncWebServer as a callback response that copies from
+// it as the socket drains. The buffer must outlive the response, so it is
+// released from the request's disconnect callback, which ESPAsyncWebServer
+// runs for every request, completed or aborted. acquire() returns nullptr
+// when all buffers are in flight; the caller answers 503.
+template<size_t COUNT, size_t SIZE>
+class ResponseBufferPool {
+private:
+  char buffers[COUNT][SIZE];
+  std::atomic<bool> inUse[COUNT];
+
+public:
+  static constexpr size_t BUFFER_SIZE = SIZE;
+
+  ResponseBufferPool() {
+    for (auto& flag : inUse) flag.store(false);
+  }
+
+  char* acquire() {
+    for (size_t i = 0; i < COUNT; i++) {
+      bool expected = false;
+      if (inUse[i].compare_exchange_strong(expected, true)) return buffers[i];
+    }
+    return nullptr;
+  }
+
+  void release(char* buffer) {
+    for (size_t i = 0; i < COUNT; i++) {
+      if (buffers[i] == buffer) inUse[i].store(false);
+    }
+  }
+
+  size_t available() const {
+    size_t count = 0;
+    for (const auto& flag : inUse) count += !flag.load();
+    return count;
+  }
+};
+
+#endif
@@ -2,19 +2,46 @@
 #define SENSOR_FUSION_H
 
 #include <Arduino.h>
+#include <MPU6050.h>
 #include <cmath>
 #include "Config.h"
+#include "MahonyAhrs.h"
+#include "FastMath.h"
+#include "FixedPoint.h"
 
+// Attitude and vertical acceleration from the MPU6050, with two engines
+// behind the same interface (see FusionMode): the original complementary
+// filter on Euler angles, and a Mahony quaternion filter with gyro-bias
+// estimation and tilt-compensated vertical acceleration.
+//
+// With SUSPENSION_FIXED_POINT, updateRaw() runs the complementary filter on
+// integers from the raw sensor counts to Q16.16 angles (see FixedPoint.h);
+// the Mahony engine always runs in float.
 class SensorFusion {
+public:
+  // MPU6050 scale at the default full-scale ranges (+/-2 g, +/-250 deg/s)
+  static constexpr int32_t ACCEL_COUNTS_PER_G = 16384;
+  static constexpr float GYRO_COUNTS_PER_DPS = 131.0f;
+  
+  // Filter time constants. Expressed in seconds rather than as per-sample
+  // weights so the response doesn't change with the IMU rate (these match
+  // the original 0.95 / 0.9 weights at 25 Hz).
+  static constexpr float ATTITUDE_TIME_CONSTANT = 0.76f;   // Gyro vs. accel crossover (complementary)
+  static constexpr float VERTICAL_TIME_CONSTANT = 0.36f;   // Vertical accel low-pass (both engines)
+
 private:
-  // Complementary filter coefficients
-  static constexpr float ALPHA = 0.95f;  // Accel weight: 5%, Gyro weight: 95%
+  uint8_t mode = DEFAULT_FUSION_MODE;
+  MahonyAhrs ahrs;
   
   // Euler angles
   float roll = 0.0f;
   float pitch = 0.0f;
   float yaw = 0.0f;
   
+  // Roll and pitch rates (deg/s, vehicle frame, same signs as the angles)
+  float rollRate = 0.0f;
+  float pitchRate = 0.0f;
+  
   // Calibration offsets
   float rollOffset = 0.0f;
   float pitchOffset = 0.0f;
@@ -23,69 +50,256 @@ private:
   float verticalAccel = 0.0f;
   float filteredVerticalAccel = 0.0f;
   
-  // Last update time
-  unsigned long lastUpdateTime = 0;
-  float dt = 0.02f;  // Default 50 Hz
+  // Time step of the last update, and the nominal one used when a sample's
+  // own step is missing or implausible
+  float dt = 1.0f / IMU_SAMPLE_RATE_HZ;
+  float nominalDt = 1.0f / IMU_SAMPLE_RATE_HZ;
   
   // Gravity reference
   static constexpr float GRAVITY = 9.81f;
   
-  // MPU6050 orientation
+  // MPU6050 orientation, and the sensor -> vehicle rotation derived from it
+  // (rows: vehicle forward, right, up in sensor axes)
   uint8_t mpuOrientation = ARROW_FORWARD_UP;
+  float mounting[3][3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+  
+  // Non-blocking calibration state (accumulated by update())
+  uint16_t calibrationTotal = 0;
+  uint16_t calibrationRemaining = 0;
+  float calibrationRollSum = 0.0f;
+  float calibrationPitchSum = 0.0f;
+  
+  // Fixed-point complementary filter state (Q16.16 degrees and g). The float
+  // members above are refreshed from it after every fixed-point update.
+  fixedPoint::q16_t rollQ = 0;
+  fixedPoint::q16_t pitchQ = 0;
+  fixedPoint::q16_t yawQ = 0;
+  fixedPoint::q16_t filteredVerticalAccelQ = 0;
+  fixedPoint::q16_t rollRateQ = 0;
+  fixedPoint::q16_t pitchRateQ = 0;
+  fixedPoint::q16_t rollOffsetQ = 0;
+  fixedPoint::q16_t pitchOffsetQ = 0;
+  int16_t mountingQ14[3][3] = {{16384, 0, 0}, {0, 16384, 0}, {0, 0, 16384}};
+  int32_t nominalDtUs = 1000000 / IMU_SAMPLE_RATE_HZ;
+  int32_t weightsDtUs = 0;         // Time step the Q30 weights below were computed for
+  int32_t attitudeWeight = 0;      // Gyro weight, tau / (tau + dt)
+  int32_t verticalWeight = 0;      // Vertical low-pass, dt / (tau + dt)
+  
+  // Gyro counts * microseconds -> Q16.16 degrees, scaled by 2^40
+  static constexpr int GYRO_SCALE_BITS = 40;
+  static constexpr int64_t GYRO_SCALE = (int64_t)(65536.0 / (131.0 * 1e6) * 1099511627776.0 + 0.5);
+  
+  // Gyro counts -> Q16.16 deg/s, scaled by 2^16
+  static constexpr int GYRO_RATE_SCALE_BITS = 16;
+  static constexpr int64_t GYRO_RATE_SCALE = (int64_t)(65536.0 / 131.0 * 65536.0 + 0.5);
   
-  // Remap sensor axes to vehicle axes based on orientation
+  // Remap sensor axes to vehicle axes: one fixed 3x3 rotation, set up by
+  // setMounting() so the per-sample path has no branches
   void remapAxes(float sensorX, float sensorY, float sensorZ, 
-                 float& vehicleForward, float& vehicleRight, float& vehicleUp) {
-    switch (mpuOrientation) {
-      case ARROW_FORWARD_UP:  // Default: Arrow forward, chip up
-        vehicleForward = sensorX;
-        vehicleRight = sensorY;
-        vehicleUp = sensorZ;
-        break;
-      case ARROW_UP_FORWARD:  // Arrow up, chip forward
-        vehicleForward = -sensorZ;
-        vehicleRight = sensorY;
-        vehicleUp = sensorX;
-        break;
-      case ARROW_BACKWARD_UP:  // Arrow backward, chip up
-        vehicleForward = -sensorX;
-        vehicleRight = -sensorY;
-        vehicleUp = sensorZ;
-        break;
-      case ARROW_DOWN_FORWARD:  // Arrow down, chip forward
-        vehicleForward = sensorZ;
-        vehicleRight = sensorY;
-        vehicleUp = -sensorX;
-        break;
-      case ARROW_RIGHT_UP:  // Arrow right, chip up
-        vehicleForward = -sensorY;
-        vehicleRight = sensorX;
-        vehicleUp = sensorZ;
-        break;
-      case ARROW_LEFT_UP:  // Arrow left, chip up
-        vehicleForward = sensorY;
-        vehicleRight = -sensorX;
-        vehicleUp = sensorZ;
-        break;
-      default:
-        vehicleForward = sensorX;
-        vehicleRight = sensorY;
-        vehicleUp = sensorZ;
-        break;
+                 float& vehicleForward, float& vehicleRight, float& vehicleUp) const {
+    vehicleForward = mounting[0][0] * sensorX + mounting[0][1] * sensorY + mounting[0][2] * sensorZ;
+    vehicleRight = mounting[1][0] * sensorX + mounting[1][1] * sensorY + mounting[1][2] * sensorZ;
+    vehicleUp = mounting[2][0] * sensorX + mounting[2][1] * sensorY + mounting[2][2] * sensorZ;
+  }
+  
+  // Raw-count version of remapAxes() for the fixed-point path (Q14 matrix)
+  void remapAxesRaw(int16_t sensorX, int16_t sensorY, int16_t sensorZ,
+                    int32_t& vehicleForward, int32_t& vehicleRight, int32_t& vehicleUp) const {
+    vehicleForward = (mountingQ14[0][0] * sensorX + mountingQ14[0][1] * sensorY + mountingQ14[0][2] * sensorZ + 8192) >> 14;
+    vehicleRight = (mountingQ14[1][0] * sensorX + mountingQ14[1][1] * sensorY + mountingQ14[1][2] * sensorZ + 8192) >> 14;
+    vehicleUp = (mountingQ14[2][0] * sensorX + mountingQ14[2][1] * sensorY + mountingQ14[2][2] * sensorZ + 8192) >> 14;
+  }
+  
+  void setOffsets(float rollDeg, float pitchDeg) {
+    rollOffset = rollDeg;
+    pitchOffset = pitchDeg;
+    rollOffsetQ = fixedPoint::fromFloat(rollDeg);
+    pitchOffsetQ = fixedPoint::fromFloat(pitchDeg);
+  }
+  
+  void addCalibrationSample(float accelRoll, float accelPitch) {
+    calibrationRollSum += accelRoll;
+    calibrationPitchSum += accelPitch;
+    if (--calibrationRemaining == 0) {
+      setOffsets(calibrationRollSum / calibrationTotal, calibrationPitchSum / calibrationTotal);
+    }
+  }
+  
+  // Accelerometer roll/pitch (degrees), also accumulated as the level
+  // reference while a non-blocking calibration is running
+  void accumulateCalibration(float ax, float ay, float az, float* rollOut = nullptr, float* pitchOut = nullptr) {
+    float accelRoll = fastMath::atan2(ay, az) * 57.2957795f;  // rad to deg
+    float accelPitch = fastMath::atan2(ax, fastMath::sqrt(ay * ay + az * az)) * 57.2957795f;
+    if (rollOut) *rollOut = accelRoll;
+    if (pitchOut) *pitchOut = accelPitch;
+    
+    if (calibrationRemaining > 0) {
+      addCalibrationSample(accelRoll, accelPitch);
     }
   }
 
 public:
   void init(uint16_t sampleRate) {
-    dt = 1.0f / sampleRate;
-    lastUpdateTime = millis();
+    nominalDt = 1.0f / sampleRate;
+    dt = nominalDt;
+    nominalDtUs = 1000000 / sampleRate;
   }
   
   void setOrientation(uint8_t orientation) {
-    mpuOrientation = orientation;
+    setMounting(orientation, 0.0f, 0.0f, 0.0f);
+  }
+  
+  // Orientation plus the board's residual misalignment on the vehicle
+  // (degrees, same sign conventions as getRoll/getPitch/getYaw), for mounts
+  // that aren't square to the chassis
+  void setMounting(uint8_t orientation, float rollTrim, float pitchTrim, float yawTrim) {
+    // Axis permutations for the MPU6050Orientation cases
+    static const int8_t ORIENTATION_AXES[6][3][3] = {
+      {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},    // ARROW_FORWARD_UP (default): arrow forward, chip up
+      {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}},   // ARROW_UP_FORWARD: arrow up, chip forward
+      {{-1, 0, 0}, {0, -1, 0}, {0, 0, 1}},  // ARROW_BACKWARD_UP: arrow backward, chip up
+      {{0, 0, 1}, {0, 1, 0}, {-1, 0, 0}},   // ARROW_DOWN_FORWARD: arrow down, chip forward
+      {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},   // ARROW_RIGHT_UP: arrow right, chip up
+      {{0, 1, 0}, {-1, 0, 0}, {0, 0, 1}}    // ARROW_LEFT_UP: arrow left, chip up
+    };
+    
+    mpuOrientation = orientation < 6 ? orientation : (uint8_t)ARROW_FORWARD_UP;
+    const int8_t (&axes)[3][3] = ORIENTATION_AXES[mpuOrientation];
+    
+    // Misalignment rotation R = Rz(yaw) * Ry(-pitch) * Rx(roll); nose-up
+    // pitch is a negative rotation about y
+    float cr = cosf(rollTrim * DEG_TO_RAD), sr = sinf(rollTrim * DEG_TO_RAD);
+    float cp = cosf(-pitchTrim * DEG_TO_RAD), sp = sinf(-pitchTrim * DEG_TO_RAD);
+    float cy = cosf(yawTrim * DEG_TO_RAD), sy = sinf(yawTrim * DEG_TO_RAD);
+    const float trim[3][3] = {
+      {cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr},
+      {sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr},
+      {-sp, cp * sr, cp * cr}
+    };
+    
+    float matrix[3][3];
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        matrix[i][j] = trim[i][0] * axes[0][j] + trim[i][1] * axes[1][j] + trim[i][2] * axes[2][j];
+      }
+    }
+    setMountingMatrix(matrix);
+  }
+  
+  // Arbitrary sensor -> vehicle rotation (rows: vehicle forward, right, up
+  // expressed in sensor axes)
+  void setMountingMatrix(const float matrix[3][3]) {
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        mounting[i][j] = matrix[i][j];
+        mountingQ14[i][j] = (int16_t)lroundf(matrix[i][j] * 16384.0f);
+      }
+    }
+  }
+  
+  // Switch fusion engine; the new one starts from the current attitude
+  void setMode(uint8_t fusionMode) {
+    if (fusionMode == mode) return;
+    if (fusionMode == FUSION_MAHONY) {
+      ahrs.reset(roll, pitch, yaw);
+    } else if (mode == FUSION_MAHONY) {
+      yaw = ahrs.getYaw();
+      syncFixedState();
+    }
+    mode = fusionMode;
+  }
+  
+  uint8_t getMode() const { return mode; }
+  
+  // Fuse one raw MPU6050 sample, with the time step in microseconds. Runs
+  // the fixed-point filter when SUSPENSION_FIXED_POINT is set (complementary
+  // engine), otherwise converts to g and deg/s for update().
+  void updateRaw(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz, int32_t elapsedUs) {
+#if SUSPENSION_FIXED_POINT
+    if (mode != FUSION_MAHONY) {
+      updateFixed(ax, ay, az, gx, gy, gz, elapsedUs);
+      return;
+    }
+#endif
+    const float accelScale = 1.0f / ACCEL_COUNTS_PER_G;
+    update(ax * accelScale, ay * accelScale, az * accelScale,
+           gx / GYRO_COUNTS_PER_DPS, gy / GYRO_COUNTS_PER_DPS, gz / GYRO_COUNTS_PER_DPS, elapsedUs * 1e-6f);
+#if SUSPENSION_FIXED_POINT
+    syncFixedState();  // The control path reads the Q16.16 outputs
+#endif
+  }
+  
+  // The complementary filter in Q16.16, straight from raw counts. Same
+  // filter as update(), yaw wrapped to +/-180 degrees as there. Always compiled
+  // so the bench can compare it with the float path.
+  void updateFixed(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz, int32_t elapsedUs) {
+    if (elapsedUs <= 0 || elapsedUs > 100000) elapsedUs = nominalDtUs;  // Clamp to prevent jumps
+    dt = elapsedUs * 1e-6f;
+    if (elapsedUs != weightsDtUs) {
+      // The IMU delivers a steady rate, so this is rarely recomputed
+      int64_t attitudeTauUs = lroundf(ATTITUDE_TIME_CONSTANT * 1e6f);
+      int64_t verticalTauUs = lroundf(VERTICAL_TIME_CONSTANT * 1e6f);
+      attitudeWeight = (int32_t)((attitudeTauUs << fixedPoint::WEIGHT_BITS) / (attitudeTauUs + elapsedUs));
+      verticalWeight = (int32_t)(((int64_t)elapsedUs << fixedPoint::WEIGHT_BITS) / (verticalTauUs + elapsedUs));
+      weightsDtUs = elapsedUs;
+    }
+    
+    int32_t axVehicle, ayVehicle, azVehicle;
+    int32_t gxVehicle, gyVehicle, gzVehicle;
+    remapAxesRaw(ax, ay, az, axVehicle, ayVehicle, azVehicle);
+    remapAxesRaw(gx, gy, gz, gxVehicle, gyVehicle, gzVehicle);
+    
+    // Accelerometer angles; the CORDIC gives |(y, z)| for the pitch angle
+    int32_t magnitudeYZ;
+    fixedPoint::q16_t accelRoll = fixedPoint::atan2Deg(ayVehicle, azVehicle, &magnitudeYZ);
+    fixedPoint::q16_t accelPitch = fixedPoint::atan2Deg(axVehicle, magnitudeYZ);
+    if (calibrationRemaining > 0) {
+      addCalibrationSample(fixedPoint::toFloat(accelRoll), fixedPoint::toFloat(accelPitch));
+    }
+    
+    // Gyro rotation over this step (nose-up is a negative rotation about y)
+    const int64_t round = (int64_t)1 << (GYRO_SCALE_BITS - 1);
+    fixedPoint::q16_t rollStep = (fixedPoint::q16_t)(((int64_t)gxVehicle * elapsedUs * GYRO_SCALE + round) >> GYRO_SCALE_BITS);
+    fixedPoint::q16_t pitchStep = (fixedPoint::q16_t)(((int64_t)gyVehicle * elapsedUs * GYRO_SCALE + round) >> GYRO_SCALE_BITS);
+    fixedPoint::q16_t yawStep = (fixedPoint::q16_t)(((int64_t)gzVehicle * elapsedUs * GYRO_SCALE + round) >> GYRO_SCALE_BITS);
+    const int64_t rateRound = (int64_t)1 << (GYRO_RATE_SCALE_BITS - 1);
+    rollRateQ = (fixedPoint::q16_t)((gxVehicle * GYRO_RATE_SCALE + rateRound) >> GYRO_RATE_SCALE_BITS);
+    pitchRateQ = -(fixedPoint::q16_t)((gyVehicle * GYRO_RATE_SCALE + rateRound) >> GYRO_RATE_SCALE_BITS);
+    
+    rollQ = fixedPoint::blend(accelRoll, rollQ + rollStep, attitudeWeight);
+    pitchQ = fixedPoint::blend(accelPitch, pitchQ - pitchStep, attitudeWeight);
+    yawQ += yawStep;
+    if (yawQ > fixedPoint::fromInt(180)) yawQ -= fixedPoint::fromInt(360);
+    else if (yawQ < fixedPoint::fromInt(-180)) yawQ += fixedPoint::fromInt(360);
+    
+    // Vertical acceleration (g, gravity removed) through the low-pass
+    fixedPoint::q16_t verticalAccelQ = (azVehicle - ACCEL_COUNTS_PER_G) * (fixedPoint::ONE / ACCEL_COUNTS_PER_G);
+    filteredVerticalAccelQ = fixedPoint::blend(filteredVerticalAccelQ, verticalAccelQ, verticalWeight);
+    
+    roll = fixedPoint::toFloat(rollQ);
+    pitch = fixedPoint::toFloat(pitchQ);
+    yaw = fixedPoint::toFloat(yawQ);
+    filteredVerticalAccel = fixedPoint::toFloat(filteredVerticalAccelQ);
+    rollRate = fixedPoint::toFloat(rollRateQ);
+    pitchRate = fixedPoint::toFloat(pitchRateQ);
   }
   
-  void update(float ax, float ay, float az, float gx, float gy, float gz) {
+  // Carry the float attitude over to the fixed-point filter
+  void syncFixedState() {
+    rollQ = fixedPoint::fromFloat(roll);
+    pitchQ = fixedPoint::fromFloat(pitch);
+    yawQ = fixedPoint::fromFloat(remainderf(yaw, 360.0f));
+    filteredVerticalAccelQ = fixedPoint::fromFloat(filteredVerticalAccel);
+    rollRateQ = fixedPoint::fromFloat(rollRate);
+    pitchRateQ = fixedPoint::fromFloat(pitchRate);
+  }
+  
+  // Fuse one IMU sample (g and deg/s). The time step comes from the sample
+  // timestamps, so the filter runs at whatever rate the IMU delivers.
+  void update(float ax, float ay, float az, float gx, float gy, float gz, float elapsedSeconds) {
+    dt = elapsedSeconds;
+    if (dt <= 0.0f || dt > 0.1f) dt = nominalDt;  // Clamp to prevent jumps
+    
     // Remap sensor axes to vehicle coordinate system
     float axVehicle, ayVehicle, azVehicle;
     float gxVehicle, gyVehicle, gzVehicle;
@@ -93,28 +307,46 @@ public:
     remapAxes(ax, ay, az, axVehicle, ayVehicle, azVehicle);
     remapAxes(gx, gy, gz, gxVehicle, gyVehicle, gzVehicle);
     
-    // Calculate time delta
-    unsigned long currentTime = millis();
-    dt = (currentTime - lastUpdateTime) / 1000.0f;
-    lastUpdateTime = currentTime;
-    
-    if (dt > 0.1f) dt = 0.02f;  // Clamp to prevent jumps
-    
-    // Accelerometer angles (using remapped vehicle axes)
-    float accelRoll = atan2f(ayVehicle, azVehicle) * 57.2957795f;  // rad to deg
-    float accelPitch = atan2f(axVehicle, sqrtf(ayVehicle * ayVehicle + azVehicle * azVehicle)) * 57.2957795f;
-    
-    // Complementary filter for roll and pitch (using remapped vehicle gyro axes)
-    roll = ALPHA * (roll + gxVehicle * dt) + (1.0f - ALPHA) * accelRoll;
-    pitch = ALPHA * (pitch + gyVehicle * dt) + (1.0f - ALPHA) * accelPitch;
-    yaw += gzVehicle * dt;
-    
-    // Calculate vertical acceleration in world frame (using remapped vehicle axes)
-    // Remove gravity component
-    verticalAccel = azVehicle - 1.0f;  // Gravity is 1.0g when level
+    if (mode == FUSION_MAHONY) {
+      if (calibrationRemaining > 0) {
+        accumulateCalibration(axVehicle, ayVehicle, azVehicle);
+      }
+      
+      ahrs.update(axVehicle, ayVehicle, azVehicle,
+                  gxVehicle * DEG_TO_RAD, gyVehicle * DEG_TO_RAD, gzVehicle * DEG_TO_RAD, dt);
+      roll = ahrs.getRoll();
+      pitch = ahrs.getPitch();
+      rollRate = gxVehicle - ahrs.getBiasX() * RAD_TO_DEG;
+      pitchRate = -(gyVehicle - ahrs.getBiasY() * RAD_TO_DEG);
+      
+      // Specific force projected on the world vertical, minus gravity
+      verticalAccel = ahrs.verticalAcceleration(axVehicle, ayVehicle, azVehicle);
+    } else {
+      // Accelerometer angles (using remapped vehicle axes)
+      float accelRoll, accelPitch;
+      accumulateCalibration(axVehicle, ayVehicle, azVehicle, &accelRoll, &accelPitch);
+      
+      // Complementary filter for roll and pitch (using remapped vehicle gyro
+      // axes; nose-up is a negative rotation about y)
+      float alpha = ATTITUDE_TIME_CONSTANT / (ATTITUDE_TIME_CONSTANT + dt);
+      roll = alpha * (roll + gxVehicle * dt) + (1.0f - alpha) * accelRoll;
+      pitch = alpha * (pitch - gyVehicle * dt) + (1.0f - alpha) * accelPitch;
+      yaw += gzVehicle * dt;
+      // Wrapped to +/-180 like the Q16 path and Mahony, so it neither grows
+      // without bound (losing float precision) nor saturates when stored
+      if (yaw > 180.0f) yaw -= 360.0f;
+      else if (yaw < -180.0f) yaw += 360.0f;
+      rollRate = gxVehicle;
+      pitchRate = -gyVehicle;
+      
+      // Calculate vertical acceleration in world frame (using remapped vehicle axes)
+      // Remove gravity component
+      verticalAccel = azVehicle - 1.0f;  // Gravity is 1.0g when level
+    }
     
     // Low-pass filter vertical acceleration
-    filteredVerticalAccel = 0.9f * filteredVerticalAccel + 0.1f * verticalAccel;
+    float beta = dt / (VERTICAL_TIME_CONSTANT + dt);
+    filteredVerticalAccel += beta * (verticalAccel - filteredVerticalAccel);
   }
   
   template<typename StatusCallback>
@@ -135,8 +367,8 @@ public:
       float accelZ = az / 16384.0f;
       
       // Calculate angles from accelerometer
-      float accelRoll = atan2f(accelY, accelZ) * 57.2957795f;
-      float accelPitch = atan2f(accelX, sqrtf(accelY * accelY + accelZ * accelZ)) * 57.2957795f;
+      float accelRoll = fastMath::atan2(accelY, accelZ) * 57.2957795f;
+      float accelPitch = fastMath::atan2(accelX, fastMath::sqrt(accelY * accelY + accelZ * accelZ)) * 57.2957795f;
       
       rollSum += accelRoll;
       pitchSum += accelPitch;
@@ -144,8 +376,7 @@ public:
       delay(10);  // 10ms between samples
     }
     
-    rollOffset = rollSum / samples;
-    pitchOffset = pitchSum / samples;
+    setOffsets(rollSum / samples, pitchSum / samples);
     
     String completeMsg = "Calibration complete! Roll: " + String(rollOffset, 1) + "°, Pitch: " + String(pitchOffset, 1) + "°";
     statusFn(completeMsg);
@@ -157,10 +388,33 @@ public:
     Serial.println("°");
   }
   
+  // Calibrate over the next `samples` calls to update() instead of blocking.
+  // Used at runtime so the control loop keeps driving the servos meanwhile.
+  void startCalibration(uint16_t samples) {
+    if (samples == 0) samples = 1;
+    calibrationTotal = samples;
+    calibrationRemaining = samples;
+    calibrationRollSum = 0.0f;
+    calibrationPitchSum = 0.0f;
+  }
+  
+  bool isCalibrating() const { return calibrationRemaining > 0; }
+  float getRollOffset() const { return rollOffset; }
+  float getPitchOffset() const { return pitchOffset; }
+  
   float getRoll() const { return roll - rollOffset; }
   float getPitch() const { return pitch - pitchOffset; }
-  float getYaw() const { return yaw; }
+  float getYaw() const { return mode == FUSION_MAHONY ? ahrs.getYaw() : yaw; }
   float getVerticalAcceleration() const { return filteredVerticalAccel; }
+  float getRollRate() const { return rollRate; }
+  float getPitchRate() const { return pitchRate; }
+  
+  // Fixed-point outputs (Q16.16), valid after updateFixed()
+  fixedPoint::q16_t getRollQ16() const { return rollQ - rollOffsetQ; }
+  fixedPoint::q16_t getPitchQ16() const { return pitchQ - pitchOffsetQ; }
+  fixedPoint::q16_t getVerticalAccelerationQ16() const { return filteredVerticalAccelQ; }
+  fixedPoint::q16_t getRollRateQ16() const { return rollRateQ; }
+  fixedPoint::q16_t getPitchRateQ16() const { return pitchRateQ; }
 };
 
 #endif
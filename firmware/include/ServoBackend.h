@@ -0,0 +1,41 @@
+#ifndef SERVO_BACKEND_H
+#define SERVO_BACKEND_H
+
+#include <cstdint>
+
+// Hardware that generates the servo pulses for PWMOutputs.
+//
+// Each channel runs frames of frameCounts() counts at countsPerMicrosecond();
+// a channel's pulse starts `phase` counts into the frame and lasts `duty`
+// counts. PWMOutputs does all the calibration and timing arithmetic and hands
+// a backend finished counts, one whole frame per control tick: writeFrame()
+// must make every channel take its new pulse together and must never change a
+// pulse already in flight.
+class ServoBackend {
+public:
+  virtual ~ServoBackend() {}
+
+  // Bring up the hardware; false if it does not respond
+  virtual bool begin() = 0;
+
+  virtual uint8_t channelCount() const = 0;
+
+  // Ask for a frame rate (PWM_FREQ to PWM_MAX_FREQ) on one channel. Returns
+  // the rate the channel runs at, which a backend with a single timer for all
+  // channels keeps regardless of the request.
+  virtual uint16_t setRefreshRate(uint8_t channel, uint16_t hz) = 0;
+
+  virtual float countsPerMicrosecond(uint8_t channel) const = 0;
+  virtual uint32_t frameCounts(uint8_t channel) const = 0;
+
+  // Restart all frames at the same instant, so phases line up across
+  // channels at the same rate. May cut short a pulse in flight.
+  virtual void alignFrames() = 0;
+
+  virtual void write(uint8_t channel, uint32_t duty, uint32_t phase) = 0;
+
+  // One frame for channels 0..count-1
+  virtual void writeFrame(const uint32_t* duty, const uint32_t* phase, uint8_t count) = 0;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_BUFFER_H
+#define SNAPSHOT_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free latest-value exchange between one writer task and one reader task.
+//
+// This is double buffering with a third slot so neither side ever waits: the
+// writer fills a slot that is neither published nor held by the reader, then
+// publishes it; the reader pins the published slot and uses it in place until
+// its next acquire(). Every publish bumps a generation counter so the reader
+// can tell cheaply whether anything changed.
+template<typename T>
+class SnapshotBuffer {
+private:
+  T slots[3];
+  std::atomic<uint8_t> published{0};
+  std::atomic<uint8_t> pinned{0};
+  std::atomic<uint32_t> generation{0};
+  uint8_t writeSlot = 1;
+
+public:
+  SnapshotBuffer() : slots() {}
+
+  // Writer side: fill the returned slot, then call publish().
+  T& beginWrite() { return slots[writeSlot]; }
+
+  void publish() {
+    published.store(writeSlot);
+    generation.fetch_add(1);
+
+    // Next write goes to the slot that is neither published nor pinned
+    uint8_t p = writeSlot;
+    uint8_t r = pinned.load();
+    for (uint8_t i = 0; i < 3; i++) {
+      if (i != p && i != r) {
+        writeSlot = i;
+        break;
+      }
+    }
+  }
+
+  void publish(const T& value) {
+    beginWrite() = value;
+    publish();
+  }
+
+  // Reader side: returns the latest published value. The pointer stays valid
+  // (and unmodified) until the reader's next call to acquire().
+  const T* acquire() {
+    uint8_t index;
+    do {
+      index = published.load();
+      pinned.store(index);
+    } while (published.load() != index);
+    return &slots[index];
+  }
+
+  // As acquire(), also reporting a generation the returned value is at least
+  // as new as. Remember it and compare against getGeneration() to detect changes.
+  const T* acquire(uint32_t& seenGeneration) {
+    seenGeneration = generation.load();
+    return acquire();
+  }
+
+  uint32_t getGeneration() const { return generation.load(); }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer ring buffer.
+//
+// Exactly one task may call push() and exactly one task may call pop().
+// Neither side ever blocks: push() fails when the queue is full and pop()
+// fails when it is empty. Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+  static constexpr size_t MASK = Capacity - 1;
+
+  T items[Capacity];
+  std::atomic<size_t> head{0};  // Next slot to read (owned by consumer)
+  std::atomic<size_t> tail{0};  // Next slot to write (owned by producer)
+
+public:
+  bool push(const T& item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) >= Capacity) return false;
+    items[t & MASK] = item;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false;
+    item = items[h & MASK];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return Capacity; }
+};
+
+#endif
@@ -4,18 +4,81 @@
 #include "Config.h"
 #include <ArduinoJson.h>
 #include <SPIFFS.h>
+#include <atomic>
+#include <mutex>
+#include "JsonWriter.h"
+#include "SnapshotBuffer.h"
 
+// Everything the control loop needs from the config, published as one unit
+struct ControlConfig {
+  SuspensionConfig suspension;
+  ServoConfig servos;
+};
+
+// Config is mutated from web handlers under a mutex that is only ever held
+// for in-memory work. Every change publishes immutable snapshots: the control
+// task reads ControlConfig and the service task reads BatteriesConfig
+// lock-free, in place, without copying. Changes are persisted by
+// saveIfDirty() from the service task, never from the caller's context.
 class StorageManager {
 private:
   SuspensionConfig config;
   ServoConfig servoConfig;
   BatteriesConfig batteryConfig;
   
+  mutable std::mutex mutex;
+  bool dirty = false;
+  unsigned long lastChangeTime = 0;
+  static constexpr unsigned long SAVE_DEBOUNCE_MS = 500;  // Coalesce slider drags into one write
+  
+  SnapshotBuffer<ControlConfig> controlConfigSnapshot;     // Single reader: control task
+  SnapshotBuffer<BatteriesConfig> batteryConfigSnapshot;   // Single reader: service task
+  std::atomic<uint32_t> version{0};  // Bumped by every publish; the ETag of GET /api/config
+  
+  // Caller must hold the mutex (or be single-threaded, as during setup)
+  void publish() {
+    ControlConfig& control = controlConfigSnapshot.beginWrite();
+    control.suspension = config;
+    control.servos = servoConfig;
+    controlConfigSnapshot.publish();
+    batteryConfigSnapshot.publish(batteryConfig);
+    version.fetch_add(1);
+  }
+  
+  // Caller must hold the mutex
+  void markDirty() {
+    publish();
+    dirty = true;
+    lastChangeTime = millis();
+  }
+  
+  static void writeServoJSON(JsonWriter& json, const char* name, const ServoCalibration& servo) {
+    json.key(name).beginObject();
+    json.key("trim").value(servo.trim);
+    json.key("min").value(servo.minLimit);
+    json.key("max").value(servo.maxLimit);
+    json.key("reversed").value(servo.reversed);
+    json.key("refreshHz").value(servo.refreshHz);
+    json.key("maxVelocity").value(servo.maxVelocity);
+    json.key("maxAcceleration").value(servo.maxAcceleration);
+    json.endObject();
+  }
+  
+  static void writeBatteryJSON(JsonWriter& json, const BatteryConfig& battery) {
+    json.beginObject();
+    json.key("name").value(battery.name);
+    json.key("cellCount").value(battery.cellCount);
+    json.key("plugAssignment").value(battery.plugAssignment);
+    json.key("showOnDashboard").value(battery.showOnDashboard);
+    json.endObject();
+  }
+  
 public:
   void init() {
     loadDefaults();
     loadServoDefaults();
     loadBatteryDefaults();
+    publish();
   }
   
   void loadDefaults() {
@@ -27,14 +90,26 @@ public:
     config.stiffness = DEFAULT_STIFFNESS;
     config.sampleRate = SUSPENSION_SAMPLE_RATE_HZ;
     config.mpuOrientation = DEFAULT_MPU6050_ORIENTATION;
+    config.mountRollTrim = DEFAULT_MOUNT_TRIM;
+    config.mountPitchTrim = DEFAULT_MOUNT_TRIM;
+    config.mountYawTrim = DEFAULT_MOUNT_TRIM;
+    config.fusionMode = DEFAULT_FUSION_MODE;
+    config.simulationMode = DEFAULT_SIMULATION_MODE;
+    config.servoLatencyMs = DEFAULT_SERVO_LATENCY_MS;
+    config.servoTimeConstantMs = DEFAULT_SERVO_TIME_CONSTANT_MS;
+    config.predictionGain = DEFAULT_PREDICTION_GAIN;
     config.fpvAutoMode = DEFAULT_FPV_AUTO_MODE;
   }
   
   void loadServoDefaults() {
-    servoConfig.frontLeft = {DEFAULT_SERVO_TRIM, DEFAULT_SERVO_MIN, DEFAULT_SERVO_MAX, DEFAULT_SERVO_REVERSED};
-    servoConfig.frontRight = {DEFAULT_SERVO_TRIM, DEFAULT_SERVO_MIN, DEFAULT_SERVO_MAX, DEFAULT_SERVO_REVERSED};
-    servoConfig.rearLeft = {DEFAULT_SERVO_TRIM, DEFAULT_SERVO_MIN, DEFAULT_SERVO_MAX, DEFAULT_SERVO_REVERSED};
-    servoConfig.rearRight = {DEFAULT_SERVO_TRIM, DEFAULT_SERVO_MIN, DEFAULT_SERVO_MAX, DEFAULT_SERVO_REVERSED};
+    servoConfig.frontLeft = {DEFAULT_SERVO_TRIM, DEFAULT_SERVO_MIN, DEFAULT_SERVO_MAX, DEFAULT_SERVO_REVERSED, DEFAULT_SERVO_REFRESH_HZ,
+                            DEFAULT_SERVO_MAX_VELOCITY, DEFAULT_SERVO_MAX_ACCELERATION};
+    servoConfig.frontRight = {DEFAULT_SERVO_TRIM, DEFAULT_SERVO_MIN, DEFAULT_SERVO_MAX, DEFAULT_SERVO_REVERSED, DEFAULT_SERVO_REFRESH_HZ,
+                            DEFAULT_SERVO_MAX_VELOCITY, DEFAULT_SERVO_MAX_ACCELERATION};
+    servoConfig.rearLeft = {DEFAULT_SERVO_TRIM, DEFAULT_SERVO_MIN, DEFAULT_SERVO_MAX, DEFAULT_SERVO_REVERSED, DEFAULT_SERVO_REFRESH_HZ,
+                            DEFAULT_SERVO_MAX_VELOCITY, DEFAULT_SERVO_MAX_ACCELERATION};
+    servoConfig.rearRight = {DEFAULT_SERVO_TRIM, DEFAULT_SERVO_MIN, DEFAULT_SERVO_MAX, DEFAULT_SERVO_REVERSED, DEFAULT_SERVO_REFRESH_HZ,
+                            DEFAULT_SERVO_MAX_VELOCITY, DEFAULT_SERVO_MAX_ACCELERATION};
   }
   
   void loadBatteryDefaults() {
@@ -66,7 +141,7 @@ public:
       return;
     }
     
-    DynamicJsonDocument doc(1024);
+    DynamicJsonDocument doc(2048);  // Same size as saveConfig() writes
     DeserializationError error = deserializeJson(doc, file);
     file.close();
     
@@ -82,8 +157,18 @@ public:
     config.damping = doc["damping"] | DEFAULT_DAMPING;
     config.frontRearBalance = doc["frontRearBalance"] | DEFAULT_FRONT_REAR_BALANCE;
     config.stiffness = doc["stiffness"] | DEFAULT_STIFFNESS;
-    config.sampleRate = doc["sampleRate"] | SUSPENSION_SAMPLE_RATE_HZ;
+    // The control rate is fixed at build time; files saved by older firmware
+    // carry "sampleRate":25, which must not hold the loop at 25 Hz
+    config.sampleRate = SUSPENSION_SAMPLE_RATE_HZ;
     config.mpuOrientation = doc["mpuOrientation"] | DEFAULT_MPU6050_ORIENTATION;
+    config.mountRollTrim = doc["mountRollTrim"] | DEFAULT_MOUNT_TRIM;
+    config.mountPitchTrim = doc["mountPitchTrim"] | DEFAULT_MOUNT_TRIM;
+    config.mountYawTrim = doc["mountYawTrim"] | DEFAULT_MOUNT_TRIM;
+    config.fusionMode = doc["fusionMode"] | DEFAULT_FUSION_MODE;
+    config.simulationMode = doc["simulationMode"] | DEFAULT_SIMULATION_MODE;
+    config.servoLatencyMs = doc["servoLatencyMs"] | DEFAULT_SERVO_LATENCY_MS;
+    config.servoTimeConstantMs = doc["servoTimeConstantMs"] | DEFAULT_SERVO_TIME_CONSTANT_MS;
+    config.predictionGain = doc["predictionGain"] | DEFAULT_PREDICTION_GAIN;
     config.fpvAutoMode = doc["fpvAutoMode"] | DEFAULT_FPV_AUTO_MODE;
     
     // Load servo calibration if available
@@ -94,24 +179,36 @@ public:
         servoConfig.frontLeft.minLimit = servos["frontLeft"]["min"] | DEFAULT_SERVO_MIN;
         servoConfig.frontLeft.maxLimit = servos["frontLeft"]["max"] | DEFAULT_SERVO_MAX;
         servoConfig.frontLeft.reversed = servos["frontLeft"]["reversed"] | DEFAULT_SERVO_REVERSED;
+        servoConfig.frontLeft.refreshHz = servos["frontLeft"]["refreshHz"] | DEFAULT_SERVO_REFRESH_HZ;
+        servoConfig.frontLeft.maxVelocity = servos["frontLeft"]["maxVelocity"] | DEFAULT_SERVO_MAX_VELOCITY;
+        servoConfig.frontLeft.maxAcceleration = servos["frontLeft"]["maxAcceleration"] | DEFAULT_SERVO_MAX_ACCELERATION;
       }
       if (servos.containsKey("frontRight")) {
         servoConfig.frontRight.trim = servos["frontRight"]["trim"] | DEFAULT_SERVO_TRIM;
         servoConfig.frontRight.minLimit = servos["frontRight"]["min"] | DEFAULT_SERVO_MIN;
         servoConfig.frontRight.maxLimit = servos["frontRight"]["max"] | DEFAULT_SERVO_MAX;
         servoConfig.frontRight.reversed = servos["frontRight"]["reversed"] | DEFAULT_SERVO_REVERSED;
+        servoConfig.frontRight.refreshHz = servos["frontRight"]["refreshHz"] | DEFAULT_SERVO_REFRESH_HZ;
+        servoConfig.frontRight.maxVelocity = servos["frontRight"]["maxVelocity"] | DEFAULT_SERVO_MAX_VELOCITY;
+        servoConfig.frontRight.maxAcceleration = servos["frontRight"]["maxAcceleration"] | DEFAULT_SERVO_MAX_ACCELERATION;
       }
       if (servos.containsKey("rearLeft")) {
         servoConfig.rearLeft.trim = servos["rearLeft"]["trim"] | DEFAULT_SERVO_TRIM;
         servoConfig.rearLeft.minLimit = servos["rearLeft"]["min"] | DEFAULT_SERVO_MIN;
         servoConfig.rearLeft.maxLimit = servos["rearLeft"]["max"] | DEFAULT_SERVO_MAX;
         servoConfig.rearLeft.reversed = servos["rearLeft"]["reversed"] | DEFAULT_SERVO_REVERSED;
+        servoConfig.rearLeft.refreshHz = servos["rearLeft"]["refreshHz"] | DEFAULT_SERVO_REFRESH_HZ;
+        servoConfig.rearLeft.maxVelocity = servos["rearLeft"]["maxVelocity"] | DEFAULT_SERVO_MAX_VELOCITY;
+        servoConfig.rearLeft.maxAcceleration = servos["rearLeft"]["maxAcceleration"] | DEFAULT_SERVO_MAX_ACCELERATION;
       }
       if (servos.containsKey("rearRight")) {
         servoConfig.rearRight.trim = servos["rearRight"]["trim"] | DEFAULT_SERVO_TRIM;
         servoConfig.rearRight.minLimit = servos["rearRight"]["min"] | DEFAULT_SERVO_MIN;
         servoConfig.rearRight.maxLimit = servos["rearRight"]["max"] | DEFAULT_SERVO_MAX;
         servoConfig.rearRight.reversed = servos["rearRight"]["reversed"] | DEFAULT_SERVO_REVERSED;
+        servoConfig.rearRight.refreshHz = servos["rearRight"]["refreshHz"] | DEFAULT_SERVO_REFRESH_HZ;
+        servoConfig.rearRight.maxVelocity = servos["rearRight"]["maxVelocity"] | DEFAULT_SERVO_MAX_VELOCITY;
+        servoConfig.rearRight.maxAcceleration = servos["rearRight"]["maxAcceleration"] | DEFAULT_SERVO_MAX_ACCELERATION;
       }
     }
     
@@ -138,12 +235,14 @@ public:
       }
     }
     
+    publish();
     Serial.println("Config loaded from SPIFFS");
   }
   
   void saveConfig() {
     DynamicJsonDocument doc(2048);  // Increased size for servo config
     
+    std::unique_lock<std::mutex> lock(mutex);
     doc["reactionSpeed"] = config.reactionSpeed;
     doc["rideHeightOffset"] = config.rideHeightOffset;
     doc["rangeLimit"] = config.rangeLimit;
@@ -152,6 +251,14 @@ public:
     doc["stiffness"] = config.stiffness;
     doc["sampleRate"] = config.sampleRate;
     doc["mpuOrientation"] = config.mpuOrientation;
+    doc["mountRollTrim"] = config.mountRollTrim;
+    doc["mountPitchTrim"] = config.mountPitchTrim;
+    doc["mountYawTrim"] = config.mountYawTrim;
+    doc["fusionMode"] = config.fusionMode;
+    doc["simulationMode"] = config.simulationMode;
+    doc["servoLatencyMs"] = config.servoLatencyMs;
+    doc["servoTimeConstantMs"] = config.servoTimeConstantMs;
+    doc["predictionGain"] = config.predictionGain;
     doc["fpvAutoMode"] = config.fpvAutoMode;
     
     // Save servo calibration
@@ -162,24 +269,36 @@ public:
     fl["min"] = servoConfig.frontLeft.minLimit;
     fl["max"] = servoConfig.frontLeft.maxLimit;
     fl["reversed"] = servoConfig.frontLeft.reversed;
+    fl["refreshHz"] = servoConfig.frontLeft.refreshHz;
+    fl["maxVelocity"] = servoConfig.frontLeft.maxVelocity;
+    fl["maxAcceleration"] = servoConfig.frontLeft.maxAcceleration;
     
     JsonObject fr = servos.createNestedObject("frontRight");
     fr["trim"] = servoConfig.frontRight.trim;
     fr["min"] = servoConfig.frontRight.minLimit;
     fr["max"] = servoConfig.frontRight.maxLimit;
     fr["reversed"] = servoConfig.frontRight.reversed;
+    fr["refreshHz"] = servoConfig.frontRight.refreshHz;
+    fr["maxVelocity"] = servoConfig.frontRight.maxVelocity;
+    fr["maxAcceleration"] = servoConfig.frontRight.maxAcceleration;
     
     JsonObject rl = servos.createNestedObject("rearLeft");
     rl["trim"] = servoConfig.rearLeft.trim;
     rl["min"] = servoConfig.rearLeft.minLimit;
     rl["max"] = servoConfig.rearLeft.maxLimit;
     rl["reversed"] = servoConfig.rearLeft.reversed;
+    rl["refreshHz"] = servoConfig.rearLeft.refreshHz;
+    rl["maxVelocity"] = servoConfig.rearLeft.maxVelocity;
+    rl["maxAcceleration"] = servoConfig.rearLeft.maxAcceleration;
     
     JsonObject rr = servos.createNestedObject("rearRight");
     rr["trim"] = servoConfig.rearRight.trim;
     rr["min"] = servoConfig.rearRight.minLimit;
     rr["max"] = servoConfig.rearRight.maxLimit;
     rr["reversed"] = servoConfig.rearRight.reversed;
+    rr["refreshHz"] = servoConfig.rearRight.refreshHz;
+    rr["maxVelocity"] = servoConfig.rearRight.maxVelocity;
+    rr["maxAcceleration"] = servoConfig.rearRight.maxAcceleration;
     
     // Save battery configuration
     JsonObject batteries = doc.createNestedObject("batteries");
@@ -202,98 +321,169 @@ public:
     b3["plugAssignment"] = batteryConfig.battery3.plugAssignment;
     b3["showOnDashboard"] = batteryConfig.battery3.showOnDashboard;
     
+    const uint32_t savedVersion = version.load();
+    lock.unlock();  // Don't hold the config while writing flash
+    
     File file = SPIFFS.open(CONFIG_SPIFFS_PATH, "w");
-    if (!file) {
-      Serial.println("Failed to create config file");
-      return;
+    const bool opened = file;
+    size_t written = 0;
+    if (opened) {
+      written = serializeJson(doc, file);
+      file.close();
     }
     
-    serializeJson(doc, file);
-    file.close();
+    lock.lock();
+    if (!opened || written == 0) {
+      // Leave the change pending and try again after another debounce period
+      lastChangeTime = millis();
+      Serial.println("Failed to write config file");
+      return;
+    }
+    // A change made while writing stays dirty and is saved next time
+    if (version.load() == savedVersion) dirty = false;
     
     Serial.println("Config saved to SPIFFS");
   }
   
+  // Persist pending changes once they have settled (call from the service task)
+  void saveIfDirty() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!dirty || millis() - lastChangeTime < SAVE_DEBOUNCE_MS) return;
+    }
+    saveConfig();
+  }
+  
+  // Latest control config, read in place. Control task only; the pointer is
+  // valid until its next call. `generation` reports the version seen, for
+  // comparison against getControlConfigGeneration().
+  const ControlConfig* acquireControlConfig(uint32_t& generation) {
+    return controlConfigSnapshot.acquire(generation);
+  }
+  
+  uint32_t getControlConfigGeneration() const {
+    return controlConfigSnapshot.getGeneration();
+  }
+  
+  // Latest battery config, read in place. Service task only.
+  const BatteriesConfig* acquireBatteryConfig() {
+    return batteryConfigSnapshot.acquire();
+  }
+  
   SuspensionConfig getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
     return config;
   }
   
   void setConfig(const SuspensionConfig& newConfig) {
+    std::lock_guard<std::mutex> lock(mutex);
     config = newConfig;
-    saveConfig();
+    markDirty();
   }
   
+  // One parameter of SuspensionConfig by its JSON name
+  struct ParameterUpdate {
+    const char* key;
+    float value;
+  };
+  
   void updateParameter(const String& key, float value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    setParameter(key.c_str(), value);
+    markDirty();
+  }
+  
+  // Several parameters as one change (one POST /api/config): applied under
+  // one lock, so the control task never runs on half of them, and published
+  // once, so the config version moves by one
+  void updateParameters(const ParameterUpdate* updates, size_t count) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < count; i++) setParameter(updates[i].key, updates[i].value);
+    markDirty();
+  }
+  
+private:
+  // Caller must hold the mutex
+  void setParameter(const char* name, float value) {
+    const String key(name);
     if (key == "reactionSpeed") config.reactionSpeed = value;
     else if (key == "rideHeightOffset") config.rideHeightOffset = value;
     else if (key == "rangeLimit") config.rangeLimit = value;
     else if (key == "damping") config.damping = value;
     else if (key == "frontRearBalance") config.frontRearBalance = value;
     else if (key == "stiffness") config.stiffness = value;
+    else if (key == "mpuOrientation") config.mpuOrientation = (value >= 0.0f && value <= ARROW_LEFT_UP) ? (uint8_t)value : (uint8_t)DEFAULT_MPU6050_ORIENTATION;
+    else if (key == "mountRollTrim") config.mountRollTrim = value;
+    else if (key == "mountPitchTrim") config.mountPitchTrim = value;
+    else if (key == "mountYawTrim") config.mountYawTrim = value;
+    else if (key == "fusionMode") config.fusionMode = (value == FUSION_MAHONY) ? FUSION_MAHONY : FUSION_COMPLEMENTARY;
+    else if (key == "simulationMode") config.simulationMode = (value == SIMULATION_QUARTER_CAR) ? SIMULATION_QUARTER_CAR : SIMULATION_KINEMATIC;
+    else if (key == "servoLatencyMs") config.servoLatencyMs = constrain(value, 0.0f, 100.0f);
+    else if (key == "servoTimeConstantMs") config.servoTimeConstantMs = constrain(value, 0.0f, 200.0f);
+    else if (key == "predictionGain") config.predictionGain = constrain(value, 0.0f, 1.0f);
     else if (key == "fpvAutoMode") config.fpvAutoMode = (value != 0.0f);
-    saveConfig();
   }
   
+public:
+  
   void resetToDefaults() {
+    std::lock_guard<std::mutex> lock(mutex);
     loadDefaults();
-    saveConfig();
+    markDirty();
     Serial.println("Config reset to defaults");
   }
   
-  String getConfigJSON() {
-    DynamicJsonDocument doc(2048);
-    
-    doc["reactionSpeed"] = config.reactionSpeed;
-    doc["rideHeightOffset"] = config.rideHeightOffset;
-    doc["rangeLimit"] = config.rangeLimit;
-    doc["damping"] = config.damping;
-    doc["frontRearBalance"] = config.frontRearBalance;
-    doc["stiffness"] = config.stiffness;
-    doc["sampleRate"] = config.sampleRate;
-    doc["mpuOrientation"] = config.mpuOrientation;
-    
-    String output;
-    serializeJson(doc, output);
-    return output;
+  // Increases with every config change (from any task, without locking)
+  uint32_t getConfigVersion() const { return version.load(); }
+  
+  // The whole config as served by GET /api/config: the suspension settings,
+  // then "servos" and "batteries", taken under one lock. Returns the config
+  // version written.
+  uint32_t writeConfigJSON(JsonWriter& json) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    json.beginObject();
+    json.key("reactionSpeed").value(config.reactionSpeed);
+    json.key("rideHeightOffset").value(config.rideHeightOffset);
+    json.key("rangeLimit").value(config.rangeLimit);
+    json.key("damping").value(config.damping);
+    json.key("frontRearBalance").value(config.frontRearBalance);
+    json.key("stiffness").value(config.stiffness);
+    json.key("sampleRate").value(config.sampleRate);
+    json.key("mpuOrientation").value(config.mpuOrientation);
+    json.key("mountRollTrim").value(config.mountRollTrim);
+    json.key("mountPitchTrim").value(config.mountPitchTrim);
+    json.key("mountYawTrim").value(config.mountYawTrim);
+    json.key("fusionMode").value(config.fusionMode);
+    json.key("simulationMode").value(config.simulationMode);
+    json.key("servoLatencyMs").value(config.servoLatencyMs);
+    json.key("servoTimeConstantMs").value(config.servoTimeConstantMs);
+    json.key("predictionGain").value(config.predictionGain);
+    
+    json.key("servos").beginObject();
+    writeServoJSON(json, "frontLeft", servoConfig.frontLeft);
+    writeServoJSON(json, "frontRight", servoConfig.frontRight);
+    writeServoJSON(json, "rearLeft", servoConfig.rearLeft);
+    writeServoJSON(json, "rearRight", servoConfig.rearRight);
+    json.endObject();
+    
+    json.key("batteries").beginArray();
+    writeBatteryJSON(json, batteryConfig.battery1);
+    writeBatteryJSON(json, batteryConfig.battery2);
+    writeBatteryJSON(json, batteryConfig.battery3);
+    json.endArray();
+    json.endObject();
+    return version.load();
   }
   
   ServoConfig getServoConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
     return servoConfig;
   }
   
-  String getServoConfigJSON() {
-    DynamicJsonDocument doc(1024);
-    
-    JsonObject fl = doc.createNestedObject("frontLeft");
-    fl["trim"] = servoConfig.frontLeft.trim;
-    fl["min"] = servoConfig.frontLeft.minLimit;
-    fl["max"] = servoConfig.frontLeft.maxLimit;
-    fl["reversed"] = servoConfig.frontLeft.reversed;
-    
-    JsonObject fr = doc.createNestedObject("frontRight");
-    fr["trim"] = servoConfig.frontRight.trim;
-    fr["min"] = servoConfig.frontRight.minLimit;
-    fr["max"] = servoConfig.frontRight.maxLimit;
-    fr["reversed"] = servoConfig.frontRight.reversed;
-    
-    JsonObject rl = doc.createNestedObject("rearLeft");
-    rl["trim"] = servoConfig.rearLeft.trim;
-    rl["min"] = servoConfig.rearLeft.minLimit;
-    rl["max"] = servoConfig.rearLeft.maxLimit;
-    rl["reversed"] = servoConfig.rearLeft.reversed;
-    
-    JsonObject rr = doc.createNestedObject("rearRight");
-    rr["trim"] = servoConfig.rearRight.trim;
-    rr["min"] = servoConfig.rearRight.minLimit;
-    rr["max"] = servoConfig.rearRight.maxLimit;
-    rr["reversed"] = servoConfig.rearRight.reversed;
-    
-    String output;
-    serializeJson(doc, output);
-    return output;
-  }
-  
   void updateServoParameter(const String& servo, const String& param, int value) {
+    std::lock_guard<std::mutex> lock(mutex);
     ServoCalibration* target = nullptr;
     
     if (servo == "frontLeft") target = &servoConfig.frontLeft;
@@ -306,45 +496,22 @@ public:
       else if (param == "min") target->minLimit = constrain(value, 30, 90);
       else if (param == "max") target->maxLimit = constrain(value, 90, 150);
       else if (param == "reversed") target->reversed = (value != 0);
+      else if (param == "refreshHz") target->refreshHz = constrain(value, PWM_FREQ, PWM_MAX_FREQ);
+      else if (param == "maxVelocity") target->maxVelocity = constrain(value, 0, SERVO_MAX_VELOCITY_LIMIT);
+      else if (param == "maxAcceleration") target->maxAcceleration = constrain(value, 0, SERVO_MAX_ACCELERATION_LIMIT);
       
-      saveConfig();
+      markDirty();
     }
   }
   
   // Battery configuration methods
   BatteriesConfig getBatteryConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
     return batteryConfig;
   }
   
-  String getBatteryConfigJSON() {
-    DynamicJsonDocument doc(1024);
-    
-    JsonArray batteries = doc.createNestedArray("batteries");
-    
-    JsonObject b1 = batteries.createNestedObject();
-    b1["name"] = batteryConfig.battery1.name;
-    b1["cellCount"] = batteryConfig.battery1.cellCount;
-    b1["plugAssignment"] = batteryConfig.battery1.plugAssignment;
-    b1["showOnDashboard"] = batteryConfig.battery1.showOnDashboard;
-    
-    JsonObject b2 = batteries.createNestedObject();
-    b2["name"] = batteryConfig.battery2.name;
-    b2["cellCount"] = batteryConfig.battery2.cellCount;
-    b2["plugAssignment"] = batteryConfig.battery2.plugAssignment;
-    b2["showOnDashboard"] = batteryConfig.battery2.showOnDashboard;
-    
-    JsonObject b3 = batteries.createNestedObject();
-    b3["name"] = batteryConfig.battery3.name;
-    b3["cellCount"] = batteryConfig.battery3.cellCount;
-    b3["plugAssignment"] = batteryConfig.battery3.plugAssignment;
-    b3["showOnDashboard"] = batteryConfig.battery3.showOnDashboard;
-    
-    String output;
-    serializeJson(doc, output);
-    return output;
-  }
-  
   void updateBatteryParameter(int batteryNum, const String& param, const String& value) {
+    std::lock_guard<std::mutex> lock(mutex);
     BatteryConfig* target = nullptr;
     
     if (batteryNum == 1) target = &batteryConfig.battery1;
@@ -360,7 +527,7 @@ public:
       else if (param == "plugAssignment") target->plugAssignment = constrain(value.toInt(), 0, 3);
       else if (param == "showOnDashboard") target->showOnDashboard = (value == "true" || value == "1");
       
-      saveConfig();
+      markDirty();
     }
   }
 };
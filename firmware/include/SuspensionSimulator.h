@@ -2,104 +2,311 @@
 #define SUSPENSION_SIMULATOR_H
 
 #include "Config.h"
+#include "FixedPoint.h"
 #include <cmath>
 
+// Where a corner sits on the chassis, which decides how roll and pitch move it
+struct CornerGeometry {
+  int8_t rollSign;   // +1 left side (rises with positive roll), -1 right side
+  int8_t pitchSign;  // +1 front half (uses the front share of frontRearBalance), -1 rear half
+  float pitchLever;  // Distance from the pitch axis, 1 = outermost axle, 0 = on the axis
+};
+
 class SuspensionSimulator {
+public:
+  static constexpr uint8_t MAX_CORNERS = 8;
+  
+  // Corner layouts. The first four corners are always FL, FR, RL, RR (the
+  // servo channels); middle axles follow.
+  static const CornerGeometry* chassisGeometry(uint8_t wheels) {
+    static const CornerGeometry FOUR_WHEEL[4] = {
+      {1, 1, 1.0f}, {-1, 1, 1.0f}, {1, -1, 1.0f}, {-1, -1, 1.0f}
+    };
+    static const CornerGeometry SIX_WHEEL[6] = {
+      {1, 1, 1.0f}, {-1, 1, 1.0f}, {1, -1, 1.0f}, {-1, -1, 1.0f},
+      {1, 1, 0.0f}, {-1, 1, 0.0f}                                  // ML, MR on the pitch axis
+    };
+    static const CornerGeometry EIGHT_WHEEL[8] = {
+      {1, 1, 1.0f}, {-1, 1, 1.0f}, {1, -1, 1.0f}, {-1, -1, 1.0f},
+      {1, 1, 1.0f / 3.0f}, {-1, 1, 1.0f / 3.0f},                   // Second axle
+      {1, -1, 1.0f / 3.0f}, {-1, -1, 1.0f / 3.0f}                  // Third axle
+    };
+    return wheels == 8 ? EIGHT_WHEEL : (wheels == 6 ? SIX_WHEEL : FOUR_WHEEL);
+  }
+  
 private:
-  SuspensionConfig config;
-  
-  // Suspension state for each corner
-  struct CornerState {
-    float position = 0.0f;  // 0-180 servo position
-    float velocity = 0.0f;
-    float target = 0.0f;
-  };
-  
-  CornerState frontLeft;
-  CornerState frontRight;
-  CornerState rearLeft;
-  CornerState rearRight;
-  
-  float lastRoll = 0.0f;
-  float lastPitch = 0.0f;
-  float lastVerticalAccel = 0.0f;
-
+  SuspensionConfig config;        // Active (possibly mid-ramp) parameters
+  
+  // Live tuning: new parameters arrive with a version and are ramped in
+  // linearly over PARAMETER_RAMP_MS, starting at the next tick boundary
+  SuspensionConfig targetConfig;
+  uint32_t configVersion = 0;
+  uint16_t rampTicksRemaining = 0;
+  
+  // Chassis layout
+  uint8_t cornerCount = 4;
+  CornerGeometry geometry[MAX_CORNERS] = {};
+  
+  // Per-corner gains, derived from the geometry and `config` whenever either
+  // changes so the per-tick kernel is multiply-adds only
+  float rollGain[MAX_CORNERS] = {};   // rollSign * stiffness
+  float pitchGain[MAX_CORNERS] = {};  // pitchSign * lever * stiffness * front/rear share
+  float minPosition = 0.0f;
+  float maxPosition = 180.0f;
+  float smoothing = 0.0f;             // Per-tick approach to the target (reaction speed)
+  
+  // Quarter-car integrator (SIMULATION_QUARTER_CAR), per unit sprung mass
+  uint8_t substeps = 1;               // Integrator steps per tick
+  float stepSeconds = 0.0f;           // Length of one step
+  float springStep = 0.0f;            // omega^2 * step
+  float damperStep = 0.0f;            // 2 * zeta * omega * step
+  
+  // Suspension state, one slot per corner (0-180 servo positions, and
+  // degrees per second in the quarter-car model)
+  float position[MAX_CORNERS] = {};
+  float velocity[MAX_CORNERS] = {};
+  
+  // Q16.16 copies of the above for updateFixed()
+  fixedPoint::q16_t rollGainQ[MAX_CORNERS] = {};
+  fixedPoint::q16_t pitchGainQ[MAX_CORNERS] = {};
+  fixedPoint::q16_t rideHeightQ = 0;
+  fixedPoint::q16_t minPositionQ = 0;
+  fixedPoint::q16_t maxPositionQ = 0;
+  fixedPoint::q16_t dampingQ = 0;
+  int32_t smoothingQ = 0;  // Q30
+  fixedPoint::q16_t springStepQ = 0;
+  int32_t damperStepQ = 0;  // Q30
+  int32_t stepSecondsQ = 0; // Q30
+  fixedPoint::q16_t positionQ[MAX_CORNERS] = {};
+  fixedPoint::q16_t velocityQ[MAX_CORNERS] = {};
+  
 public:
   void init(const SuspensionConfig& cfg) {
     config = cfg;
-    
-    // Initialize all corners to center position
-    float centerPos = config.rideHeightOffset;
-    frontLeft.position = centerPos;
-    frontRight.position = centerPos;
-    rearLeft.position = centerPos;
-    rearRight.position = centerPos;
+    targetConfig = cfg;
+    rampTicksRemaining = 0;
+    setGeometry(chassisGeometry(SUSPENSION_WHEELS), SUSPENSION_WHEELS);
+  }
+  
+  // Use a different chassis layout (up to MAX_CORNERS corners). All corners
+  // restart at ride height.
+  void setGeometry(const CornerGeometry* corners, uint8_t count) {
+    cornerCount = count < MAX_CORNERS ? count : MAX_CORNERS;
+    for (uint8_t i = 0; i < cornerCount; i++) geometry[i] = corners[i];
+    refreshGains();
+  
+    // Initialize all corners to center position, at rest
+    for (uint8_t i = 0; i < MAX_CORNERS; i++) {
+      position[i] = config.rideHeightOffset;
+      positionQ[i] = rideHeightQ;
+      velocity[i] = 0.0f;
+      velocityQ[i] = 0;
+    }
   }
   
+  uint8_t getCornerCount() const { return cornerCount; }
+  
+  // Hand over new tuning while running. Ignored if `version` was already
+  // applied, so it is cheap to call every tick. Corner state is kept and the
+  // continuous parameters ramp to their new values so the servos never jump.
+  void applyConfig(const SuspensionConfig& cfg, uint32_t version) {
+    if (version == configVersion) return;
+    configVersion = version;
+    targetConfig = cfg;
+  
+    // Discrete settings take effect immediately
+    config.sampleRate = cfg.sampleRate;
+    config.mpuOrientation = cfg.mpuOrientation;
+    config.fpvAutoMode = cfg.fpvAutoMode;
+    if (cfg.simulationMode != config.simulationMode) {
+      // Positions carry over; the quarter-car model starts from rest
+      config.simulationMode = cfg.simulationMode;
+      for (uint8_t i = 0; i < MAX_CORNERS; i++) {
+        velocity[i] = 0.0f;
+        velocityQ[i] = 0;
+      }
+    }
+  
+    uint32_t rampTicks = (uint32_t)PARAMETER_RAMP_MS * (config.sampleRate ? config.sampleRate : SUSPENSION_SAMPLE_RATE_HZ) / 1000;
+    rampTicksRemaining = rampTicks > 0 ? rampTicks : 1;
+  }
+  
+  uint32_t getConfigVersion() const { return configVersion; }
+  bool isRamping() const { return rampTicksRemaining > 0; }
+  
+  // Positive roll raises the left side, positive pitch raises the front
+  // (split between the axles by frontRearBalance), and vertical acceleration
+  // compresses every corner. Each corner's target is clamped to the range
+  // limit and then approached at the reaction speed (SIMULATION_KINEMATIC),
+  // or drives a spring-damper-mass corner (SIMULATION_QUARTER_CAR).
   void update(float roll, float pitch, float verticalAccel) {
-    // Roll effect on suspension (negative roll = left drops, right rises)
-    float rollEffect = roll * config.stiffness;
-    
-    // Pitch effect (negative pitch = front drops, rear rises)
-    float pitchEffect = pitch * config.stiffness;
-    
+    if (advanceRamp()) refreshGains();
+  
     // Vertical acceleration effect (compressed under acceleration)
-    float verticalEffect = -verticalAccel * config.damping;
-    
-    // Front/Rear balance distribution
-    float frontPitchFactor = config.frontRearBalance;
-    float rearPitchFactor = 1.0f - config.frontRearBalance;
-    
-    // Calculate target positions for each corner
-    // Front Left = center + pitch effect (front) + roll effect (left) + vertical
-    frontLeft.target = config.rideHeightOffset 
-                      + (pitchEffect * frontPitchFactor)
-                      + (rollEffect)
-                      + verticalEffect;
-    
-    // Front Right = center + pitch effect (front) - roll effect (right) + vertical
-    frontRight.target = config.rideHeightOffset 
-                       + (pitchEffect * frontPitchFactor)
-                       - (rollEffect)
-                       + verticalEffect;
-    
-    // Rear Left = center - pitch effect (rear) + roll effect (left) + vertical
-    rearLeft.target = config.rideHeightOffset 
-                     - (pitchEffect * rearPitchFactor)
-                     + (rollEffect)
-                     + verticalEffect;
-    
-    // Rear Right = center - pitch effect (rear) - roll effect (right) + vertical
-    rearRight.target = config.rideHeightOffset 
-                      - (pitchEffect * rearPitchFactor)
-                      - (rollEffect)
-                      + verticalEffect;
-    
-    // Apply range limits
-    clampPosition(frontLeft);
-    clampPosition(frontRight);
-    clampPosition(rearLeft);
-    clampPosition(rearRight);
-    
-    // Smooth movement with damping (reaction speed)
-    float smoothing = 1.0f / (1.0f + (5.0f / config.reactionSpeed));
-    
-    frontLeft.position = frontLeft.position * (1.0f - smoothing) + frontLeft.target * smoothing;
-    frontRight.position = frontRight.position * (1.0f - smoothing) + frontRight.target * smoothing;
-    rearLeft.position = rearLeft.position * (1.0f - smoothing) + rearLeft.target * smoothing;
-    rearRight.position = rearRight.position * (1.0f - smoothing) + rearRight.target * smoothing;
+    const float base = config.rideHeightOffset - verticalAccel * config.damping;
+  
+    // Runs over every slot (unused ones have zero gains and are never read)
+    // so the trip count is a constant: GCC vectorizes this at -O2 on the
+    // host, and on the ESP32 the spare slots cost a few cycles per tick
+    const float low = minPosition, high = maxPosition, rate = smoothing;
+    float target[MAX_CORNERS];
+    for (uint8_t i = 0; i < MAX_CORNERS; i++) {
+      float t = base + pitchGain[i] * pitch + rollGain[i] * roll;
+      t = t < low ? low : t;
+      target[i] = t > high ? high : t;
+    }
+  
+    if (config.simulationMode == SIMULATION_QUARTER_CAR) {
+      integrateQuarterCar(target);
+      return;
+    }
+    for (uint8_t i = 0; i < MAX_CORNERS; i++) {
+      position[i] += rate * (target[i] - position[i]);
+    }
   }
   
-  float getFrontLeftOutput() const { return constrain(frontLeft.position, 0.0f, 180.0f); }
-  float getFrontRightOutput() const { return constrain(frontRight.position, 0.0f, 180.0f); }
-  float getRearLeftOutput() const { return constrain(rearLeft.position, 0.0f, 180.0f); }
-  float getRearRightOutput() const { return constrain(rearRight.position, 0.0f, 180.0f); }
-
+  float getOutput(uint8_t corner) const { return constrain(position[corner], 0.0f, 180.0f); }
+  float getFrontLeftOutput() const { return getOutput(0); }
+  float getFrontRightOutput() const { return getOutput(1); }
+  float getRearLeftOutput() const { return getOutput(2); }
+  float getRearRightOutput() const { return getOutput(3); }
+  
+  // The same model in Q16.16 (SUSPENSION_FIXED_POINT): attitude in degrees,
+  // vertical acceleration in g. Also refreshes the float outputs above.
+  void updateFixed(fixedPoint::q16_t roll, fixedPoint::q16_t pitch, fixedPoint::q16_t verticalAccel) {
+    if (advanceRamp()) refreshGains();
+  
+    const fixedPoint::q16_t base = rideHeightQ - fixedPoint::mul(verticalAccel, dampingQ);
+  
+    fixedPoint::q16_t target[MAX_CORNERS];
+    for (uint8_t i = 0; i < cornerCount; i++) {
+      target[i] = base + fixedPoint::mul(pitchGainQ[i], pitch) + fixedPoint::mul(rollGainQ[i], roll);
+      target[i] = fixedPoint::clamp(target[i], minPositionQ, maxPositionQ);
+    }
+  
+    if (config.simulationMode == SIMULATION_QUARTER_CAR) {
+      integrateQuarterCarFixed(target);
+    } else {
+      for (uint8_t i = 0; i < cornerCount; i++) positionQ[i] = fixedPoint::blend(positionQ[i], target[i], smoothingQ);
+    }
+    for (uint8_t i = 0; i < cornerCount; i++) position[i] = fixedPoint::toFloat(positionQ[i]);
+  }
+  
+  // Fixed-point outputs (0-180 degrees, Q16.16), valid after updateFixed()
+  fixedPoint::q16_t getOutputQ16(uint8_t corner) const {
+    return fixedPoint::clamp(positionQ[corner], 0, fixedPoint::fromInt(180));
+  }
+  fixedPoint::q16_t getFrontLeftOutputQ16() const { return getOutputQ16(0); }
+  fixedPoint::q16_t getFrontRightOutputQ16() const { return getOutputQ16(1); }
+  fixedPoint::q16_t getRearLeftOutputQ16() const { return getOutputQ16(2); }
+  fixedPoint::q16_t getRearRightOutputQ16() const { return getOutputQ16(3); }
+  
+  // How each corner's target moves with attitude (degrees of servo per
+  // degree), and the range it is clamped to; used by ActuationPredictor
+  float getRollGain(uint8_t corner) const { return rollGain[corner]; }
+  float getPitchGain(uint8_t corner) const { return pitchGain[corner]; }
+  float getMinPosition() const { return minPosition; }
+  float getMaxPosition() const { return maxPosition; }
+  fixedPoint::q16_t getRollGainQ16(uint8_t corner) const { return rollGainQ[corner]; }
+  fixedPoint::q16_t getPitchGainQ16(uint8_t corner) const { return pitchGainQ[corner]; }
+  fixedPoint::q16_t getMinPositionQ16() const { return minPositionQ; }
+  fixedPoint::q16_t getMaxPositionQ16() const { return maxPositionQ; }
+  
+  uint8_t getSimulationMode() const { return config.simulationMode; }
+  uint8_t getSubsteps() const { return substeps; }
+  
 private:
-  void clampPosition(CornerState& corner) {
-    float minPos = config.rideHeightOffset - config.rangeLimit;
-    float maxPos = config.rideHeightOffset + config.rangeLimit;
-    corner.target = constrain(corner.target, minPos, maxPos);
+  // Quarter-car model: each corner is a unit mass hung from its target
+  // position by a spring and damper,
+  //   x'' = omega^2 * (target - x) - 2 * zeta * omega * x'
+  // integrated with semi-implicit (symplectic) Euler over `substeps` steps
+  // per tick. The velocity is updated first and the new velocity moves the
+  // position, which keeps the oscillator stable for omega * step < 2 (we
+  // stay below 1). The range limit acts as a bump stop: a corner that hits
+  // it stops there and loses its velocity.
+  void integrateQuarterCar(const float* target) {
+    const float low = minPosition, high = maxPosition;
+    const float spring = springStep, damper = damperStep, h = stepSeconds;
+    for (uint8_t s = 0; s < substeps; s++) {
+      for (uint8_t i = 0; i < MAX_CORNERS; i++) {
+        float v = velocity[i] + spring * (target[i] - position[i]) - damper * velocity[i];
+        float x = position[i] + h * v;
+        float stopped = x < low ? low : x;
+        stopped = stopped > high ? high : stopped;
+        velocity[i] = stopped == x ? v : 0.0f;
+        position[i] = stopped;
+      }
+    }
+  }
+  
+  void integrateQuarterCarFixed(const fixedPoint::q16_t* target) {
+    const int64_t round = (int64_t)1 << (fixedPoint::WEIGHT_BITS - 1);
+    for (uint8_t s = 0; s < substeps; s++) {
+      for (uint8_t i = 0; i < cornerCount; i++) {
+        fixedPoint::q16_t v = velocityQ[i] + fixedPoint::mul(springStepQ, target[i] - positionQ[i]) -
+                              (fixedPoint::q16_t)(((int64_t)velocityQ[i] * damperStepQ + round) >> fixedPoint::WEIGHT_BITS);
+        fixedPoint::q16_t x = positionQ[i] + (fixedPoint::q16_t)(((int64_t)v * stepSecondsQ + round) >> fixedPoint::WEIGHT_BITS);
+        fixedPoint::q16_t stopped = fixedPoint::clamp(x, minPositionQ, maxPositionQ);
+        velocityQ[i] = stopped == x ? v : 0;
+        positionQ[i] = stopped;
+      }
+    }
+  }
+  
+  // Advance any parameter ramp (one step per tick, lands exactly on target).
+  // Returns true if the parameters changed.
+  bool advanceRamp() {
+    if (rampTicksRemaining == 0) return false;
+    float step = 1.0f / rampTicksRemaining;
+    config.reactionSpeed += (targetConfig.reactionSpeed - config.reactionSpeed) * step;
+    config.rideHeightOffset += (targetConfig.rideHeightOffset - config.rideHeightOffset) * step;
+    config.rangeLimit += (targetConfig.rangeLimit - config.rangeLimit) * step;
+    config.damping += (targetConfig.damping - config.damping) * step;
+    config.frontRearBalance += (targetConfig.frontRearBalance - config.frontRearBalance) * step;
+    config.stiffness += (targetConfig.stiffness - config.stiffness) * step;
+    rampTicksRemaining--;
+    return true;
+  }
+  
+  void refreshGains() {
+    for (uint8_t i = 0; i < MAX_CORNERS; i++) {
+      if (i >= cornerCount) {
+        rollGain[i] = pitchGain[i] = 0.0f;
+        rollGainQ[i] = pitchGainQ[i] = 0;
+        continue;
+      }
+      const CornerGeometry& g = geometry[i];
+      float share = g.pitchSign > 0 ? config.frontRearBalance : 1.0f - config.frontRearBalance;
+      rollGain[i] = g.rollSign * config.stiffness;
+      pitchGain[i] = g.pitchSign * g.pitchLever * share * config.stiffness;
+      rollGainQ[i] = fixedPoint::fromFloat(rollGain[i]);
+      pitchGainQ[i] = fixedPoint::fromFloat(pitchGain[i]);
+    }
+    minPosition = config.rideHeightOffset - config.rangeLimit;
+    maxPosition = config.rideHeightOffset + config.rangeLimit;
+    smoothing = 1.0f / (1.0f + (5.0f / config.reactionSpeed));
+  
+    // Quarter-car: the natural frequency follows the reaction speed. Split
+    // the tick into steps of at most QUARTER_CAR_MAX_STEP_S; if the sub-step
+    // cap still leaves omega * step above 1, soften the spring to keep the
+    // integrator stable.
+    const float tickSeconds = 1.0f / (config.sampleRate ? config.sampleRate : SUSPENSION_SAMPLE_RATE_HZ);
+    uint32_t steps = (uint32_t)ceilf(tickSeconds / QUARTER_CAR_MAX_STEP_S);
+    substeps = steps < 1 ? 1 : (steps > QUARTER_CAR_MAX_SUBSTEPS ? QUARTER_CAR_MAX_SUBSTEPS : steps);
+    stepSeconds = tickSeconds / substeps;
+    float omega = 2.0f * (float)M_PI * QUARTER_CAR_FREQUENCY_HZ * config.reactionSpeed;
+    omega = omega * stepSeconds > 1.0f ? 1.0f / stepSeconds : omega;
+    springStep = omega * omega * stepSeconds;
+    damperStep = 2.0f * QUARTER_CAR_DAMPING_RATIO * omega * stepSeconds;
+  
+    rideHeightQ = fixedPoint::fromFloat(config.rideHeightOffset);
+    minPositionQ = fixedPoint::fromFloat(minPosition);
+    maxPositionQ = fixedPoint::fromFloat(maxPosition);
+    dampingQ = fixedPoint::fromFloat(config.damping);
+    smoothingQ = fixedPoint::weightFromFloat(smoothing);
+    springStepQ = fixedPoint::fromFloat(springStep);
+    damperStepQ = fixedPoint::weightFromFloat(damperStep);
+    stepSecondsQ = fixedPoint::weightFromFloat(stepSeconds);
   }
 };
 
@@ -0,0 +1,94 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Telemetry messages for WebSocket clients, serialized into caller-owned
+// buffers (no heap allocation).
+//
+// Binary frame, version 1: 40 bytes, little-endian, fields at fixed offsets
+//
+//   0   u8   protocol version (VERSION)
+//   1   u8   message type (MESSAGE_TELEMETRY)
+//   2   u16  flags (FLAG_IMU_ONLINE)
+//   4   u32  sequence number, +1 per frame (wraps)
+//   8   u32  timestamp of the attitude sample, micros() (wraps)
+//   12  f32  roll, pitch, yaw (degrees), vertical acceleration (g)
+//   28  f32  battery voltages 1-3
+//
+// Later versions only append fields, so a client can read the prefix it
+// knows. Attitude fields are NaN while the IMU is offline.
+//
+// The JSON fallback is the message dashboards have always received (with a
+// "seq" field added).
+struct TelemetrySample {
+  uint32_t sequence;
+  uint32_t timestampUs;
+  float roll;
+  float pitch;
+  float yaw;
+  float verticalAccel;
+  float batteries[3];
+};
+
+namespace telemetryFrame {
+
+constexpr uint8_t VERSION = 1;
+constexpr uint8_t MESSAGE_TELEMETRY = 1;
+constexpr uint8_t MESSAGE_HISTORY = 2;   // GET /api/history body (TelemetryHistory.h)
+constexpr uint16_t FLAG_IMU_ONLINE = 1 << 0;
+
+constexpr size_t BINARY_SIZE = 40;
+constexpr size_t JSON_CAPACITY = 192;
+
+inline uint8_t* putU16(uint8_t* out, uint16_t value) {
+  out[0] = (uint8_t)value;
+  out[1] = (uint8_t)(value >> 8);
+  return out + 2;
+}
+
+inline uint8_t* putU32(uint8_t* out, uint32_t value) {
+  out[0] = (uint8_t)value;
+  out[1] = (uint8_t)(value >> 8);
+  out[2] = (uint8_t)(value >> 16);
+  out[3] = (uint8_t)(value >> 24);
+  return out + 4;
+}
+
+inline uint8_t* putFloat(uint8_t* out, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return putU32(out, bits);
+}
+
+// Fill `out` (BINARY_SIZE bytes); returns the frame length
+inline size_t encodeBinary(const TelemetrySample& sample, uint8_t* out) {
+  uint8_t* p = out;
+  *p++ = VERSION;
+  *p++ = MESSAGE_TELEMETRY;
+  p = putU16(p, sample.roll == sample.roll ? FLAG_IMU_ONLINE : 0);  // NaN while offline
+  p = putU32(p, sample.sequence);
+  p = putU32(p, sample.timestampUs);
+  p = putFloat(p, sample.roll);
+  p = putFloat(p, sample.pitch);
+  p = putFloat(p, sample.yaw);
+  p = putFloat(p, sample.verticalAccel);
+  for (float voltage : sample.batteries) p = putFloat(p, voltage);
+  return p - out;
+}
+
+// Fill `out` with the JSON message; returns its length (0 if it did not fit)
+inline size_t encodeJson(const TelemetrySample& sample, char* out, size_t capacity) {
+  int length = snprintf(out, capacity,
+                        "{\"type\":\"telemetry\",\"seq\":%u,\"roll\":%.1f,\"pitch\":%.1f,\"yaw\":%.1f,"
+                        "\"verticalAccel\":%.2f,\"voltages\":[%.2f,%.2f,%.2f]}",
+                        (unsigned)sample.sequence, sample.roll, sample.pitch, sample.yaw, sample.verticalAccel,
+                        sample.batteries[0], sample.batteries[1], sample.batteries[2]);
+  return length > 0 && (size_t)length < capacity ? (size_t)length : 0;
+}
+
+}  // namespace telemetryFrame
+
+#endif
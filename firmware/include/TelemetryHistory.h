@@ -0,0 +1,175 @@
+#ifndef TELEMETRY_HISTORY_H
+#define TELEMETRY_HISTORY_H
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "Config.h"
+#include "HistoryRing.h"
+#include "TelemetryFrame.h"
+
+// One control tick as recorded for /api/history, in fixed-point units so a
+// record is 48 bytes (HISTORY_CAPACITY of them kept in RAM)
+struct HistorySample {
+  uint32_t timestampUs;   // micros() of the newest fused IMU sample
+  uint16_t flags;         // telemetryFrame::FLAG_IMU_ONLINE
+  int16_t imu[6];         // Newest raw IMU sample: ax, ay, az, gx, gy, gz (counts; 0 while offline)
+  int16_t attitude[3];    // Roll, pitch, yaw at the control rate (0.01 degree)
+  int16_t verticalAccel;  // mg
+  int16_t targets[4];     // Suspension model corner positions FL, FR, RL, RR (0.01 degree)
+  int16_t outputs[4];     // Servo commands after motion limiting (0.01 degree)
+  uint16_t batteries[3];  // mV
+};
+
+// Recent control loop history: the control task records every tick, web
+// handlers read any range of it without locking (HistoryRing.h), so a
+// client that connects late or drops out can fetch what it missed.
+//
+// GET /api/history?since=N streams the records after sequence number N as
+// one binary body, little-endian:
+//
+//   0   u8   protocol version (telemetryFrame::VERSION)
+//   1   u8   message type (telemetryFrame::MESSAGE_HISTORY)
+//   2   u16  record size (RECORD_SIZE)
+//   4   u32  first sequence number streamed (0: none)
+//   8   u32  newest sequence number when the request arrived
+//   12  records, RECORD_SIZE bytes each:
+//       0  u32 sequence, 4 u32 timestamp, 8 u16 flags, 10 i16[6] IMU,
+//       22 i16[3] attitude, 28 i16 vertical accel, 30 i16[4] targets,
+//       38 i16[4] outputs, 46 u16[3] batteries
+//
+// Sequence numbers increase by one per tick. A record overwritten before
+// it could be sent is skipped rather than sent torn, so a gap in the
+// numbers (or a first one above since + 1) means history was lost.
+class TelemetryHistory {
+public:
+  static constexpr size_t HEADER_SIZE = 12;
+  static constexpr size_t RECORD_SIZE = 52;
+
+  // Reads records in sequence order and serializes them into whatever
+  // space each call offers, keeping a partly sent record for the next one
+  // (an ESPAsyncWebServer chunked response filler)
+  class Stream {
+  private:
+    const TelemetryHistory* history;
+    uint32_t next;     // Next sequence number to send
+    uint32_t last;     // Newest when the request arrived
+    uint8_t pending[RECORD_SIZE];
+    uint8_t pendingOffset = 0;
+    uint8_t pendingLength = 0;
+
+    // Serialize the next record still held into `out`; false when done
+    bool encodeNext(uint8_t* out) {
+      HistorySample sample;
+      while (next <= last) {
+        const uint32_t sequence = next;
+        if (history->ring.read(sequence, sample)) {
+          next++;
+          encodeRecord(sequence, sample, out);
+          return true;
+        }
+        // Overwritten meanwhile: carry on from the oldest still held
+        const uint32_t oldest = history->ring.oldestSequence();
+        next = oldest > sequence ? oldest : sequence + 1;
+      }
+      return false;
+    }
+
+  public:
+    Stream(const TelemetryHistory& source, uint32_t since) : history(&source) {
+      last = source.ring.latestSequence();
+      const uint32_t oldest = source.ring.oldestSequence();
+      next = since + 1 > oldest ? since + 1 : oldest;
+      if (since >= last) next = last + 1;  // Nothing newer
+      uint8_t* p = pending;
+      *p++ = telemetryFrame::VERSION;
+      *p++ = telemetryFrame::MESSAGE_HISTORY;
+      p = telemetryFrame::putU16(p, RECORD_SIZE);
+      p = telemetryFrame::putU32(p, next <= last ? next : 0);
+      p = telemetryFrame::putU32(p, last);
+      pendingLength = HEADER_SIZE;
+    }
+
+    // Fill up to maxLen bytes; returns the count (0: end of the stream)
+    size_t read(uint8_t* out, size_t maxLen) {
+      size_t length = 0;
+      while (length < maxLen) {
+        if (pendingOffset < pendingLength) {
+          size_t count = pendingLength - pendingOffset;
+          if (count > maxLen - length) count = maxLen - length;
+          memcpy(out + length, pending + pendingOffset, count);
+          pendingOffset += count;
+          length += count;
+        } else if (maxLen - length >= RECORD_SIZE) {
+          if (!encodeNext(out + length)) break;
+          length += RECORD_SIZE;
+        } else {
+          if (!encodeNext(pending)) break;
+          pendingOffset = 0;
+          pendingLength = RECORD_SIZE;
+        }
+      }
+      return length;
+    }
+  };
+
+  // Control task, once per tick; the battery voltages are the service
+  // task's newest. Returns the record's sequence number.
+  uint32_t record(HistorySample& sample) {
+    for (int i = 0; i < 3; i++) sample.batteries[i] = batteryMillivolts[i].load(std::memory_order_relaxed);
+    return ring.push(sample);
+  }
+
+  // Service task, whenever the batteries are read
+  void setBatteries(float battery1, float battery2, float battery3) {
+    const float volts[3] = {battery1, battery2, battery3};
+    for (int i = 0; i < 3; i++) {
+      batteryMillivolts[i].store((uint16_t)(volts[i] > 0.0f ? fminf(volts[i] * 1000.0f + 0.5f, 65535.0f) : 0.0f),
+                                 std::memory_order_relaxed);
+    }
+  }
+
+  // Newest record; false if none was recorded yet
+  bool readLatest(HistorySample& sample) const {
+    for (int attempt = 0; attempt < 3; attempt++) {
+      if (ring.read(ring.latestSequence(), sample)) return true;
+    }
+    return false;
+  }
+
+  Stream stream(uint32_t since) const { return Stream(*this, since); }
+
+  uint32_t latestSequence() const { return ring.latestSequence(); }
+  uint32_t oldestSequence() const { return ring.oldestSequence(); }
+
+  // Degrees (or g) to the stored fixed-point units, saturating; NaN is 0
+  static int16_t toFixed(float value, float scale) {
+    const float scaled = value * scale;
+    if (!(scaled == scaled)) return 0;
+    if (scaled >= 32767.0f) return 32767;
+    if (scaled <= -32768.0f) return -32768;
+    return (int16_t)lroundf(scaled);
+  }
+
+  static int16_t centiDegrees(float degrees) { return toFixed(degrees, 100.0f); }
+  static int16_t milliG(float g) { return toFixed(g, 1000.0f); }
+
+  static void encodeRecord(uint32_t sequence, const HistorySample& sample, uint8_t* out) {
+    uint8_t* p = telemetryFrame::putU32(out, sequence);
+    p = telemetryFrame::putU32(p, sample.timestampUs);
+    p = telemetryFrame::putU16(p, sample.flags);
+    for (int16_t value : sample.imu) p = telemetryFrame::putU16(p, (uint16_t)value);
+    for (int16_t value : sample.attitude) p = telemetryFrame::putU16(p, (uint16_t)value);
+    p = telemetryFrame::putU16(p, (uint16_t)sample.verticalAccel);
+    for (int16_t value : sample.targets) p = telemetryFrame::putU16(p, (uint16_t)value);
+    for (int16_t value : sample.outputs) p = telemetryFrame::putU16(p, (uint16_t)value);
+    for (uint16_t value : sample.batteries) p = telemetryFrame::putU16(p, value);
+  }
+
+private:
+  HistoryRing<HistorySample, HISTORY_CAPACITY> ring;
+  std::atomic<uint16_t> batteryMillivolts[3] = {};
+};
+
+#endif
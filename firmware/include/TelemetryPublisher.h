@@ -0,0 +1,286 @@
+#ifndef TELEMETRY_PUBLISHER_H
+#define TELEMETRY_PUBLISHER_H
+
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <mutex>
+#include "Config.h"
+#include "Decimator.h"
+#include "TelemetryFrame.h"
+
+// Sends telemetry to each WebSocket client in its own format and at its own
+// rate.
+//
+// Sensor and battery updates are merged into one latest sample; service()
+// sends it to every client whose interval has come round, if anything
+// changed since that client's last frame.
+//
+// Attitude arrives at the control rate and each client only sees every
+// Nth sample, so roll, pitch and vertical acceleration are band-limited per
+// subscribed rate: one low-pass (Decimator.h) for each distinct rate a
+// client is on, fed every sample, so a 5 Hz dashboard doesn't show 15 Hz
+// vibration aliased down to a slow wobble. Yaw wraps at +/-180 and is sent
+// as fused; battery voltages change slowly and are sent as read. A client sends
+//   {"type":"hello","telemetry":"binary","rateHz":20}
+// (either field optional) to switch to binary frames (TelemetryFrame.h)
+// and/or change its rate, and gets {"type":"hello","telemetry":"binary",
+// "version":1,"rateHz":20} back. Clients start on JSON at TELEMETRY_RATE_HZ.
+//
+// Backpressure: a client with TELEMETRY_MAX_QUEUED_FRAMES or more messages
+// still queued in AsyncWebSocket skips its turn, and its next turn carries
+// the newest sample instead, so a slow client costs at most that many
+// queued frames of heap. Sequence numbers count samples sent, so skipped
+// turns (and slower rates) show up as gaps.
+//
+// Each frame is serialized at most once per format and rate per service()
+// call, into buffers owned by the publisher.
+class TelemetryPublisher {
+public:
+  enum Format : uint8_t {
+    FORMAT_JSON = 0,
+    FORMAT_BINARY = 1
+  };
+
+  struct Stats {
+    uint32_t frames;          // Samples sent to at least one client
+    uint32_t sent;            // Messages sent, all clients
+    uint32_t coalesced;       // Turns skipped because the client's queue was full
+    uint32_t binaryClients;   // Clients on binary frames right now
+    uint64_t binaryBytes;     // Payload bytes sent, per format
+    uint64_t jsonBytes;
+  };
+
+private:
+  struct Client {
+    uint32_t id;
+    Format format;
+    uint16_t intervalMs;
+    uint32_t nextDueMs;
+    uint32_t sentVersion;     // Sample version in the last frame it got
+  };
+
+  // Telemetry low-pass for one subscribed rate
+  struct RateFilter {
+    uint16_t intervalMs;
+    Decimator<3> filter;      // Roll, pitch, vertical accel
+  };
+
+  AsyncWebSocket& ws;
+  const float sampleRateHz;   // setAttitude() calls per second
+
+  // Client table, shared by the WebSocket event handler (AsyncTCP task)
+  // and service() (service task)
+  mutable std::mutex mutex;
+  Client clients[TELEMETRY_MAX_CLIENTS];
+  uint8_t clientCount = 0;
+
+  // Latest sample, filters and frame state, only touched by the service task
+  TelemetrySample latest = {0, 0, NAN, NAN, NAN, NAN, {0.0f, 0.0f, 0.0f}};
+  RateFilter filters[TELEMETRY_MAX_CLIENTS];
+  uint8_t filterCount = 0;
+  float attitude[3] = {};     // Newest roll, pitch, vertical accel, unfiltered
+  uint32_t version = 1;       // Bumped by every update; clients start at 0
+  uint32_t sequence = 0;
+  uint8_t binaryFrame[telemetryFrame::BINARY_SIZE];
+  char jsonFrame[telemetryFrame::JSON_CAPACITY];
+  Stats stats = {};
+
+  int findClient(uint32_t id) const {
+    for (uint8_t i = 0; i < clientCount; i++) {
+      if (clients[i].id == id) return i;
+    }
+    return -1;
+  }
+
+  // The filter for a client's interval, designed (and settled on the
+  // latest sample) the first time a client is on that rate
+  uint8_t filterFor(uint16_t intervalMs) {
+    for (uint8_t i = 0; i < filterCount; i++) {
+      if (filters[i].intervalMs == intervalMs) return i;
+    }
+    RateFilter& entry = filters[filterCount];
+    entry.intervalMs = intervalMs;
+    entry.filter.init(sampleRateHz, 1000.0f / intervalMs);
+    if (latest.roll == latest.roll) entry.filter.reset(attitude);
+    return filterCount++;
+  }
+
+  // Send `frame` to one due client, serializing it on first use in that
+  // format; false if the client is gone or skipped its turn
+  bool sendFrame(const Client& due, const TelemetrySample& frame, size_t& binaryLength, size_t& jsonLength) {
+    AsyncWebSocketClient* client = ws.client(due.id);
+    if (!client) return false;
+    if (client->queueLen() >= TELEMETRY_MAX_QUEUED_FRAMES) {
+      stats.coalesced++;  // Its next turn carries the newest sample
+      return false;
+    }
+    if (due.format == FORMAT_BINARY) {
+      if (!binaryLength) binaryLength = telemetryFrame::encodeBinary(frame, binaryFrame);
+      client->binary((const char*)binaryFrame, binaryLength);
+      stats.binaryBytes += binaryLength;
+    } else {
+      if (!jsonLength) jsonLength = telemetryFrame::encodeJson(frame, jsonFrame, sizeof(jsonFrame));
+      if (!jsonLength) return false;
+      client->text(jsonFrame, jsonLength);
+      stats.jsonBytes += jsonLength;
+    }
+    stats.sent++;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    int index = findClient(due.id);
+    if (index >= 0) clients[index].sentVersion = version;
+    return true;
+  }
+
+  static uint16_t intervalFor(int rateHz) {
+    rateHz = constrain(rateHz, 1, TELEMETRY_MAX_RATE_HZ);
+    return (uint16_t)(1000 / rateHz);
+  }
+
+  // {"type":"hello", "telemetry":"binary"|"json", "rateHz":N}
+  void handleHello(AsyncWebSocketClient* client, const char* format, int rateHz) {
+    Format current;
+    uint16_t intervalMs;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      int index = findClient(client->id());
+      if (index < 0) return;
+      Client& entry = clients[index];
+      if (strcmp(format, "binary") == 0) entry.format = FORMAT_BINARY;
+      else if (strcmp(format, "json") == 0) entry.format = FORMAT_JSON;
+      if (rateHz > 0) entry.intervalMs = intervalFor(rateHz);
+      current = entry.format;
+      intervalMs = entry.intervalMs;
+    }
+    char reply[80];
+    int length = snprintf(reply, sizeof(reply), "{\"type\":\"hello\",\"telemetry\":\"%s\",\"version\":%u,\"rateHz\":%u}",
+                          current == FORMAT_BINARY ? "binary" : "json", (unsigned)telemetryFrame::VERSION,
+                          (unsigned)(1000 / intervalMs));
+    client->text(reply, length);
+  }
+
+public:
+  // sampleRate: how often setAttitude() is called (once per control tick)
+  explicit TelemetryPublisher(AsyncWebSocket& socket, float sampleRate = SUSPENSION_SAMPLE_RATE_HZ)
+    : ws(socket), sampleRateHz(sampleRate) {}
+
+  // Feed every WebSocket event through here (from AsyncWebSocket::onEvent)
+  void onEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (clientCount < TELEMETRY_MAX_CLIENTS) {
+        clients[clientCount++] = {client->id(), FORMAT_JSON, intervalFor(TELEMETRY_RATE_HZ), (uint32_t)millis(), 0};
+      }
+    } else if (type == WS_EVT_DISCONNECT) {
+      std::lock_guard<std::mutex> lock(mutex);
+      int index = findClient(client->id());
+      if (index >= 0) clients[index] = clients[--clientCount];
+    } else if (type == WS_EVT_DATA) {
+      // Only whole, single-frame text messages carry requests
+      const AwsFrameInfo* info = (const AwsFrameInfo*)arg;
+      if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) return;
+
+      DynamicJsonDocument doc(256);
+      if (deserializeJson(doc, (const char*)data, len)) return;
+      const char* requestType = doc["type"] | "";
+      if (strcmp(requestType, "hello") == 0) handleHello(client, doc["telemetry"] | "", doc["rateHz"] | 0);
+    }
+  }
+
+  // Merge new readings into the next frame (service task). Attitude is
+  // NaN while the IMU is offline; the filters start over when it returns.
+  void setAttitude(float roll, float pitch, float yaw, float verticalAccel, uint32_t timestampUs) {
+    const bool online = roll == roll && pitch == pitch && verticalAccel == verticalAccel;
+    const bool wasOnline = latest.roll == latest.roll;
+    attitude[0] = roll;
+    attitude[1] = pitch;
+    attitude[2] = verticalAccel;
+    for (uint8_t i = 0; i < filterCount; i++) {
+      if (online && !wasOnline) filters[i].filter.reset(attitude);
+      else if (online) filters[i].filter.push(attitude);
+    }
+    latest.roll = online ? roll : NAN;
+    latest.pitch = online ? pitch : NAN;
+    latest.yaw = yaw;
+    latest.verticalAccel = online ? verticalAccel : NAN;
+    latest.timestampUs = timestampUs;
+    version++;
+  }
+
+  void setBatteries(float battery1, float battery2, float battery3) {
+    latest.batteries[0] = battery1;
+    latest.batteries[1] = battery2;
+    latest.batteries[2] = battery3;
+    version++;
+  }
+
+  // Send the latest sample to every client that is due (service task, every
+  // SERVICE_TASK_PERIOD_MS or so)
+  void service(uint32_t nowMs) {
+    Client due[TELEMETRY_MAX_CLIENTS];
+    uint8_t dueFilter[TELEMETRY_MAX_CLIENTS];
+    uint8_t count = 0;
+    uint32_t binaryClients = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      // One filter per rate someone is subscribed at: drop the ones nobody
+      // uses any more, add any new rate
+      for (uint8_t f = 0; f < filterCount;) {
+        bool used = false;
+        for (uint8_t i = 0; i < clientCount && !used; i++) used = clients[i].intervalMs == filters[f].intervalMs;
+        if (used) f++;
+        else filters[f] = filters[--filterCount];
+      }
+      for (uint8_t i = 0; i < clientCount; i++) {
+        Client& client = clients[i];
+        const uint8_t filter = filterFor(client.intervalMs);
+        if (client.format == FORMAT_BINARY) binaryClients++;
+        if ((int32_t)(nowMs - client.nextDueMs) < 0 || client.sentVersion == version) continue;
+        // Keep to the client's rate without drifting, unless it fell behind
+        client.nextDueMs += client.intervalMs;
+        if ((int32_t)(nowMs - client.nextDueMs) >= 0) client.nextDueMs = nowMs + client.intervalMs;
+        dueFilter[count] = filter;
+        due[count++] = client;
+      }
+    }
+    stats.binaryClients = binaryClients;
+    if (!count) return;
+
+    bool sent = false;
+    for (uint8_t f = 0; f < filterCount; f++) {
+      TelemetrySample frame = latest;
+      frame.sequence = sequence;
+      if (latest.roll == latest.roll) {
+        frame.roll = filters[f].filter.output(0);
+        frame.pitch = filters[f].filter.output(1);
+        frame.verticalAccel = filters[f].filter.output(2);
+      }
+      size_t binaryLength = 0, jsonLength = 0;
+      for (uint8_t i = 0; i < count; i++) {
+        if (dueFilter[i] != f) continue;
+        sent |= sendFrame(due[i], frame, binaryLength, jsonLength);
+      }
+    }
+    if (sent) {
+      sequence++;
+      stats.frames++;
+    }
+  }
+
+  Format getFormat(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    int index = findClient(id);
+    return index >= 0 ? clients[index].format : FORMAT_JSON;
+  }
+
+  // Frames per second a client is subscribed at (0 if unknown)
+  uint16_t getRate(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    int index = findClient(id);
+    return index >= 0 ? 1000 / clients[index].intervalMs : 0;
+  }
+
+  Stats getStats() const { return stats; }
+};
+
+#endif
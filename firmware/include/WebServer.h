@@ -6,40 +6,46 @@
 #include <WiFi.h>
 #include <ArduinoJson.h>
 #include <functional>
+#include "JsonWriter.h"
+#include "ResponseBufferPool.h"
 #include "StorageManager.h"
+#include "TelemetryHistory.h"
+#include "TelemetryPublisher.h"
 
 class WebServerManager {
 private:
   AsyncWebServer server{80};
   AsyncWebSocket ws{"/ws"};
+  TelemetryPublisher telemetry{ws};  // Per-client JSON or binary frames
+  ResponseBufferPool<HTTP_RESPONSE_BUFFERS, HTTP_RESPONSE_BUFFER_SIZE> responseBuffers;
+  uint32_t bootId = 0;                 // Keeps ETags from matching across reboots
+  uint32_t announcedConfigVersion = 0;
+  uint32_t lastConfigAnnounceMs = 0;
   StorageManager* storageManager = nullptr;
+  const TelemetryHistory* history = nullptr;  // Recorded by the control task
   std::function<void()> calibrationCallback = nullptr;
   std::function<bool()> mpuStatusCallback = nullptr;
   std::function<void(uint8_t)> orientationCallback = nullptr;
   
-  // Latest sensor data for HTTP polling
-  float latestRoll = 0.0f;
-  float latestPitch = 0.0f;
-  float latestYaw = 0.0f;
-  float latestVerticalAccel = 0.0f;
-  float latestBattery1 = 0.0f;
-  float latestBattery2 = 0.0f;
-  float latestBattery3 = 0.0f;
-  
 public:
-  void init(StorageManager& storage) {
+  void init(StorageManager& storage, const TelemetryHistory& telemetryHistory) {
     storageManager = &storage;
+    history = &telemetryHistory;
+    bootId = esp_random();
     
     // Start WiFi in AP mode
     startWiFiAP();
     
     // Setup WebSocket
-    ws.onEvent([](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    ws.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
       if (type == WS_EVT_CONNECT) {
         Serial.printf("WebSocket client #%u connected\n", client->id());
+        char message[CONFIG_MESSAGE_SIZE];
+        client->text(message, formatConfigMessage(message, storageManager->getConfigVersion()));
       } else if (type == WS_EVT_DISCONNECT) {
         Serial.printf("WebSocket client #%u disconnected\n", client->id());
       }
+      telemetry.onEvent(client, type, arg, data, len);  // Telemetry format negotiation
     });
     server.addHandler(&ws);
     
@@ -56,42 +62,33 @@ public:
     ws.textAll(message);
   }
   
-  // Store latest sensor/battery data
-  struct {
-    float roll = NAN, pitch = NAN, yaw = NAN, verticalAccel = NAN;
-    float battery1 = 0, battery2 = 0, battery3 = 0;
-  } latestData;
-  
-  // Send combined sensor and battery data to all connected clients
-  void sendTelemetry() {
-    String json = "{\"type\":\"telemetry\",\"roll\":" + String(latestData.roll, 1) + 
-                  ",\"pitch\":" + String(latestData.pitch, 1) + 
-                  ",\"yaw\":" + String(latestData.yaw, 1) + 
-                  ",\"verticalAccel\":" + String(latestData.verticalAccel, 2) + 
-                  ",\"voltages\":[" + 
-                  String(latestData.battery1, 2) + "," + 
-                  String(latestData.battery2, 2) + "," + 
-                  String(latestData.battery3, 2) + "]}";
-    ws.textAll(json);
+  // Send telemetry to the clients that are due (service task, every pass)
+  void serviceTelemetry(uint32_t nowMs) {
+    telemetry.service(nowMs);
   }
   
-  // Send sensor data to all connected clients
-  void sendSensorData(float roll, float pitch, float yaw, float verticalAccel) {
-    latestData.roll = roll;
-    latestData.pitch = pitch;
-    latestData.yaw = yaw;
-    latestData.verticalAccel = verticalAccel;
-    sendTelemetry();
-  }
+  TelemetryPublisher::Stats getTelemetryStats() const { return telemetry.getStats(); }
   
-  // Send battery voltage data to all connected clients
-  void sendBatteryData(float battery1, float battery2, float battery3) {
-    latestData.battery1 = battery1;
-    latestData.battery2 = battery2;
-    latestData.battery3 = battery3;
-    sendTelemetry();
+  // Tell WebSocket clients the config changed, so they refetch /api/config
+  // (service task, every pass). Bursts of changes, such as a slider drag,
+  // are announced at most every CONFIG_ANNOUNCE_INTERVAL_MS; the last one
+  // always goes out.
+  void serviceConfigVersion(uint32_t nowMs) {
+    const uint32_t version = storageManager->getConfigVersion();
+    if (version == announcedConfigVersion || nowMs - lastConfigAnnounceMs < CONFIG_ANNOUNCE_INTERVAL_MS) return;
+    announcedConfigVersion = version;
+    lastConfigAnnounceMs = nowMs;
+    char message[CONFIG_MESSAGE_SIZE];
+    ws.textAll(message, formatConfigMessage(message, version));
   }
   
+#ifdef NATIVE_BUILD
+  // Host runner and benchmarks: dispatch a request through the routes, and
+  // connect a WebSocket client
+  bool handleRequest(AsyncWebServerRequest& request) { return server.handle(request); }
+  AsyncWebSocketClient* connectClient() { return ws.connectClient(); }
+#endif
+  
   // Set calibration callback for MPU6050 recalibration
   void setCalibrationCallback(std::function<void()> callback) {
     calibrationCallback = callback;
@@ -105,22 +102,73 @@ public:
     orientationCallback = callback;
   }
   
-  // Store latest sensor data for HTTP polling
-  void setSensorData(float roll, float pitch, float yaw, float verticalAccel) {
-    latestRoll = roll;
-    latestPitch = pitch;
-    latestYaw = yaw;
-    latestVerticalAccel = verticalAccel;
+  // Store latest sensor data for the next telemetry frame (timestamp:
+  // micros() of the sample). HTTP polling reads the history instead.
+  void setSensorData(float roll, float pitch, float yaw, float verticalAccel, uint32_t timestampUs) {
+    telemetry.setAttitude(roll, pitch, yaw, verticalAccel, timestampUs);
   }
   
-  // Store latest battery data for HTTP polling
+  // Store latest battery data for the next telemetry frame
   void setBatteryData(float battery1, float battery2, float battery3) {
-    latestBattery1 = battery1;
-    latestBattery2 = battery2;
-    latestBattery3 = battery3;
+    telemetry.setBatteries(battery1, battery2, battery3);
   }
   
 private:
+  static constexpr size_t CONFIG_ETAG_SIZE = 24;
+  static constexpr size_t CONFIG_MESSAGE_SIZE = 80;
+  
+  // Quoted, as it goes in the header: "<boot id>-<config version>"
+  void formatConfigETag(char* etag, uint32_t version) const {
+    snprintf(etag, CONFIG_ETAG_SIZE, "\"%08lx-%lu\"", (unsigned long)bootId, (unsigned long)version);
+  }
+  
+  // {"type":"config","version":17,"etag":"\"9e3779b9-17\""}; returns its length
+  size_t formatConfigMessage(char* message, uint32_t version) const {
+    char etag[CONFIG_ETAG_SIZE];
+    formatConfigETag(etag, version);
+    JsonWriter json(message, CONFIG_MESSAGE_SIZE);
+    json.beginObject();
+    json.key("type").value("config");
+    json.key("version").value(version);
+    json.key("etag").value(etag);
+    json.endObject();
+    return json.size();
+  }
+  
+  // If-None-Match holds "*" or a list of (possibly weak, W/"...") tags
+  static bool etagMatches(const String& ifNoneMatch, const char* etag) {
+    return ifNoneMatch == "*" || strstr(ifNoneMatch.c_str(), etag) != nullptr;
+  }
+  
+  // Serialize a JSON response into a pooled buffer, to be sent from there
+  // as the socket drains: no Strings and no document on the heap. The
+  // buffer is held until the request goes away. Returns nullptr if the
+  // request was already answered (no buffer free, or the response did not
+  // fit).
+  template<typename Write>
+  AsyncWebServerResponse* beginJsonResponse(AsyncWebServerRequest* request, Write write) {
+    char* buffer = responseBuffers.acquire();
+    if (!buffer) {
+      request->send(503, "text/plain", "Busy");
+      return nullptr;
+    }
+    request->onDisconnect([this, buffer]() { responseBuffers.release(buffer); });
+    
+    JsonWriter json(buffer, HTTP_RESPONSE_BUFFER_SIZE);
+    write(json);
+    if (!json.ok()) {
+      request->send(500, "text/plain", "Response too large");
+      return nullptr;
+    }
+    const size_t length = json.size();
+    return request->beginResponse("application/json", length,
+      [buffer, length](uint8_t* out, size_t maxLen, size_t index) -> size_t {
+        const size_t count = length - index < maxLen ? length - index : maxLen;
+        memcpy(out, buffer + index, count);
+        return count;
+      });
+  }
+  
   void startWiFiAP() {
     // First, try to connect to home WiFi
     Serial.println("Attempting to connect to home WiFi...");
@@ -173,54 +221,71 @@ private:
     // Enable CORS for all routes
     DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
     DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type");
+    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type, If-None-Match");
+    DefaultHeaders::Instance().addHeader("Access-Control-Expose-Headers", "ETag");
     
     // Handle OPTIONS preflight requests
     server.on("/*", HTTP_OPTIONS, [](AsyncWebServerRequest *request) {
       request->send(200);
     });
     
-    // API endpoint for sensor data (HTTP polling)
+    // API endpoint for sensor data (HTTP polling): the newest tick in the
+    // history, attitude null while the IMU is offline
     server.on("/api/sensors", HTTP_GET, [this](AsyncWebServerRequest *request) {
-      String json = "{\"roll\":" + String(latestRoll, 1) + 
-                    ",\"pitch\":" + String(latestPitch, 1) + 
-                    ",\"yaw\":" + String(latestYaw, 1) + 
-                    ",\"verticalAccel\":" + String(latestVerticalAccel, 2) + 
-                    ",\"batteries\":[" + String(latestBattery1, 2) + "," + 
-                    String(latestBattery2, 2) + "," + String(latestBattery3, 2) + "]}";
-      request->send(200, "application/json", json);
+      AsyncWebServerResponse* response = beginJsonResponse(request, [this](JsonWriter& json) {
+        HistorySample sample = {};
+        history->readLatest(sample);
+        const bool online = sample.flags & telemetryFrame::FLAG_IMU_ONLINE;
+        json.beginObject();
+        json.key("roll").value(online ? sample.attitude[0] * 0.01f : NAN, 1);
+        json.key("pitch").value(online ? sample.attitude[1] * 0.01f : NAN, 1);
+        json.key("yaw").value(online ? sample.attitude[2] * 0.01f : NAN, 1);
+        json.key("verticalAccel").value(online ? sample.verticalAccel * 0.001f : NAN, 2);
+        json.key("batteries").beginArray();
+        for (uint16_t millivolts : sample.batteries) json.value(millivolts * 0.001f, 2);
+        json.endArray();
+        json.endObject();
+      });
+      if (response) request->send(response);
     });
     
-    // API endpoint to get current config
+    // API endpoint for recent history: every control tick after ?since=
+    // (a sequence number; default 0, everything still held), streamed in
+    // the binary layout in TelemetryHistory.h straight from the ring
+    server.on("/api/history", HTTP_GET, [this](AsyncWebServerRequest *request) {
+      uint32_t since = 0;
+      if (request->hasParam("since")) since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+      AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+        [stream = history->stream(since)](uint8_t* out, size_t maxLen, size_t index) mutable -> size_t {
+          return stream.read(out, maxLen);
+        });
+      response->addHeader("Cache-Control", "no-store");
+      request->send(response);
+    });
+    
+    // API endpoint to get current config (system, servo and battery config
+    // in one response). The ETag is the config version, so a client whose
+    // copy is current gets 304 without anything being serialized.
     server.on("/api/config", HTTP_GET, [this](AsyncWebServerRequest *request) {
-      // Combine system config, servo config, and battery config into one response
-      String configJson = storageManager->getConfigJSON();
-      String servoConfigJson = storageManager->getServoConfigJSON();
-      String batteryConfigJson = storageManager->getBatteryConfigJSON();
-      
-      // Parse all JSON strings and combine them
-      DynamicJsonDocument doc(4096);
-      DeserializationError error1 = deserializeJson(doc, configJson);
-      
-      if (!error1) {
-        // Add servo config under "servos" key
-        DynamicJsonDocument servoDoc(2048);
-        DeserializationError error2 = deserializeJson(servoDoc, servoConfigJson);
-        if (!error2) {
-          doc["servos"] = servoDoc;
-        }
-        
-        // Add battery config under "batteries" key
-        DynamicJsonDocument batteryDoc(1024);
-        DeserializationError error3 = deserializeJson(batteryDoc, batteryConfigJson);
-        if (!error3) {
-          doc["batteries"] = batteryDoc["batteries"];
-        }
+      char etag[CONFIG_ETAG_SIZE];
+      formatConfigETag(etag, storageManager->getConfigVersion());
+      if (request->hasHeader("If-None-Match") && etagMatches(request->getHeader("If-None-Match")->value(), etag)) {
+        AsyncWebServerResponse* response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+        return;
       }
       
-      String combinedJson;
-      serializeJson(doc, combinedJson);
-      request->send(200, "application/json", combinedJson);
+      uint32_t version = 0;
+      AsyncWebServerResponse* response = beginJsonResponse(request, [this, &version](JsonWriter& json) {
+        version = storageManager->writeConfigJSON(json);
+      });
+      if (!response) return;
+      formatConfigETag(etag, version);  // The version actually serialized
+      response->addHeader("ETag", etag);
+      response->addHeader("Cache-Control", "no-cache");  // Revalidate every time
+      request->send(response);
     });
     
     // API endpoint to update config
@@ -234,49 +299,98 @@ private:
           serializeJson(doc, Serial);
           Serial.println();
           
+          // Collected first and applied together: one config version per request
+          StorageManager::ParameterUpdate updates[16] = {};  // One per field below
+          size_t count = 0;
+          bool orientationChanged = false;
+          uint8_t orientation = 0;
+          
           if (doc.containsKey("reactionSpeed")) {
             float val = doc["reactionSpeed"];
             Serial.printf("Updating reactionSpeed to: %.2f\n", val);
-            storageManager->updateParameter("reactionSpeed", val);
+            updates[count++] = {"reactionSpeed", val};
           }
           if (doc.containsKey("rideHeightOffset")) {
             float val = doc["rideHeightOffset"];
             Serial.printf("Updating rideHeightOffset to: %.0f\n", val);
-            storageManager->updateParameter("rideHeightOffset", val);
+            updates[count++] = {"rideHeightOffset", val};
           }
           if (doc.containsKey("rangeLimit")) {
             float val = doc["rangeLimit"];
             Serial.printf("Updating rangeLimit to: %.0f\n", val);
-            storageManager->updateParameter("rangeLimit", val);
+            updates[count++] = {"rangeLimit", val};
           }
           if (doc.containsKey("damping")) {
             float val = doc["damping"];
             Serial.printf("Updating damping to: %.2f\n", val);
-            storageManager->updateParameter("damping", val);
+            updates[count++] = {"damping", val};
           }
           if (doc.containsKey("frontRearBalance")) {
             float val = doc["frontRearBalance"];
             Serial.printf("Updating frontRearBalance to: %.2f\n", val);
-            storageManager->updateParameter("frontRearBalance", val);
+            updates[count++] = {"frontRearBalance", val};
           }
           if (doc.containsKey("stiffness")) {
             float val = doc["stiffness"];
             Serial.printf("Updating stiffness to: %.2f\n", val);
-            storageManager->updateParameter("stiffness", val);
+            updates[count++] = {"stiffness", val};
           }
           if (doc.containsKey("mpuOrientation")) {
-            uint8_t orientation = doc["mpuOrientation"];
+            orientation = doc["mpuOrientation"];
             Serial.printf("Updating mpuOrientation to: %d\n", orientation);
-            storageManager->updateParameter("mpuOrientation", orientation);
-            // Notify sensor fusion of orientation change
-            if (orientationCallback) {
-              orientationCallback(orientation);
-            }
+            updates[count++] = {"mpuOrientation", (float)orientation};
+            orientationChanged = true;
+          }
+          if (doc.containsKey("mountRollTrim")) {
+            float val = doc["mountRollTrim"];
+            Serial.printf("Updating mountRollTrim to: %.2f\n", val);
+            updates[count++] = {"mountRollTrim", val};
+          }
+          if (doc.containsKey("mountPitchTrim")) {
+            float val = doc["mountPitchTrim"];
+            Serial.printf("Updating mountPitchTrim to: %.2f\n", val);
+            updates[count++] = {"mountPitchTrim", val};
+          }
+          if (doc.containsKey("mountYawTrim")) {
+            float val = doc["mountYawTrim"];
+            Serial.printf("Updating mountYawTrim to: %.2f\n", val);
+            updates[count++] = {"mountYawTrim", val};
+          }
+          if (doc.containsKey("fusionMode")) {
+            uint8_t fusionMode = doc["fusionMode"];
+            Serial.printf("Updating fusionMode to: %d\n", fusionMode);
+            updates[count++] = {"fusionMode", (float)fusionMode};
+          }
+          if (doc.containsKey("simulationMode")) {
+            uint8_t simulationMode = doc["simulationMode"];
+            Serial.printf("Updating simulationMode to: %d\n", simulationMode);
+            updates[count++] = {"simulationMode", (float)simulationMode};
+          }
+          if (doc.containsKey("servoLatencyMs")) {
+            float val = doc["servoLatencyMs"];
+            Serial.printf("Updating servoLatencyMs to: %.1f\n", val);
+            updates[count++] = {"servoLatencyMs", val};
+          }
+          if (doc.containsKey("servoTimeConstantMs")) {
+            float val = doc["servoTimeConstantMs"];
+            Serial.printf("Updating servoTimeConstantMs to: %.1f\n", val);
+            updates[count++] = {"servoTimeConstantMs", val};
+          }
+          if (doc.containsKey("predictionGain")) {
+            float val = doc["predictionGain"];
+            Serial.printf("Updating predictionGain to: %.2f\n", val);
+            updates[count++] = {"predictionGain", val};
           }
           if (doc.containsKey("fpvAutoMode")) {
             bool autoMode = doc["fpvAutoMode"];
             Serial.printf("Updating fpvAutoMode to: %s\n", autoMode ? "true" : "false");
-            storageManager->updateParameter("fpvAutoMode", autoMode ? 1.0f : 0.0f);
+            updates[count++] = {"fpvAutoMode", autoMode ? 1.0f : 0.0f};
+          }
+          storageManager->updateParameters(updates, count);
+          
+          // Notify sensor fusion of orientation change
+          if (orientationChanged && orientationCallback) {
+            orientationCallback(orientation);
           }
           
           request->send(200, "application/json", "{\"status\":\"success\"}");
@@ -0,0 +1,9 @@
+#ifndef NATIVE_ASYNCTCP_H
+#define NATIVE_ASYNCTCP_H
+
+// Nothing from AsyncTCP is used directly; ESPAsyncWebServer.h carries the
+// host stand-ins for the server side.
+
+#include "Arduino.h"
+
+#endif
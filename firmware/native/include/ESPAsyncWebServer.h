@@ -0,0 +1,390 @@
+#ifndef NATIVE_ESPASYNCWEBSERVER_H
+#define NATIVE_ESPASYNCWEBSERVER_H
+
+// Host stand-in for ESPAsyncWebServer.
+//
+// Routes registered with on() are kept in a table so the native runner and
+// benchmarks can dispatch requests synchronously via AsyncWebServer::handle().
+// Responses are captured on the request object instead of going to a socket.
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000,
+  HTTP_HEAD = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY = 0b01111111
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+typedef std::function<void()> ArDisconnectHandler;
+
+class AsyncWebHeader {
+private:
+  String headerName;
+  String headerValue;
+
+public:
+  AsyncWebHeader(const String& name, const String& value) : headerName(name), headerValue(value) {}
+  const String& name() const { return headerName; }
+  const String& value() const { return headerValue; }
+};
+
+class AsyncWebParameter {
+private:
+  String paramName;
+  String paramValue;
+
+public:
+  AsyncWebParameter(const String& name, const String& value) : paramName(name), paramValue(value) {}
+  const String& name() const { return paramName; }
+  const String& value() const { return paramValue; }
+};
+
+// A response built with beginResponse(): a fixed body, or one pulled from a
+// callback as the socket drains (beginChunkedResponse(): until it returns 0)
+class AsyncWebServerResponse {
+public:
+  int code;
+  String contentType;
+  String content;
+  size_t contentLength;
+  AwsResponseFiller filler;
+  bool chunked = false;
+  std::vector<AsyncWebHeader> headers;
+
+  AsyncWebServerResponse(int c, const String& type, size_t len, AwsResponseFiller fill)
+      : code(c), contentType(type), contentLength(len), filler(fill) {}
+
+  void addHeader(const String& name, const String& value) { headers.emplace_back(name, value); }
+};
+
+class AsyncWebServerRequest {
+private:
+  ArDisconnectHandler disconnectHandler;
+  std::vector<AsyncWebHeader> requestHeaders;
+  std::vector<AsyncWebParameter> params;
+
+public:
+  // TCP segment the callback responses are pulled in
+  static constexpr size_t SEGMENT_SIZE = 1436;
+
+  WebRequestMethodComposite method = HTTP_GET;
+  String url;
+
+  // Captured response
+  int responseCode = 0;
+  String responseType;
+  String responseBody;
+  std::vector<AsyncWebHeader> responseHeaders;
+
+  AsyncWebServerRequest(WebRequestMethodComposite m, const String& u) : method(m), url(u) {}
+
+  // ESPAsyncWebServer deletes the request once its connection closes,
+  // after the response was sent or the client went away
+  ~AsyncWebServerRequest() {
+    if (disconnectHandler) disconnectHandler();
+  }
+
+  // Host helper: a header as the client sent it
+  void addRequestHeader(const String& name, const String& value) { requestHeaders.emplace_back(name, value); }
+
+  bool hasHeader(const String& name) const { return findHeader(name) != nullptr; }
+  AsyncWebHeader* getHeader(const String& name) { return findHeader(name); }
+
+  // Host helper: a query string parameter
+  void addParam(const String& name, const String& value) { params.emplace_back(name, value); }
+
+  bool hasParam(const String& name) const { return getParam(name) != nullptr; }
+  AsyncWebParameter* getParam(const String& name) const {
+    for (const AsyncWebParameter& param : params) {
+      if (param.name() == name) return const_cast<AsyncWebParameter*>(&param);
+    }
+    return nullptr;
+  }
+
+  // Host helper: a header of the captured response (nullptr if absent)
+  const AsyncWebHeader* responseHeader(const String& name) const {
+    for (const AsyncWebHeader& header : responseHeaders) {
+      if (header.name().equalsIgnoreCase(name)) return &header;
+    }
+    return nullptr;
+  }
+
+  void onDisconnect(ArDisconnectHandler handler) { disconnectHandler = handler; }
+
+  void send(int code, const String& contentType = String(), const String& content = String()) {
+    responseCode = code;
+    responseType = contentType;
+    responseBody = content;
+  }
+
+  AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(), const String& content = String()) {
+    AsyncWebServerResponse* response = new AsyncWebServerResponse(code, contentType, content.length(), nullptr);
+    response->content = content;
+    return response;
+  }
+
+  AsyncWebServerResponse* beginResponse(const String& contentType, size_t len, AwsResponseFiller callback) {
+    return new AsyncWebServerResponse(200, contentType, len, callback);
+  }
+
+  AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller callback) {
+    AsyncWebServerResponse* response = new AsyncWebServerResponse(200, contentType, 0, callback);
+    response->chunked = true;
+    return response;
+  }
+
+  // Pull the body segment by segment, appending to responseBody (reserve it
+  // to capture without allocating)
+  void send(AsyncWebServerResponse* response) {
+    responseCode = response->code;
+    responseType = response->contentType;
+    responseHeaders.swap(response->headers);
+    responseBody = "";
+    if (!response->filler) responseBody.concat(response->content);
+    uint8_t segment[SEGMENT_SIZE];
+    for (size_t index = 0; response->filler && (response->chunked || index < response->contentLength);) {
+      size_t count = response->filler(segment, SEGMENT_SIZE, index);
+      if (!count) break;
+      responseBody.concat((const char*)segment, count);
+      index += count;
+    }
+    delete response;
+  }
+
+private:
+  AsyncWebHeader* findHeader(const String& name) const {
+    for (const AsyncWebHeader& header : requestHeaders) {
+      if (header.name().equalsIgnoreCase(name)) return const_cast<AsyncWebHeader*>(&header);
+    }
+    return nullptr;
+  }
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index,
+                           uint8_t* data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                           size_t index, size_t total)> ArBodyHandlerFunction;
+
+class AsyncWebHandler {
+public:
+  virtual ~AsyncWebHandler() {}
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+  String uri;
+  WebRequestMethodComposite method = HTTP_ANY;
+  ArRequestHandlerFunction onRequest;
+  ArUploadHandlerFunction onUpload;
+  ArBodyHandlerFunction onBody;
+
+  bool matches(WebRequestMethodComposite m, const String& url) const {
+    if (!(method & m)) return false;
+    if (uri == url) return true;
+    if (uri.endsWith("*")) return url.startsWith(uri.substring(0, uri.length() - 1));
+    return false;
+  }
+};
+
+// WebSocket
+typedef enum {
+  WS_EVT_CONNECT,
+  WS_EVT_DISCONNECT,
+  WS_EVT_PONG,
+  WS_EVT_ERROR,
+  WS_EVT_DATA
+} AwsEventType;
+
+typedef enum {
+  WS_CONTINUATION,
+  WS_TEXT,
+  WS_BINARY,
+  WS_DISCONNECT = 0x08,
+  WS_PING,
+  WS_PONG
+} AwsFrameType;
+
+typedef struct {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+} AwsFrameInfo;
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient {
+private:
+  uint32_t clientId;
+
+public:
+  // What this client has been sent (host-side measurements)
+  uint64_t messagesReceived = 0;
+  uint64_t bytesReceived = 0;
+  std::string lastMessage;
+  bool lastMessageBinary = false;
+
+  // A stalled client (weak link) keeps what it is sent queued until drain()
+  bool stalled = false;
+  size_t queued = 0;
+
+  explicit AsyncWebSocketClient(uint32_t id) : clientId(id) {}
+  uint32_t id() const { return clientId; }
+
+  void text(const char* message, size_t len) { deliver(message, len, false); }
+  void text(const String& message) { text(message.c_str(), message.length()); }
+  void binary(const char* message, size_t len) { deliver(message, len, true); }
+
+  size_t queueLen() const { return queued; }
+  void drain(size_t messages) { queued = messages < queued ? queued - messages : 0; }
+
+  void deliver(const char* message, size_t len, bool binary) {
+    if (stalled) queued++;
+    messagesReceived++;
+    bytesReceived += len;
+    lastMessage.assign(message, len);
+    lastMessageBinary = binary;
+  }
+};
+
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                           void* arg, uint8_t* data, size_t len)> AwsEventHandler;
+
+class AsyncWebSocket : public AsyncWebHandler {
+private:
+  String url;
+  AwsEventHandler eventHandler;
+  std::vector<std::unique_ptr<AsyncWebSocketClient>> clients;
+  uint32_t nextClientId = 1;
+
+public:
+  // Traffic counters for host-side measurements
+  uint64_t messagesSent = 0;
+  uint64_t bytesSent = 0;
+
+  explicit AsyncWebSocket(const String& u) : url(u) {}
+
+  void onEvent(AwsEventHandler handler) { eventHandler = handler; }
+  size_t count() const { return clients.size(); }
+
+  void textAll(const char* message) { textAll(message, strlen(message)); }
+  void textAll(const String& message) { textAll(message.c_str(), message.length()); }
+  void textAll(const char* message, size_t len) {
+    for (auto& client : clients) send(client.get(), message, len, false);
+  }
+  void binaryAll(const char* message, size_t len) {
+    for (auto& client : clients) send(client.get(), message, len, true);
+  }
+  void text(uint32_t id, const char* message, size_t len) { send(client(id), message, len, false); }
+  void binary(uint32_t id, const char* message, size_t len) { send(client(id), message, len, true); }
+
+  AsyncWebSocketClient* client(uint32_t id) {
+    for (auto& client : clients) {
+      if (client->id() == id) return client.get();
+    }
+    return nullptr;
+  }
+
+  // Host helpers to simulate dashboard connections
+  AsyncWebSocketClient* connectClient() {
+    clients.emplace_back(new AsyncWebSocketClient(nextClientId++));
+    AsyncWebSocketClient* client = clients.back().get();
+    if (eventHandler) eventHandler(this, client, WS_EVT_CONNECT, nullptr, nullptr, 0);
+    return client;
+  }
+  // A whole text message from a client
+  void receiveText(uint32_t id, const char* message) {
+    AsyncWebSocketClient* sender = client(id);
+    if (!sender || !eventHandler) return;
+    std::string data(message);
+    AwsFrameInfo info = {WS_TEXT, 0, 1, 1, WS_TEXT, data.size(), {0, 0, 0, 0}, 0};
+    eventHandler(this, sender, WS_EVT_DATA, &info, (uint8_t*)&data[0], data.size());
+  }
+  void disconnectClient(uint32_t id) {
+    for (auto it = clients.begin(); it != clients.end(); ++it) {
+      if ((*it)->id() == id) {
+        if (eventHandler) eventHandler(this, it->get(), WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+        clients.erase(it);
+        return;
+      }
+    }
+  }
+
+private:
+  void send(AsyncWebSocketClient* client, const char* message, size_t len, bool binary) {
+    if (!client) return;
+    client->deliver(message, len, binary);
+    messagesSent++;
+    bytesSent += len;
+  }
+};
+
+class DefaultHeaders {
+public:
+  static DefaultHeaders& Instance() {
+    static DefaultHeaders instance;
+    return instance;
+  }
+  void addHeader(const String& name, const String& value) {
+    (void)name;
+    (void)value;
+  }
+};
+
+class AsyncWebServer {
+private:
+  std::vector<std::unique_ptr<AsyncCallbackWebHandler>> routes;
+
+public:
+  explicit AsyncWebServer(uint16_t port) { (void)port; }
+
+  void begin() {}
+  void end() {}
+
+  AsyncWebHandler& addHandler(AsyncWebHandler* handler) { return *handler; }
+
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                              ArUploadHandlerFunction onUpload = nullptr, ArBodyHandlerFunction onBody = nullptr) {
+    routes.emplace_back(new AsyncCallbackWebHandler());
+    AsyncCallbackWebHandler& handler = *routes.back();
+    handler.uri = uri;
+    handler.method = method;
+    handler.onRequest = onRequest;
+    handler.onUpload = onUpload;
+    handler.onBody = onBody;
+    return handler;
+  }
+
+  // Host helper: dispatch a request to the first matching route. The body,
+  // if any, is delivered in a single chunk before the request handler runs,
+  // as ESPAsyncWebServer does for small bodies.
+  bool handle(AsyncWebServerRequest& request, uint8_t* body = nullptr, size_t len = 0) {
+    for (auto& route : routes) {
+      if (!route->matches(request.method, request.url)) continue;
+      if (body && len && route->onBody) route->onBody(&request, body, len, 0, len);
+      if (route->onRequest) route->onRequest(&request);
+      return true;
+    }
+    request.send(404);
+    return false;
+  }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+// In-memory filesystem used in place of SPIFFS on the host.
+
+#include <map>
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+class File : public Stream {
+private:
+  std::shared_ptr<std::string> data;
+  std::string path;
+  size_t position = 0;
+  bool writable = false;
+
+public:
+  File() {}
+  File(std::shared_ptr<std::string> contents, const std::string& filePath, bool canWrite)
+    : data(contents), path(filePath), writable(canWrite) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    if (!data || !writable) return 0;
+    data->append((const char*)buffer, size);
+    return size;
+  }
+  using Print::write;
+
+  int available() override { return data ? (int)(data->size() - position) : 0; }
+  int read() override { return (data && position < data->size()) ? (uint8_t)(*data)[position++] : -1; }
+  int peek() override { return (data && position < data->size()) ? (uint8_t)(*data)[position] : -1; }
+
+  size_t size() const { return data ? data->size() : 0; }
+  const char* name() const { return path.c_str(); }
+  void close() { data.reset(); }
+  operator bool() const { return (bool)data; }
+};
+
+class FS {
+protected:
+  std::map<std::string, std::shared_ptr<std::string>> files;
+
+public:
+  bool exists(const char* path) const { return files.count(path) != 0; }
+  bool exists(const String& path) const { return exists(path.c_str()); }
+
+  File open(const char* path, const char* mode = FILE_READ) {
+    auto it = files.find(path);
+    if (mode[0] == 'r') {
+      if (it == files.end()) return File();
+      return File(it->second, path, false);
+    }
+    if (it == files.end() || mode[0] == 'w') {
+      files[path] = std::make_shared<std::string>();
+    }
+    return File(files[path], path, true);
+  }
+  File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+
+  bool remove(const char* path) { return files.erase(path) != 0; }
+  bool remove(const String& path) { return remove(path.c_str()); }
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef NATIVE_MPU6050_H
+#define NATIVE_MPU6050_H
+
+// MPU6050 stand-in. Readings come from the native HAL's IMU source at the
+// current virtual time; a disconnected sensor reads back all zeros, which is
+// what the real driver leaves behind on an I2C failure.
+//
+// The FIFO is emulated: while enabled, frames (accel XYZ + gyro XYZ,
+// big-endian, 12 bytes) accumulate on the configured sample-rate grid as the
+// virtual clock advances, up to the chip's 1024-byte capacity.
+
+#include <deque>
+#include "Arduino.h"
+#include "NativeHal.h"
+
+#define MPU6050_DLPF_BW_256 0x00
+#define MPU6050_DLPF_BW_188 0x01
+#define MPU6050_DLPF_BW_98 0x02
+#define MPU6050_DLPF_BW_42 0x03
+#define MPU6050_DLPF_BW_20 0x04
+#define MPU6050_DLPF_BW_10 0x05
+#define MPU6050_DLPF_BW_5 0x06
+
+#define MPU6050_GYRO_FS_250 0x00
+#define MPU6050_ACCEL_FS_2 0x00
+
+class MPU6050 {
+private:
+  static constexpr size_t FIFO_CAPACITY = 1024;
+  static constexpr size_t FRAME_SIZE = 12;
+
+  uint8_t rateDivider = 0;
+  uint8_t dlpfMode = 0;
+  bool fifoEnabled = false;
+  bool accelFifo = false;
+  bool gyroFifo = false;
+  bool fifoOverflow = false;
+  uint64_t nextSampleUs = 0;
+  std::deque<uint8_t> fifo;
+
+  uint32_t samplePeriodUs() const {
+    uint32_t outputRate = dlpfMode ? 1000 : 8000;
+    return (1000000 / outputRate) * (1 + rateDivider);
+  }
+
+  void fillFifo() {
+    if (!fifoEnabled || !accelFifo || !gyroFifo || !nativeHal::imuConnected()) return;
+    uint64_t now = nativeHal::nowMicros();
+    if (nextSampleUs == 0) nextSampleUs = now;
+    while (nextSampleUs <= now) {
+      int16_t raw[6];
+      nativeHal::readImuAt(nextSampleUs, raw);
+      if (fifo.size() + FRAME_SIZE > FIFO_CAPACITY) {
+        fifoOverflow = true;
+        fifo.erase(fifo.begin(), fifo.begin() + FRAME_SIZE);  // Oldest data is overwritten
+      }
+      for (int i = 0; i < 6; i++) {
+        fifo.push_back((uint8_t)(raw[i] >> 8));
+        fifo.push_back((uint8_t)(raw[i] & 0xFF));
+      }
+      nextSampleUs += samplePeriodUs();
+    }
+  }
+
+public:
+  MPU6050(uint8_t address = 0x68) { (void)address; }
+
+  void initialize() {}
+  bool testConnection() { return nativeHal::imuConnected(); }
+
+  void getMotion6(int16_t* ax, int16_t* ay, int16_t* az, int16_t* gx, int16_t* gy, int16_t* gz) {
+    int16_t raw[6];
+    nativeHal::readImu(raw);
+    *ax = raw[0];
+    *ay = raw[1];
+    *az = raw[2];
+    *gx = raw[3];
+    *gy = raw[4];
+    *gz = raw[5];
+  }
+
+  // Configuration
+  void setRate(uint8_t rate) { rateDivider = rate; }
+  void setDLPFMode(uint8_t mode) { dlpfMode = mode; }
+  void setFullScaleGyroRange(uint8_t range) { (void)range; }
+  void setFullScaleAccelRange(uint8_t range) { (void)range; }
+
+  // Interrupts (no pin is modelled; data-ready state is implied by the FIFO)
+  void setInterruptMode(bool mode) { (void)mode; }
+  void setInterruptDrive(bool drive) { (void)drive; }
+  void setInterruptLatch(bool latch) { (void)latch; }
+  void setIntDataReadyEnabled(bool enabled) { (void)enabled; }
+  bool getIntFIFOBufferOverflowStatus() {
+    fillFifo();
+    bool overflow = fifoOverflow;
+    fifoOverflow = false;
+    return overflow;
+  }
+
+  // FIFO
+  void setFIFOEnabled(bool enabled) {
+    fifoEnabled = enabled;
+    nextSampleUs = 0;
+  }
+  void setAccelFIFOEnabled(bool enabled) { accelFifo = enabled; }
+  void setXGyroFIFOEnabled(bool enabled) { gyroFifo = enabled; }
+  void setYGyroFIFOEnabled(bool enabled) { gyroFifo = enabled; }
+  void setZGyroFIFOEnabled(bool enabled) { gyroFifo = enabled; }
+  void setTempFIFOEnabled(bool enabled) { (void)enabled; }
+
+  void resetFIFO() {
+    fifo.clear();
+    fifoOverflow = false;
+    nextSampleUs = 0;
+  }
+
+  uint16_t getFIFOCount() {
+    fillFifo();
+    return (uint16_t)fifo.size();
+  }
+
+  void getFIFOBytes(uint8_t* data, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+      if (fifo.empty()) {
+        data[i] = 0;
+        continue;
+      }
+      data[i] = fifo.front();
+      fifo.pop_front();
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+// Host-side control surface for the native hardware shims.
+//
+// Firmware code never includes this header; it is used by the native runner
+// and the benchmarks to drive the virtual clock, feed the IMU and inspect
+// what the firmware wrote to the (fake) peripherals.
+
+#include <cstdint>
+#include <functional>
+
+namespace nativeHal {
+
+// Virtual clock
+uint64_t nowMicros();
+void advanceMicros(uint64_t us);
+void setMicros(uint64_t us);
+
+// Serial output (disable to keep benchmark runs quiet)
+void setSerialEnabled(bool enabled);
+
+// IMU feed. The source fills raw MPU6050 counts (ax, ay, az, gx, gy, gz)
+// for the given virtual time; the default is a slow synthetic roll/pitch sweep.
+using ImuSource = std::function<void(uint64_t timeUs, int16_t raw[6])>;
+void setImuSource(ImuSource source);
+void setImuConnected(bool connected);
+bool imuConnected();
+void readImu(int16_t raw[6]);
+void readImuAt(uint64_t timeUs, int16_t raw[6]);  // For FIFO emulation
+
+// ADC inputs
+void setAnalogValue(uint8_t pin, uint16_t value);
+
+// LEDC outputs (duty and hpoint as last released by ledc_update_duty/ledcWrite)
+uint32_t ledcDuty(uint8_t channel);
+uint32_t ledcHpoint(uint8_t channel);
+uint32_t ledcFrequency(uint8_t channel);
+uint8_t ledcResolution(uint8_t channel);
+uint64_t ledcWriteCount();
+uint64_t ledcTimerResetCount();
+
+// Fake PCA9685 servo driver at I2C 0x40: its registers as last written, and
+// LEDn ON/OFF counts (bit 12 = full on/off)
+void setPca9685Connected(bool connected);
+uint8_t pca9685Register(uint8_t reg);
+uint16_t pca9685On(uint8_t channel);
+uint16_t pca9685Off(uint8_t channel);
+uint64_t pca9685Transactions();
+uint64_t pca9685BytesWritten();
+
+}  // namespace nativeHal
+
+#endif
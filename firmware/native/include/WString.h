@@ -0,0 +1,132 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+// Host stand-in for the Arduino String class, backed by std::string.
+// Only the subset used by the firmware (and by ArduinoJson's Arduino
+// string adapter) is provided.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <strings.h>
+
+class String {
+private:
+  std::string s;
+
+public:
+  String(const char* cstr = "") : s(cstr ? cstr : "") {}
+  String(const String& other) = default;
+  String(String&& other) = default;
+  String(const std::string& str) : s(str) {}
+  explicit String(char c) : s(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10) : String((unsigned long)value, base) {}
+  explicit String(int value, unsigned char base = 10) : String((long)value, base) {}
+  explicit String(unsigned int value, unsigned char base = 10) : String((unsigned long)value, base) {}
+  explicit String(long value, unsigned char base = 10) {
+    if (base == 10) {
+      s = std::to_string(value);
+    } else {
+      s = (value < 0) ? "-" + toBase((unsigned long)(-value), base) : toBase((unsigned long)value, base);
+    }
+  }
+  explicit String(unsigned long value, unsigned char base = 10) : s(toBase(value, base)) {}
+  explicit String(float value, unsigned char decimalPlaces = 2) : String((double)value, decimalPlaces) {}
+  explicit String(double value, unsigned char decimalPlaces = 2) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    s = buf;
+  }
+
+  String& operator=(const String& other) = default;
+  String& operator=(String&& other) = default;
+  String& operator=(const char* cstr) {
+    s = cstr ? cstr : "";
+    return *this;
+  }
+
+  bool reserve(unsigned int size) {
+    s.reserve(size);
+    return true;
+  }
+  unsigned int length() const { return (unsigned int)s.size(); }
+  bool isEmpty() const { return s.empty(); }
+  const char* c_str() const { return s.c_str(); }
+  const std::string& str() const { return s; }
+
+  bool concat(const String& other) { s += other.s; return true; }
+  bool concat(const char* cstr) { if (!cstr) return false; s += cstr; return true; }
+  bool concat(const char* cstr, unsigned int len) { if (!cstr) return false; s.append(cstr, len); return true; }
+  bool concat(char c) { s += c; return true; }
+
+  String& operator+=(const String& other) { concat(other); return *this; }
+  String& operator+=(const char* cstr) { concat(cstr); return *this; }
+  String& operator+=(char c) { concat(c); return *this; }
+
+  bool equals(const String& other) const { return s == other.s; }
+  bool equals(const char* cstr) const { return s == (cstr ? cstr : ""); }
+  bool equalsIgnoreCase(const String& other) const {
+    return s.size() == other.s.size() && strncasecmp(s.c_str(), other.s.c_str(), s.size()) == 0;
+  }
+  bool operator==(const String& other) const { return equals(other); }
+  bool operator==(const char* cstr) const { return equals(cstr); }
+  bool operator!=(const String& other) const { return !equals(other); }
+  bool operator!=(const char* cstr) const { return !equals(cstr); }
+  bool operator<(const String& other) const { return s < other.s; }
+
+  char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = s.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  int indexOf(const String& str, unsigned int from = 0) const {
+    size_t pos = s.find(str.s, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+  bool endsWith(const String& suffix) const {
+    return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+  }
+  String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= s.size()) return String();
+    return String(s.substr(from, to - from));
+  }
+
+  long toInt() const { return strtol(s.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s.c_str(), nullptr); }
+
+private:
+  static std::string toBase(unsigned long value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char buf[8 * sizeof(unsigned long) + 1];
+    char* p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do {
+      unsigned long digit = value % base;
+      *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+      value /= base;
+    } while (value);
+    return std::string(p);
+  }
+};
+
+// Kept for source compatibility with the Arduino core, where
+// concatenation expressions evaluate to this type.
+class StringSumHelper : public String {
+public:
+  using String::String;
+  StringSumHelper(const String& s) : String(s) {}
+};
+
+inline StringSumHelper operator+(const String& lhs, const String& rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+#endif
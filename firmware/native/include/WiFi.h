@@ -0,0 +1,59 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+// WiFi stand-in: station mode always "connects" immediately.
+
+#include "Arduino.h"
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+private:
+  wifi_mode_t currentMode = WIFI_OFF;
+  wl_status_t currentStatus = WL_DISCONNECTED;
+
+public:
+  bool mode(wifi_mode_t m) { currentMode = m; return true; }
+  wifi_mode_t getMode() const { return currentMode; }
+
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr) {
+    (void)ssid;
+    (void)passphrase;
+    currentStatus = WL_CONNECTED;
+    return currentStatus;
+  }
+  wl_status_t status() const { return currentStatus; }
+  IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+
+  bool softAP(const char* ssid, const char* passphrase = nullptr) {
+    (void)ssid;
+    (void)passphrase;
+    return true;
+  }
+  bool softAPConfig(IPAddress localIp, IPAddress gateway, IPAddress subnet) {
+    (void)localIp;
+    (void)gateway;
+    (void)subnet;
+    return true;
+  }
+  IPAddress softAPIP() const { return IPAddress(192, 168, 4, 1); }
+};
+
+extern WiFiClass WiFi;
+
+#endif
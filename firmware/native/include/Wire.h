@@ -0,0 +1,60 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+// I2C bus stand-in. Reads are not modelled; a transmission is acknowledged
+// only by the addresses the native HAL reports as present (the MPU6050 at
+// 0x68 while it is "connected", the fake PCA9685 at 0x40), and the bytes
+// written are handed to the fake PCA9685.
+
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+private:
+  static constexpr size_t BUFFER_LENGTH = 128;  // As the ESP32 driver
+
+  uint8_t txAddress = 0;
+  uint8_t txBuffer[BUFFER_LENGTH];
+  size_t txLength = 0;
+
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+    (void)sda;
+    (void)scl;
+    (void)frequency;
+    return true;
+  }
+  bool setClock(uint32_t frequency) { (void)frequency; return true; }
+
+  void beginTransmission(uint8_t address) {
+    txAddress = address;
+    txLength = 0;
+  }
+  void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+  uint8_t endTransmission(bool sendStop = true);
+
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true) {
+    (void)address;
+    (void)quantity;
+    (void)sendStop;
+    return 0;
+  }
+
+  size_t write(uint8_t c) override {
+    if (txLength >= BUFFER_LENGTH) return 0;
+    txBuffer[txLength++] = c;
+    return 1;
+  }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    size_t written = 0;
+    while (written < size && write(buffer[written])) written++;
+    return written;
+  }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef NATIVE_DRIVER_LEDC_H
+#define NATIVE_DRIVER_LEDC_H
+
+// ESP-IDF LEDC driver stand-in: the calls PWMOutputs makes beneath the
+// Arduino ledc* API. Channels of LEDC_HIGH_SPEED_MODE are the Arduino LEDC
+// channels 0-7. A duty and hpoint set with ledc_set_duty_with_hpoint() only
+// show up (and count as a write) once ledc_update_duty() releases them.
+
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_ERR_INVALID_ARG 0x102
+
+typedef enum {
+  LEDC_HIGH_SPEED_MODE = 0,
+  LEDC_LOW_SPEED_MODE,
+  LEDC_SPEED_MODE_MAX
+} ledc_mode_t;
+
+typedef enum {
+  LEDC_CHANNEL_0 = 0,
+  LEDC_CHANNEL_1,
+  LEDC_CHANNEL_2,
+  LEDC_CHANNEL_3,
+  LEDC_CHANNEL_4,
+  LEDC_CHANNEL_5,
+  LEDC_CHANNEL_6,
+  LEDC_CHANNEL_7,
+  LEDC_CHANNEL_MAX
+} ledc_channel_t;
+
+typedef enum {
+  LEDC_TIMER_0 = 0,
+  LEDC_TIMER_1,
+  LEDC_TIMER_2,
+  LEDC_TIMER_3,
+  LEDC_TIMER_MAX
+} ledc_timer_t;
+
+esp_err_t ledc_set_duty_with_hpoint(ledc_mode_t speedMode, ledc_channel_t channel, uint32_t duty, uint32_t hpoint);
+esp_err_t ledc_update_duty(ledc_mode_t speedMode, ledc_channel_t channel);
+esp_err_t ledc_timer_rst(ledc_mode_t speedMode, ledc_timer_t timer);
+
+#endif
@@ -0,0 +1,233 @@
+// Backing state for the native hardware shims.
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <WiFi.h>
+#include <Wire.h>
+#include <driver/ledc.h>
+#include "NativeHal.h"
+
+HardwareSerial Serial;
+fs::SPIFFSFS SPIFFS;
+TwoWire Wire;
+WiFiClass WiFi;
+
+namespace {
+
+constexpr uint8_t LEDC_CHANNELS = 16;
+constexpr uint8_t ANALOG_PINS = 40;
+constexpr uint8_t MPU6050_ADDRESS = 0x68;
+constexpr uint8_t PCA9685_I2C_ADDRESS = 0x40;
+
+uint64_t clockMicros = 0;
+bool serialEnabled = true;
+bool imuIsConnected = true;
+
+uint16_t analogValues[ANALOG_PINS] = {0};
+
+struct LedcChannel {
+  uint32_t frequency = 0;
+  uint8_t resolution = 0;
+  uint32_t duty = 0;
+  uint32_t hpoint = 0;
+  uint32_t stagedDuty = 0;  // Set but not yet released by ledc_update_duty()
+  uint32_t stagedHpoint = 0;
+};
+LedcChannel ledc[LEDC_CHANNELS];
+uint64_t ledcWrites = 0;
+uint64_t ledcTimerResets = 0;
+
+int ledcIndex(ledc_mode_t speedMode, ledc_channel_t channel) {
+  int index = (int)speedMode * 8 + (int)channel;
+  return speedMode < LEDC_SPEED_MODE_MAX && channel < LEDC_CHANNEL_MAX && index < LEDC_CHANNELS ? index : -1;
+}
+
+// PCA9685 register file. Writes start at the register named by their first
+// byte and, with MODE1.AI set, auto-increment (LED15_OFF_H wraps to MODE1).
+// PRE_SCALE only takes writes while MODE1.SLEEP is set, as on the chip.
+struct FakePca9685 {
+  bool connected = true;
+  uint8_t registers[256] = {};
+  uint64_t transactions = 0;
+  uint64_t bytes = 0;
+
+  FakePca9685() {
+    registers[0x00] = 0x11;  // MODE1: SLEEP | ALLCALL
+    registers[0x01] = 0x04;  // MODE2: OUTDRV
+    registers[0xFE] = 0x1E;  // PRE_SCALE: 200 Hz
+  }
+
+  void write(const uint8_t* data, size_t length) {
+    transactions++;
+    bytes += length;
+    if (length == 0) return;
+    uint8_t reg = data[0];
+    for (size_t i = 1; i < length; i++) {
+      if (reg != 0xFE || (registers[0x00] & 0x10)) registers[reg] = data[i];
+      if (registers[0x00] & 0x20) reg = reg == 0x45 ? 0x00 : (uint8_t)(reg + 1);
+    }
+  }
+};
+FakePca9685 pca9685;
+
+// Default IMU source: a slow roll/pitch sweep with the matching gyro rates,
+// expressed in raw counts at the MPU6050 power-on ranges (±2 g, ±250 °/s).
+void syntheticImu(uint64_t timeUs, int16_t raw[6]) {
+  const float t = timeUs * 1e-6f;
+  const float rollAmp = 10.0f * (float)DEG_TO_RAD;
+  const float pitchAmp = 6.0f * (float)DEG_TO_RAD;
+  const float rollW = 2.0f * (float)PI * 0.5f;
+  const float pitchW = 2.0f * (float)PI * 0.3f;
+
+  float roll = rollAmp * sinf(rollW * t);
+  float pitch = pitchAmp * sinf(pitchW * t);
+  float rollRate = rollAmp * rollW * cosf(rollW * t) * (float)RAD_TO_DEG;
+  float pitchRate = pitchAmp * pitchW * cosf(pitchW * t) * (float)RAD_TO_DEG;
+
+  raw[0] = (int16_t)(sinf(pitch) * 16384.0f);
+  raw[1] = (int16_t)(cosf(pitch) * sinf(roll) * 16384.0f);
+  raw[2] = (int16_t)(cosf(pitch) * cosf(roll) * 16384.0f);
+  raw[3] = (int16_t)(rollRate * 131.0f);
+  raw[4] = (int16_t)(pitchRate * 131.0f);
+  raw[5] = 0;
+}
+
+nativeHal::ImuSource imuSource = syntheticImu;
+
+}  // namespace
+
+// Arduino core time
+unsigned long millis() { return (uint32_t)(clockMicros / 1000); }
+unsigned long micros() { return (uint32_t)clockMicros; }
+void delay(uint32_t ms) { clockMicros += (uint64_t)ms * 1000; }
+void delayMicroseconds(uint32_t us) { clockMicros += us; }
+
+uint32_t esp_random() {
+  static uint32_t state = 0x9E3779B9u;  // xorshift32
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t value) { (void)pin; (void)value; }
+int digitalRead(uint8_t pin) { (void)pin; return LOW; }
+
+// ADC
+uint16_t analogRead(uint8_t pin) { return pin < ANALOG_PINS ? analogValues[pin] : 0; }
+void analogReadResolution(uint8_t bits) { (void)bits; }
+void analogSetAttenuation(adc_attenuation_t attenuation) { (void)attenuation; }
+
+// LEDC
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolutionBits) {
+  if (channel >= LEDC_CHANNELS) return 0;
+  ledc[channel].frequency = freq;
+  ledc[channel].resolution = resolutionBits;
+  return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) { (void)pin; (void)channel; }
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+  if (channel >= LEDC_CHANNELS) return;
+  ledc[channel].duty = duty;
+  ledc[channel].stagedDuty = duty;
+  ledcWrites++;
+}
+
+esp_err_t ledc_set_duty_with_hpoint(ledc_mode_t speedMode, ledc_channel_t channel, uint32_t duty, uint32_t hpoint) {
+  int index = ledcIndex(speedMode, channel);
+  if (index < 0) return ESP_ERR_INVALID_ARG;
+  ledc[index].stagedDuty = duty;
+  ledc[index].stagedHpoint = hpoint;
+  return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speedMode, ledc_channel_t channel) {
+  int index = ledcIndex(speedMode, channel);
+  if (index < 0) return ESP_ERR_INVALID_ARG;
+  ledc[index].duty = ledc[index].stagedDuty;
+  ledc[index].hpoint = ledc[index].stagedHpoint;
+  ledcWrites++;
+  return ESP_OK;
+}
+
+esp_err_t ledc_timer_rst(ledc_mode_t speedMode, ledc_timer_t timer) {
+  if (speedMode >= LEDC_SPEED_MODE_MAX || timer >= LEDC_TIMER_MAX) return ESP_ERR_INVALID_ARG;
+  ledcTimerResets++;
+  return ESP_OK;
+}
+
+// Serial
+size_t HardwareSerial::write(uint8_t c) {
+  if (serialEnabled) fputc(c, stdout);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (serialEnabled) fwrite(buffer, 1, size, stdout);
+  return size;
+}
+
+// I2C: only the MPU6050 can acknowledge
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void)sendStop;
+  if (txAddress == PCA9685_I2C_ADDRESS && pca9685.connected) {
+    pca9685.write(txBuffer, txLength);
+    return 0;
+  }
+  return (txAddress == MPU6050_ADDRESS && imuIsConnected) ? 0 : 2;
+}
+
+namespace nativeHal {
+
+uint64_t nowMicros() { return clockMicros; }
+void advanceMicros(uint64_t us) { clockMicros += us; }
+void setMicros(uint64_t us) { clockMicros = us; }
+
+void setSerialEnabled(bool enabled) { serialEnabled = enabled; }
+
+void setImuSource(ImuSource source) { imuSource = source ? source : syntheticImu; }
+void setImuConnected(bool connected) { imuIsConnected = connected; }
+bool imuConnected() { return imuIsConnected; }
+
+void readImu(int16_t raw[6]) { readImuAt(clockMicros, raw); }
+
+void readImuAt(uint64_t timeUs, int16_t raw[6]) {
+  if (!imuIsConnected) {
+    memset(raw, 0, 6 * sizeof(int16_t));
+    return;
+  }
+  imuSource(timeUs, raw);
+}
+
+void setAnalogValue(uint8_t pin, uint16_t value) {
+  if (pin < ANALOG_PINS) analogValues[pin] = value;
+}
+
+uint32_t ledcDuty(uint8_t channel) { return channel < LEDC_CHANNELS ? ledc[channel].duty : 0; }
+uint32_t ledcHpoint(uint8_t channel) { return channel < LEDC_CHANNELS ? ledc[channel].hpoint : 0; }
+uint32_t ledcFrequency(uint8_t channel) { return channel < LEDC_CHANNELS ? ledc[channel].frequency : 0; }
+uint8_t ledcResolution(uint8_t channel) { return channel < LEDC_CHANNELS ? ledc[channel].resolution : 0; }
+uint64_t ledcWriteCount() { return ledcWrites; }
+uint64_t ledcTimerResetCount() { return ledcTimerResets; }
+
+void setPca9685Connected(bool connected) { pca9685.connected = connected; }
+uint8_t pca9685Register(uint8_t reg) { return pca9685.registers[reg]; }
+
+uint16_t pca9685On(uint8_t channel) {
+  const uint8_t* led = &pca9685.registers[0x06 + 4 * (channel & 15)];
+  return (uint16_t)(led[0] | ((led[1] & 0x1F) << 8));
+}
+
+uint16_t pca9685Off(uint8_t channel) {
+  const uint8_t* led = &pca9685.registers[0x06 + 4 * (channel & 15)];
+  return (uint16_t)(led[2] | ((led[3] & 0x1F) << 8));
+}
+
+uint64_t pca9685Transactions() { return pca9685.transactions; }
+uint64_t pca9685BytesWritten() { return pca9685.bytes; }
+
+}  // namespace nativeHal
@@ -0,0 +1,56 @@
+// Native runner: executes the firmware's setup()/loop() on the host against
+// the virtual clock and reports how fast the loop runs in wall-clock time.
+//
+//   .pio/build/native/program [--iterations N] [--step-us US] [--no-imu] [--quiet]
+//
+// Each loop() iteration advances the virtual clock by --step-us (default
+// 1000 us), so N iterations simulate N * step microseconds of vehicle time.
+
+#include <Arduino.h>
+#include <chrono>
+#include "NativeHal.h"
+
+void setup();
+void loop();
+
+int main(int argc, char** argv) {
+  uint64_t iterations = 100000;
+  uint64_t stepUs = 1000;
+  bool quiet = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--step-us") && i + 1 < argc) stepUs = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--no-imu")) nativeHal::setImuConnected(false);
+    else if (!strcmp(argv[i], "--quiet")) quiet = true;
+    else {
+      fprintf(stderr, "usage: %s [--iterations N] [--step-us US] [--no-imu] [--quiet]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  nativeHal::setSerialEnabled(!quiet);
+  setup();
+
+  uint64_t writesBefore = nativeHal::ledcWriteCount();
+  uint64_t i2cFramesBefore = nativeHal::pca9685Transactions();
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint64_t i = 0; i < iterations; i++) {
+    loop();
+    nativeHal::advanceMicros(stepUs);
+  }
+
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double wallSeconds = std::chrono::duration<double>(elapsed).count();
+  uint64_t servoWrites = nativeHal::ledcWriteCount() - writesBefore;
+  uint64_t i2cFrames = nativeHal::pca9685Transactions() - i2cFramesBefore;
+
+  fprintf(stderr, "loop iterations:   %llu\n", (unsigned long long)iterations);
+  fprintf(stderr, "simulated time:    %.3f s\n", iterations * stepUs * 1e-6);
+  fprintf(stderr, "wall time:         %.3f s\n", wallSeconds);
+  fprintf(stderr, "iterations/s:      %.0f\n", wallSeconds > 0 ? iterations / wallSeconds : 0.0);
+  fprintf(stderr, "servo writes:      %llu\n", (unsigned long long)servoWrites);
+  if (i2cFrames) fprintf(stderr, "PCA9685 writes:    %llu\n", (unsigned long long)i2cFrames);
+  return 0;
+}
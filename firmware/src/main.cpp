@@ -12,33 +12,98 @@
 #include "WebServer.h"
 #include "StorageManager.h"
 #include "PWMOutputs.h"
+#include "Pca9685ServoBackend.h"
+#include "I2cBus.h"
+#include "ControlScheduler.h"
+#include "SpscQueue.h"
+#include "SnapshotBuffer.h"
+#include "ImuAcquisition.h"
+#include "Decimator.h"
+#include "ActuationPredictor.h"
+#include "MotionLimiter.h"
+#include "TelemetryHistory.h"
 
 // Global instances
+I2cBus i2cBus(Wire);  // MPU6050, and the PCA9685 if the servos are on it
 MPU6050 mpu;
+ImuAcquisition imuAcquisition;
 SensorFusion sensorFusion;
 SuspensionSimulator suspensionSimulator;
+ActuationPredictor actuationPredictor;
+MotionLimiter motionLimiter;
 WebServerManager webServer;
 StorageManager storageManager;
 PWMOutputs pwmOutputs;
+#if SERVO_OUTPUT_BACKEND == SERVO_BACKEND_PCA9685
+Pca9685ServoBackend servoBackend(i2cBus);
+#endif
+ControlScheduler controlScheduler;
+
+// Rate conversion between pipeline stages: attitude fused at the IMU rate ->
+// suspension model at the control rate (telemetry band-limits the
+// control-rate attitude for each client rate, TelemetryPublisher.h)
+#if SUSPENSION_FIXED_POINT
+FixedDecimator<5> controlDecimator;  // roll, pitch, vertical accel, roll rate, pitch rate (Q16.16)
+#else
+Decimator<5> controlDecimator;    // roll, pitch, vertical accel, roll rate, pitch rate
+#endif
 
 // Timing variables
-unsigned long lastMPUReadTime = 0;
-unsigned long lastSimulationTime = 0;
+uint32_t telemetryGeneration = 0;  // Control state generation last handed to telemetry
+unsigned long lastStatsReportTime = 0;
+const unsigned long STATS_REPORT_INTERVAL = 10000; // Report control loop timing every 10s
 
 // Development mode flag
-bool mpuConnected = false;
+std::atomic<bool> mpuConnected{false};  // Written by the control task, read anywhere
+uint32_t lastImuSampleUs = 0;  // Timestamp of the last sample fused (control task)
+ImuSample lastImuSample = {};  // Last raw sample fused, zero while the IMU is offline (control task)
+uint32_t appliedConfigGeneration = 0;  // Config version the axis remap, predictor and PWM timing were built from
+
+// Requests from the web/service side, applied by the control task at a tick boundary
+enum class ControlCommandType : uint8_t {
+  Calibrate
+};
+
+struct ControlCommand {
+  ControlCommandType type;
+  uint8_t value;
+};
+
+// Control loop state published once per tick for the service side
+struct ControlState {
+  float roll;
+  float pitch;
+  float yaw;
+  float verticalAccel;
+  float outputs[4];  // FL, FR, RL, RR servo angles before calibration
+  uint32_t timestampUs;  // micros() of the newest fused IMU sample
+  bool mpuConnected;
+  ControlScheduler::Stats timing;
+};
+
+// Status text from the control task to web clients
+struct StatusMessage {
+  char text[96];
+};
+
+// Cross-core channels (single producer, single consumer each; web handlers
+// are the only producer of control commands)
+SpscQueue<ControlCommand, 8> controlCommands;   // web handlers -> control
+std::atomic<bool> timingStatsResetRequested{false};  // service -> control (after each report)
+SpscQueue<StatusMessage, 4> statusMessages;     // control -> service
+SnapshotBuffer<ControlState> controlState;      // control -> service
+TelemetryHistory telemetryHistory;              // control -> web handlers (any number of readers)
+
+#if SUSPENSION_DUAL_CORE
+void controlTask(void* parameter);
+void serviceTask(void* parameter);
+#endif
 
 // Battery monitoring variables
 float batteryVoltages[3] = {0.0f, 0.0f, 0.0f}; // Voltages for 3 batteries
 unsigned long lastBatteryReadTime = 0;
 const unsigned long BATTERY_READ_INTERVAL = 500; // Read batteries every 500ms
 
-// Sensor data for HTTP polling
-float currentRoll = 0.0f;
-float currentPitch = 0.0f;
-float currentYaw = 0.0f;
-float currentVerticalAccel = 0.0f;
-
 // Function to read battery voltage from ADC pin
 float readBatteryVoltage(uint8_t plugAssignment) {
   if (plugAssignment == 0) return 0.0f; // No plug assigned
@@ -77,7 +142,8 @@ void setup() {
   SuspensionConfig config = storageManager.getConfig();
   
   // Initialize I2C and MPU6050
-  Wire.begin(21, 22); // SDA=21, SCL=22 for most ESP32 boards
+  Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN); // SDA=21, SCL=22 for most ESP32 boards
+  Wire.setClock(I2C_CLOCK_HZ);
   delay(100);
   
   Serial.println("Testing MPU6050 connection...");
@@ -110,50 +176,44 @@ void setup() {
     Serial.println("MPU6050 connection failed - using simulated sensor data for testing");
     Serial.println("Check wiring: SDA=GPIO21, SCL=GPIO22, VCC=3.3V, GND=GND");
     Serial.println("MPU6050 should be at I2C address 0x68");
-    webServer.init(storageManager);
+    webServer.init(storageManager, telemetryHistory);
     webServer.sendStatus("Development Mode: MPU6050 not connected (using simulated data)");
   } else {
     Serial.println("MPU6050 initialized successfully");
     Serial.println("MPU6050 found at I2C address 0x68");
   }
   
-  // Configure sensor fusion with orientation
-  sensorFusion.setOrientation(config.mpuOrientation);
+  // Configure sensor fusion with orientation and engine
+  sensorFusion.setMounting(config.mpuOrientation, config.mountRollTrim, config.mountPitchTrim, config.mountYawTrim);
+  sensorFusion.setMode(config.fusionMode);
   
-  // Initialize sensor fusion with config
-  sensorFusion.init(config.sampleRate);
+  // Initialize sensor fusion at the IMU rate (it fuses every sample)
+  sensorFusion.init(IMU_SAMPLE_RATE_HZ);
   
   // Initialize and start WiFi + Web Server (if not already started)
   if (mpuConnected) {
-    webServer.init(storageManager);
+    webServer.init(storageManager, telemetryHistory);
   }
   
   // Set up recalibration callback for web interface
+  // (runs in the web server's context, so it only queues the request)
   webServer.setCalibrationCallback([&]() {
-    if (mpuConnected) {
-      sensorFusion.calibrate(mpu, [](const String& msg) {
-        webServer.sendStatus(msg);
-      });
-    } else {
-      webServer.sendStatus("Cannot calibrate - MPU6050 not connected");
+    if (!controlCommands.push({ControlCommandType::Calibrate, 0})) {
+      webServer.sendStatus("Busy - try calibrating again");
     }
   });
   
   // Set up orientation callback for web interface
+  // (the control task picks the new mounting up with the next config version)
   webServer.setOrientationCallback([&](uint8_t orientation) {
-    sensorFusion.setOrientation(orientation);
     webServer.sendStatus("MPU6050 orientation updated");
   });
   
   // Set up MPU status callback for web interface
+  // (reports what the control loop last saw, without touching the I2C bus
+  // or reading the control state snapshot, which belongs to the service task)
   webServer.setMPUStatusCallback([&]() {
-    // Test if sensor is currently responding
-    if (!mpuConnected) return false;
-    
-    // Quick test: try to read WHO_AM_I register
-    Wire.beginTransmission(0x68);
-    byte error = Wire.endTransmission();
-    return (error == 0);
+    return mpuConnected.load(std::memory_order_relaxed);
   });
   
   // Calibrate to current position as level (sends status to web dashboard)
@@ -167,8 +227,13 @@ void setup() {
   // Initialize suspension simulator with config
   suspensionSimulator.init(config);
   
-  // Initialize PWM outputs
+  // Initialize PWM outputs (at each servo's frame rate)
+#if SERVO_OUTPUT_BACKEND == SERVO_BACKEND_PCA9685
+  pwmOutputs.init(servoBackend);
+#else
   pwmOutputs.init();
+#endif
+  pwmOutputs.configure(storageManager.getServoConfig());
   
   // Configure ADC pins for battery monitoring
   analogReadResolution(12); // 12-bit resolution (0-4095)
@@ -178,123 +243,317 @@ void setup() {
   pinMode(BATTERY_ADC_PIN_C, INPUT); // GPIO 32
   Serial.println("Battery monitoring ADC pins configured");
   
+  // Start sampling into the MPU6050 FIFO (after the blocking calibration,
+  // which reads the sensor directly). I2C errors are handled by the
+  // acquisition code, so keep the driver from flooding Serial with them.
+  esp_log_level_set("Wire", ESP_LOG_NONE);
+  imuAcquisition.begin(mpu, IMU_SAMPLE_RATE_HZ, IMU_INT_PIN, &i2cBus);
+  lastImuSampleUs = micros();
+  
+  // Start the control loop schedule (after calibration so the first tick isn't late)
+  controlScheduler.init(SUSPENSION_SAMPLE_RATE_HZ, micros());
+  controlDecimator.init(IMU_SAMPLE_RATE_HZ, 1000000.0f / controlScheduler.getPeriodUs());
+  actuationPredictor.configure(config, controlScheduler.getPeriodUs());
+  motionLimiter.configure(storageManager.getServoConfig(), controlScheduler.getPeriodUs());
+  
   // Send final ready status
   webServer.sendStatus("System ready");
   
+#if SUSPENSION_DUAL_CORE
+  // Control loop on its own core at high priority (with IMU acquisition just
+  // above it); web, storage and battery work next to WiFi/AsyncTCP on the other core
+  imuAcquisition.startTask();
+  xTaskCreatePinnedToCore(controlTask, "control", CONTROL_TASK_STACK_SIZE, nullptr,
+                          CONTROL_TASK_PRIORITY, nullptr, CONTROL_TASK_CORE);
+  xTaskCreatePinnedToCore(serviceTask, "service", SERVICE_TASK_STACK_SIZE, nullptr,
+                          SERVICE_TASK_PRIORITY, nullptr, SERVICE_TASK_CORE);
+#endif
+  
   Serial.println("Setup complete!");
 }
 
-// Main loop
-void loop() {
-  unsigned long currentTime = millis();
-  
-  // Read MPU6050 sensor data at specified rate
-  if (currentTime - lastMPUReadTime >= (1000 / SUSPENSION_SAMPLE_RATE_HZ)) {
-    float accelX, accelY, accelZ, gyroX, gyroY, gyroZ;
-    
-    // Always try to read sensor data (to detect reconnection)
-    int16_t ax, ay, az, gx, gy, gz;
-    
-    // Suppress I2C error messages temporarily to avoid flooding serial
-    esp_log_level_set("Wire", ESP_LOG_NONE);
-    mpu.getMotion6(&ax, &ay, &az, &gx, &gy, &gz);
-    esp_log_level_set("Wire", ESP_LOG_WARN);
+// Feed the latest fused attitude (and its rates, for the predictor) to the
+// control-rate anti-aliasing filter
+void pushFusedSample() {
+#if SUSPENSION_FIXED_POINT
+  const fixedPoint::q16_t fused[5] = {sensorFusion.getRollQ16(), sensorFusion.getPitchQ16(), sensorFusion.getVerticalAccelerationQ16(),
+                                      sensorFusion.getRollRateQ16(), sensorFusion.getPitchRateQ16()};
+#else
+  const float fused[5] = {sensorFusion.getRoll(), sensorFusion.getPitch(), sensorFusion.getVerticalAcceleration(),
+                          sensorFusion.getRollRate(), sensorFusion.getPitchRate()};
+#endif
+  controlDecimator.push(fused);
+}
+
+// Fuse every IMU sample acquired since the last tick, each with the time
+// step from its own timestamp. Falls back to a level, motionless reading (and
+// flags the sensor offline) once the acquisition stops receiving data.
+void fuseIMUSamples() {
+  ImuSample sample;
+  uint16_t fused = 0;
+  while (imuAcquisition.pop(sample)) {
+    int32_t dtUs = (int32_t)(sample.timestampUs - lastImuSampleUs);
+    lastImuSampleUs = sample.timestampUs;
+    lastImuSample = sample;
     
-    // Check if we got valid data (not all zeros which indicates error)
-    if (ax != 0 || ay != 0 || az != 0 || gx != 0 || gy != 0 || gz != 0) {
-      // Convert raw values to g's and dps
-      accelX = ax / 16384.0f;
-      accelY = ay / 16384.0f;
-      accelZ = az / 16384.0f;
-      gyroX = gx / 131.0f;
-      gyroY = gy / 131.0f;
-      gyroZ = gz / 131.0f;
-      
-      // Update connection status - sensor is working!
-      if (!mpuConnected) {
-        mpuConnected = true;
-        Serial.println("MPU6050 now responding - sensor online");
-      }
-    } else {
-      // I2C error - use neutral values for safety
-      accelX = 0.0f;
-      accelY = 0.0f;
-      accelZ = 1.0f;  // Gravity
-      gyroX = 0.0f;
-      gyroY = 0.0f;
-      gyroZ = 0.0f;
-      
-      // Mark sensor as disconnected
-      if (mpuConnected) {
-        mpuConnected = false;
-        Serial.println("MPU6050 stopped responding");
-      }
+    sensorFusion.updateRaw(sample.ax, sample.ay, sample.az, sample.gx, sample.gy, sample.gz, dtUs);
+    pushFusedSample();
+    fused++;
+  }
+  
+  if (fused > 0) {
+    // Update connection status - sensor is working!
+    if (!mpuConnected) {
+      mpuConnected = true;
+      Serial.println("MPU6050 now responding - sensor online");
     }
+  } else if (!imuAcquisition.isReceiving()) {
+    // No data - use neutral values (gravity only) for safety
+    sensorFusion.updateRaw(0, 0, SensorFusion::ACCEL_COUNTS_PER_G, 0, 0, 0, controlScheduler.getPeriodUs());
+    pushFusedSample();
+    lastImuSampleUs = micros();
+    lastImuSample = {};
     
-    // Update sensor fusion
-    sensorFusion.update(accelX, accelY, accelZ, gyroX, gyroY, gyroZ);
-    
-    lastMPUReadTime = currentTime;
+    // Mark sensor as disconnected
+    if (mpuConnected) {
+      mpuConnected = false;
+      Serial.println("MPU6050 stopped responding");
+    }
+  }
+}
+
+// Queue a status message for web clients (control task side; drops if full)
+void postStatus(const char* format, ...) {
+  StatusMessage message;
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message.text, sizeof(message.text), format, args);
+  va_end(args);
+  statusMessages.push(message);
+}
+
+// Apply queued requests from the web/service side
+void applyControlCommands() {
+  ControlCommand command;
+  while (controlCommands.pop(command)) {
+    switch (command.type) {
+      case ControlCommandType::Calibrate:
+        if (mpuConnected) {
+          postStatus("Calibrating IMU... Keep vehicle still!");
+          sensorFusion.startCalibration(imuAcquisition.getRateHz());  // One second of samples
+        } else {
+          postStatus("Cannot calibrate - MPU6050 not connected");
+        }
+        break;
+    }
+  }
+  if (timingStatsResetRequested.exchange(false, std::memory_order_relaxed)) {
+    controlScheduler.resetStats();
+  }
+}
+
+// One control tick: read -> fuse -> decimate -> simulate -> actuate, always together
+void runControlTick() {
+  // 1+2. Read and fuse everything the IMU sampled since the last tick (at the
+  // IMU rate, through the anti-aliasing filter)
+  bool wasCalibrating = sensorFusion.isCalibrating();
+  fuseIMUSamples();
+  if (wasCalibrating && !sensorFusion.isCalibrating()) {
+    postStatus("Calibration complete! Roll: %.1f°, Pitch: %.1f°", sensorFusion.getRollOffset(), sensorFusion.getPitchOffset());
   }
   
-  // Run suspension simulation
-  if (currentTime - lastSimulationTime >= (1000 / SUSPENSION_SAMPLE_RATE_HZ)) {
-    // Get current orientation and acceleration from sensor fusion
-    float roll = sensorFusion.getRoll();
-    float pitch = sensorFusion.getPitch();
-    float yaw = sensorFusion.getYaw();
-    float verticalAccel = sensorFusion.getVerticalAcceleration();
-    
-    // Update suspension state
-    suspensionSimulator.update(roll, pitch, verticalAccel);
-    
-    // Get suspension outputs (0-180 degrees for servos)
-    float fl = suspensionSimulator.getFrontLeftOutput();
-    float fr = suspensionSimulator.getFrontRightOutput();
-    float rl = suspensionSimulator.getRearLeftOutput();
-    float rr = suspensionSimulator.getRearRightOutput();
-    
-    // Get servo calibration settings
-    ServoConfig servoConfig = storageManager.getServoConfig();
-    
-    // Write PWM outputs with calibration applied
-    pwmOutputs.setChannel(0, fl, servoConfig.frontLeft);
-    pwmOutputs.setChannel(1, fr, servoConfig.frontRight);
-    pwmOutputs.setChannel(2, rl, servoConfig.rearLeft);
-    pwmOutputs.setChannel(3, rr, servoConfig.rearRight);
-    
-    // Broadcast sensor data to web clients (every 200ms = 5Hz)
-    static unsigned long lastBroadcast = 0;
-    if (currentTime - lastBroadcast >= 200) {
-      if (mpuConnected) {
-        webServer.sendSensorData(roll, pitch, yaw, verticalAccel);
-        webServer.setSensorData(roll, pitch, yaw, verticalAccel); // Store for HTTP polling
-      } else {
-        // Send NaN values when sensor offline - dashboard will display '--'
-        webServer.sendSensorData(NAN, NAN, NAN, NAN);
-        webServer.setSensorData(NAN, NAN, NAN, NAN); // Store for HTTP polling
-      }
-      lastBroadcast = currentTime;
+  // Pick up tuning published by the web handlers; the simulator ignores
+  // versions it has already seen and ramps into new ones
+  uint32_t configGeneration;
+  const ControlConfig* controlConfig = storageManager.acquireControlConfig(configGeneration);
+  suspensionSimulator.applyConfig(controlConfig->suspension, configGeneration);
+  sensorFusion.setMode(controlConfig->suspension.fusionMode);
+  if (configGeneration != appliedConfigGeneration) {
+    // Rebuild the remap matrix, prediction horizon, motion limits and PWM timing only when the config actually changed
+    const SuspensionConfig& suspension = controlConfig->suspension;
+    sensorFusion.setMounting(suspension.mpuOrientation, suspension.mountRollTrim, suspension.mountPitchTrim, suspension.mountYawTrim);
+    actuationPredictor.configure(suspension, controlScheduler.getPeriodUs());
+    motionLimiter.configure(controlConfig->servos, controlScheduler.getPeriodUs());
+    pwmOutputs.configure(controlConfig->servos);
+    appliedConfigGeneration = configGeneration;
+  }
+  
+  // 3+4. Simulate on the control-rate attitude, lead the servos by their lag,
+  // limit their speed and acceleration and actuate (0-180 degree outputs
+  // through the compiled servo calibration, every servo latched as one frame)
+#if SUSPENSION_FIXED_POINT
+  suspensionSimulator.updateFixed(controlDecimator.output(0), controlDecimator.output(1), controlDecimator.output(2));
+  actuationPredictor.predictFixed(suspensionSimulator, controlDecimator.output(3), controlDecimator.output(4));
+  fixedPoint::q16_t commands[PWMOutputs::MAX_CHANNELS];
+  for (uint8_t i = 0; i < pwmOutputs.getChannelCount(); i++) commands[i] = actuationPredictor.getOutputQ16(i);
+  motionLimiter.limitFixed(commands, pwmOutputs.getChannelCount());
+  pwmOutputs.commitFrameFixed(commands);
+  
+  float roll = fixedPoint::toFloat(controlDecimator.output(0));
+  float pitch = fixedPoint::toFloat(controlDecimator.output(1));
+  float verticalAccel = fixedPoint::toFloat(controlDecimator.output(2));
+#else
+  float roll = controlDecimator.output(0);
+  float pitch = controlDecimator.output(1);
+  float verticalAccel = controlDecimator.output(2);
+  suspensionSimulator.update(roll, pitch, verticalAccel);
+  actuationPredictor.predict(suspensionSimulator, controlDecimator.output(3), controlDecimator.output(4));
+  
+  float commands[PWMOutputs::MAX_CHANNELS];
+  for (uint8_t i = 0; i < pwmOutputs.getChannelCount(); i++) commands[i] = actuationPredictor.getOutput(i);
+  motionLimiter.limit(commands, pwmOutputs.getChannelCount());
+  pwmOutputs.commitFrame(commands);
+#endif
+  // Report the commanded positions
+  float fl = motionLimiter.getOutput(0);
+  float fr = motionLimiter.getOutput(1);
+  float rl = motionLimiter.getOutput(2);
+  float rr = motionLimiter.getOutput(3);
+  
+  // Record the tick for /api/history and /api/sensors
+  HistorySample record;
+  record.timestampUs = lastImuSampleUs;
+  record.flags = mpuConnected ? telemetryFrame::FLAG_IMU_ONLINE : 0;
+  const int16_t imu[6] = {lastImuSample.ax, lastImuSample.ay, lastImuSample.az,
+                          lastImuSample.gx, lastImuSample.gy, lastImuSample.gz};
+  memcpy(record.imu, imu, sizeof(imu));
+  record.attitude[0] = TelemetryHistory::centiDegrees(roll);
+  record.attitude[1] = TelemetryHistory::centiDegrees(pitch);
+  record.attitude[2] = TelemetryHistory::centiDegrees(sensorFusion.getYaw());
+  record.verticalAccel = TelemetryHistory::milliG(verticalAccel);
+  for (uint8_t i = 0; i < 4; i++) {
+#if SUSPENSION_FIXED_POINT
+    record.targets[i] = TelemetryHistory::centiDegrees(fixedPoint::toFloat(suspensionSimulator.getOutputQ16(i)));
+#else
+    record.targets[i] = TelemetryHistory::centiDegrees(suspensionSimulator.getOutput(i));
+#endif
+    record.outputs[i] = TelemetryHistory::centiDegrees(motionLimiter.getOutput(i));
+  }
+  telemetryHistory.record(record);
+  
+  // Publish state for the service side (at the control rate; telemetry
+  // band-limits it for each rate a client subscribes at)
+  ControlState& state = controlState.beginWrite();
+  state.roll = roll;
+  state.pitch = pitch;
+  state.yaw = sensorFusion.getYaw();
+  state.verticalAccel = verticalAccel;
+  state.outputs[0] = fl;
+  state.outputs[1] = fr;
+  state.outputs[2] = rl;
+  state.outputs[3] = rr;
+  state.timestampUs = lastImuSampleUs;
+  state.mpuConnected = mpuConnected;
+  state.timing = controlScheduler.getStats();
+  controlState.publish();
+}
+
+// Control side: runs the pipeline on the fixed-rate grid, catching up on
+// missed ticks (bounded so a slow tick can't starve everything else)
+void controlStep() {
+  applyControlCommands();
+  
+  for (uint32_t i = 0; i <= ControlScheduler::MAX_CATCHUP_TICKS && controlScheduler.beginTick(micros()); i++) {
+    runControlTick();
+    controlScheduler.endTick(micros());
+  }
+}
+
+// Periodic control loop health report on Serial
+void reportTimingStats(const ControlScheduler::Stats& stats) {
+  Serial.printf("Control loop: %u ticks, %u late, %u skipped, %u overruns, jitter mean %.0f us / max %u us, exec max %u us\n",
+                (unsigned)stats.ticks, (unsigned)stats.lateTicks, (unsigned)stats.skippedTicks, (unsigned)stats.overruns,
+                stats.meanJitterUs, (unsigned)stats.maxJitterUs, (unsigned)stats.maxExecUs);
+  timingStatsResetRequested.store(true, std::memory_order_relaxed);
+}
+
+// Service side: web broadcasts, battery sampling, config persistence
+void serviceStep() {
+  // Forward status messages from the control task
+  StatusMessage message;
+  while (statusMessages.pop(message)) {
+    webServer.sendStatus(message.text);
+  }
+  
+  unsigned long currentTime = millis();
+  uint32_t stateGeneration;
+  const ControlState* state = controlState.acquire(stateGeneration);
+  
+  // Hand new control state to telemetry (HTTP polling reads the history)
+  if (stateGeneration != telemetryGeneration) {
+    if (state->mpuConnected) {
+      webServer.setSensorData(state->roll, state->pitch, state->yaw, state->verticalAccel, state->timestampUs);
+    } else {
+      // Send NaN values when sensor offline - dashboard will display '--'
+      webServer.setSensorData(NAN, NAN, NAN, NAN, state->timestampUs);
     }
-    
-    lastSimulationTime = currentTime;
+    telemetryGeneration = stateGeneration;
   }
   
   // Read battery voltages periodically
   if (currentTime - lastBatteryReadTime >= BATTERY_READ_INTERVAL) {
-    BatteriesConfig batteryConfig = storageManager.getBatteryConfig();
+    const BatteriesConfig* batteryConfig = storageManager.acquireBatteryConfig();
     
     // Read voltage for each configured battery
-    batteryVoltages[0] = readBatteryVoltage(batteryConfig.battery1.plugAssignment);
-    batteryVoltages[1] = readBatteryVoltage(batteryConfig.battery2.plugAssignment);
-    batteryVoltages[2] = readBatteryVoltage(batteryConfig.battery3.plugAssignment);
+    batteryVoltages[0] = readBatteryVoltage(batteryConfig->battery1.plugAssignment);
+    batteryVoltages[1] = readBatteryVoltage(batteryConfig->battery2.plugAssignment);
+    batteryVoltages[2] = readBatteryVoltage(batteryConfig->battery3.plugAssignment);
     
-    // Broadcast battery voltages to web clients
-    webServer.sendBatteryData(batteryVoltages[0], batteryVoltages[1], batteryVoltages[2]);
-    webServer.setBatteryData(batteryVoltages[0], batteryVoltages[1], batteryVoltages[2]); // Store for HTTP polling
+    // Store for telemetry, and for the history the control task records
+    webServer.setBatteryData(batteryVoltages[0], batteryVoltages[1], batteryVoltages[2]);
+    telemetryHistory.setBatteries(batteryVoltages[0], batteryVoltages[1], batteryVoltages[2]);
     
     lastBatteryReadTime = currentTime;
   }
   
+  // One telemetry frame per client at its own rate, carrying whatever
+  // changed since its last one (TelemetryPublisher.h)
+  webServer.serviceTelemetry(currentTime);
+  
+  // Let dashboards know when to refetch /api/config
+  webServer.serviceConfigVersion(currentTime);
+  
+  // Write config changes to flash once they settle
+  storageManager.saveIfDirty();
+  
+  // Report control loop timing
+  if (currentTime - lastStatsReportTime >= STATS_REPORT_INTERVAL) {
+    reportTimingStats(state->timing);
+    lastStatsReportTime = currentTime;
+  }
+}
+
+#if SUSPENSION_DUAL_CORE
+void controlTask(void* parameter) {
+  for (;;) {
+    controlStep();
+    
+    // Sleep through most of the wait; the last millisecond or two is polled
+    // so the tick starts close to its deadline despite the 1 ms RTOS tick
+    uint32_t waitUs = controlScheduler.microsUntilNext(micros());
+    if (waitUs >= 2000) {
+      vTaskDelay(pdMS_TO_TICKS(waitUs / 1000 - 1));
+    }
+  }
+}
+
+void serviceTask(void* parameter) {
+  for (;;) {
+    serviceStep();
+    vTaskDelay(pdMS_TO_TICKS(SERVICE_TASK_PERIOD_MS));
+  }
+}
+#endif
+
+// Main loop
+void loop() {
+#if SUSPENSION_DUAL_CORE
+  // All work happens in the pinned control and service tasks
+  vTaskDelete(nullptr);
+#else
+  imuAcquisition.service();
+  controlStep();
+  serviceStep();
   yield();
+#endif
 }